@@ -1,10 +1,18 @@
 @echo off
 echo Building Chess Project...
 
-g++ -std=c++17 -I "header_files" sourceCode\main.cc sourceCode\chessBoard.cc sourceCode\King.cc sourceCode\Knight.cc sourceCode\Bishop.cc sourceCode\Queen.cc sourceCode\Rook.cc sourceCode\Pawn.cc resources\appicon.o -o chess.exe -lsfml-graphics -lsfml-window -lsfml-system -lsfml-audio -mwindows
+:: add -DCHESS_TRACE to both lines to record trace zones, F12 in the game writes chess-trace.json
+g++ -std=c++17 -O2 -I "header_files" sourceCode\main.cc sourceCode\BoardArt.cc sourceCode\SoundCues.cc sourceCode\chessConsole.cc sourceCode\chessBoard.cc sourceCode\GameRules.cc sourceCode\King.cc sourceCode\Knight.cc sourceCode\Bishop.cc sourceCode\Queen.cc sourceCode\Rook.cc sourceCode\Pawn.cc sourceCode\Bitbase.cc sourceCode\Tablebase.cc sourceCode\Search.cc sourceCode\PositionCache.cc sourceCode\MappedFile.cc sourceCode\Nnue.cc sourceCode\MateSolver.cc sourceCode\AssetPack.cc sourceCode\Trace.cc resources\appicon.o -o chess.exe -lsfml-graphics -lsfml-window -lsfml-system -lsfml-audio -lsynchronization -mwindows
 
-if exist chess.exe (
-    echo Build successful! chess.exe created.
+:: pack the images, sounds and font into assets.pak, the game reads the loose files without it
+g++ -std=c++17 -O2 -I "header_files" tools\assetPack.cc sourceCode\AssetPack.cc sourceCode\MappedFile.cc -o assetPack.exe
+if exist assetPack.exe assetPack.exe -o assets.pak
+
+:: headless UCI engine, no SFML needed
+g++ -std=c++17 -O2 -I "header_files" sourceCode\uciMain.cc sourceCode\Uci.cc sourceCode\chessBoard.cc sourceCode\GameRules.cc sourceCode\King.cc sourceCode\Knight.cc sourceCode\Bishop.cc sourceCode\Queen.cc sourceCode\Rook.cc sourceCode\Pawn.cc sourceCode\Bitbase.cc sourceCode\Tablebase.cc sourceCode\Search.cc sourceCode\PositionCache.cc sourceCode\MappedFile.cc sourceCode\Nnue.cc sourceCode\MateSolver.cc sourceCode\Trace.cc -o chess-uci.exe
+
+if exist chess.exe if exist chess-uci.exe (
+    echo Build successful! chess.exe and chess-uci.exe created.
 ) else (
     echo Build failed. Check error messages above.
 )
@@ -0,0 +1,23 @@
+@echo off
+echo Building Chess tools...
+
+set CORE=sourceCode\chessBoard.cc sourceCode\GameRules.cc sourceCode\King.cc sourceCode\Knight.cc sourceCode\Bishop.cc sourceCode\Queen.cc sourceCode\Rook.cc sourceCode\Pawn.cc sourceCode\Bitbase.cc sourceCode\Tablebase.cc sourceCode\Search.cc sourceCode\PositionCache.cc sourceCode\MappedFile.cc sourceCode\Nnue.cc sourceCode\MateSolver.cc sourceCode\Trace.cc
+
+g++ -std=c++17 -O2 -I "header_files" tools\bitbaseGen.cc %CORE% -o bitbaseGen.exe
+g++ -std=c++17 -O2 -I "header_files" tools\tbprobe.cc %CORE% -o tbprobe.exe
+g++ -std=c++17 -O2 -I "header_files" tools\searchBench.cc %CORE% -o searchBench.exe
+g++ -std=c++17 -O2 -I "header_files" tools\perft.cc %CORE% -o perft.exe
+g++ -std=c++17 -O2 -I "header_files" tools\nnueBench.cc %CORE% -o nnueBench.exe
+g++ -std=c++17 -O2 -I "header_files" tools\mateFinder.cc %CORE% -o mateFinder.exe
+g++ -std=c++17 -O2 -I "header_files" tools\tournament.cc %CORE% -o tournament.exe
+g++ -std=c++17 -O2 -I "header_files" tools\epdSuite.cc %CORE% -o epdSuite.exe
+g++ -std=c++17 -O2 -I "header_files" tools\rulesBench.cc %CORE% -o rulesBench.exe
+g++ -std=c++17 -O2 -I "header_files" tools\dataGen.cc %CORE% sourceCode\TrainingData.cc -o dataGen.exe
+g++ -std=c++17 -O2 -I "header_files" tools\cacheBench.cc sourceCode\PositionCache.cc -o cacheBench.exe
+g++ -std=c++17 -O2 -I "header_files" tools\diagramRender.cc sourceCode\BoardArt.cc %CORE% -o diagramRender.exe -lsfml-graphics -lsfml-window -lsfml-system
+
+if exist bitbaseGen.exe if exist tbprobe.exe if exist searchBench.exe if exist perft.exe if exist cacheBench.exe if exist nnueBench.exe if exist mateFinder.exe if exist tournament.exe if exist dataGen.exe if exist epdSuite.exe if exist rulesBench.exe if exist diagramRender.exe (
+    echo Build successful! Tools created.
+    goto :eof
+)
+echo Build failed. Check error messages above.
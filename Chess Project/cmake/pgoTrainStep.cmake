@@ -0,0 +1,26 @@
+# runs one pgo-train command and stops the training with the command line and how it
+# ended when it fails, a crash included: a crashed training run leaves partial profiles
+# that the USE stage would otherwise quietly build with
+#
+#   cmake -P pgoTrainStep.cmake -- program [argument ...]
+set(command "")
+set(started FALSE)
+math(EXPR lastArgument "${CMAKE_ARGC} - 1")
+foreach(i RANGE 3 ${lastArgument})
+    if(started)
+        list(APPEND command "${CMAKE_ARGV${i}}")
+    elseif(CMAKE_ARGV${i} STREQUAL "--")
+        set(started TRUE)
+    endif()
+endforeach()
+if(NOT command)
+    message(FATAL_ERROR "usage: cmake -P pgoTrainStep.cmake -- program [argument ...]")
+endif()
+
+string(REPLACE ";" " " commandLine "${command}")
+message(STATUS "PGO training: ${commandLine}")
+execute_process(COMMAND ${command} RESULT_VARIABLE result)
+# the exit code, or a description such as "Segmentation fault" when it crashed
+if(NOT result STREQUAL "0")
+    message(FATAL_ERROR "PGO training command failed (${result}): ${commandLine}")
+endif()
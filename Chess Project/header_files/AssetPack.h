@@ -0,0 +1,45 @@
+#pragma once
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// the GUI's images, sounds and font in one file, opened with a single memory mapping so
+// that startup costs one open instead of a probe per asset. the files are stored as they
+// are (PNG, WAV, TTF), decoding them is up to the caller. tools/assetPack.cc writes it
+class assetPack
+{
+private:
+    struct entry
+    {
+        std::string name;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+    mappedFile mapping;
+    std::vector<entry> entries;
+
+public:
+    // false with a message on std::cerr when the file is missing or not a pack
+    bool open(const std::string &path);
+    void close();
+
+    bool isOpen() const
+    {
+        return mapping.isOpen();
+    }
+
+    size_t getEntryCount() const
+    {
+        return entries.size();
+    }
+
+    // the bytes of a packed file by its file name, e.g. "W_king.png". they stay valid
+    // until the pack is closed
+    bool find(const std::string &name, const uint8_t *&data, size_t &size) const;
+
+    // packs the files under their file names without the directory. false with a message
+    // on std::cerr when one can't be read or the pack can't be written
+    static bool write(const std::string &path, const std::vector<std::string> &files);
+};
@@ -0,0 +1,124 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Pieces.h"
+#include "MappedFile.h"
+
+class chessBoard;
+
+// game theoretical value from the point of view of the side to move
+enum class wdlResult
+{
+    LOSS,
+    DRAW,
+    WIN,
+    UNKNOWN
+};
+
+// small piece list used by the endgame bitbases
+// slot 0 is always the white king and slot 1 the black king
+// squares follow the chessBoard layout: row * 8 + column, row 0 is rank 8
+struct endgamePosition
+{
+    int count = 0;
+    std::array<int, 4> square{};
+    std::array<pieceType, 4> type{};
+    std::array<Color, 4> color{};
+    Color sideToMove = Color::WHITE;
+};
+
+// win/draw/loss table for one material signature such as "KPK" or "KBNK"
+// every entry takes 2 bits, positions are indexed after symmetry reduction:
+// pawnless tables keep the white king in the a1-d1-d4 triangle, tables with
+// pawns only mirror the white king onto files a-d
+class endgameBitbase
+{
+private:
+    std::string material;
+    uint64_t materialKey = 0;
+    std::vector<pieceType> pieceTypes; // non king pieces, white ones first
+    std::vector<Color> pieceColors;
+    bool hasPawns = false;
+    uint64_t entryCount = 0;
+    double generationSeconds = 0.0;
+
+    std::vector<uint8_t> ownedData;
+    mappedFile mapping;
+    const uint8_t *data = nullptr;
+
+    friend class bitbaseGenerator;
+    friend class bitbaseRegistry;
+
+public:
+    explicit endgameBitbase(const std::string &materialName);
+
+    const std::string &getMaterial() const
+    {
+        return material;
+    }
+    uint64_t getMaterialKey() const
+    {
+        return materialKey;
+    }
+    uint64_t getEntryCount() const
+    {
+        return entryCount;
+    }
+    bool getHasPawns() const
+    {
+        return hasPawns;
+    }
+    double getGenerationSeconds() const
+    {
+        return generationSeconds;
+    }
+    bool isLoaded() const
+    {
+        return data != nullptr;
+    }
+
+    // position must already be in the canonical form produced by canonicalize()
+    uint64_t indexOf(const endgamePosition &pos) const;
+    bool positionAt(uint64_t index, endgamePosition &pos) const;
+    void canonicalize(endgamePosition &pos) const;
+
+    wdlResult probeCanonical(const endgamePosition &pos) const;
+    void countResults(uint64_t &wins, uint64_t &draws, uint64_t &losses) const;
+
+    bool save(const std::string &path) const;
+    bool load(const std::string &path);
+};
+
+// owns every generated or loaded bitbase and answers probes for any position
+// whose material matches one of them (with colours swapped if needed)
+class bitbaseRegistry
+{
+private:
+    std::unordered_map<uint64_t, std::unique_ptr<endgameBitbase>> tables;
+    mutable std::shared_mutex tablesMutex;
+
+    bitbaseRegistry() = default;
+
+public:
+    static bitbaseRegistry &instance();
+
+    // normalizes a name like "KKP" into the stored orientation "KPK", empty if invalid
+    static std::string normalizeMaterial(const std::string &materialName);
+
+    // generates the table together with every smaller table it depends on
+    bool generate(const std::string &materialName, unsigned threadCount = 0);
+    bool load(const std::string &path);
+    bool loadDirectory(const std::string &directory);
+    bool saveAll(const std::string &directory) const;
+
+    const endgameBitbase *find(const std::string &materialName) const;
+    std::vector<std::string> loadedMaterials() const;
+
+    wdlResult probe(const endgamePosition &pos) const;
+    wdlResult probe(const chessBoard &board) const;
+};
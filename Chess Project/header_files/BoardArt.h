@@ -0,0 +1,42 @@
+#pragma once
+#include "chessBoard.h"
+#include <SFML/Graphics.hpp>
+
+// the piece atlas and the quads the board is drawn with, shared by the game and the
+// headless diagram renderer (tools/diagramRender.cc) so that both draw the same board.
+// quads are two triangles, 6 vertices, drawn with the atlas as texture
+class boardArt
+{
+private:
+    sf::Image atlasImage;
+
+public:
+    sf::Texture atlas;
+    sf::IntRect pieceRects[12];
+    sf::Vector2f solidTexel;
+    sf::Color lightSquare = sf::Color(238, 238, 210);
+    sf::Color darkSquare = sf::Color(118, 150, 86);
+
+    // packs the images, white king to pawn then black, one row per color, every cell the
+    // size of the largest image plus padding so that neighbours never bleed into each
+    // other, and a white block under the rows that solid quads sample
+    void compose(const sf::Image (&images)[12]);
+    // creates the texture from the composed image. a copy of a composed boardArt uploads
+    // its own, one per renderer thread. false with a message on std::cerr on failure
+    bool upload();
+
+    // texture coordinates that give a quad the plain vertex color
+    sf::FloatRect solid() const
+    {
+        return sf::FloatRect(solidTexel.x, solidTexel.y, 0.f, 0.f);
+    }
+
+    // the atlas index of the piece on a square (row * 8 + column), -1 when it is empty
+    static int pieceIndexAt(const chessBoard &board, int square);
+
+    static void writeQuad(sf::Vertex *quad, float x, float y, float width, float height, sf::Color color, sf::FloatRect texture);
+    // scaled to fit the square at (x, y) and centered in it, no size for -1
+    void writePieceQuad(sf::Vertex *quad, int pieceIndex, float x, float y, float squareSize, sf::Color color) const;
+    // the 64 squares then the 64 pieces of a position, 128 quads, a8 at (x, y)
+    void writePosition(sf::Vertex *vertices, const chessBoard &board, float x, float y, float squareSize) const;
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "chessBoard.h"
+
+// the initial position, for everything that starts a game without a FEN
+const char *const startPosition = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+enum class adjudication
+{
+    ONGOING,
+    CHECKMATE, // the side to move is mated
+    STALEMATE,
+    FIFTY_MOVES,
+    REPETITION,
+    MATERIAL // neither side can mate
+};
+
+// the positions of one game since its last capture or pawn move, which is all threefold
+// repetition needs. the same rules end a game in the tools, the server and the engine
+class gameHistory
+{
+private:
+    std::vector<uint64_t> keys;
+
+public:
+    // the game starts at board
+    void reset(const chessBoard &board);
+    // after every move made on board. positions before a capture or pawn move can never
+    // come back and are dropped
+    void record(const chessBoard &board);
+
+    const std::vector<uint64_t> &positionKeys() const
+    {
+        return keys;
+    }
+
+    // fills legal with the moves of the side to move, then checks for mate and stalemate,
+    // the fifty move rule, threefold repetition and insufficient material in that order
+    adjudication adjudicate(chessBoard &board, std::vector<chessMove> &legal) const;
+};
+
+// a side that the searches see lost by at least margin centipawns for plies plies in a row
+// resigns. the search scores for the side to move, so the sign flips every ply; the rule
+// counts in white's point of view
+class resignationRule
+{
+private:
+    int margin;
+    int plies;
+    int streak = 0;
+    int streakResult = 0;
+
+public:
+    resignationRule(int marginCentipawns, int pliesInARow) : margin(marginCentipawns), plies(pliesInARow) {}
+
+    void reset()
+    {
+        streak = 0;
+        streakResult = 0;
+    }
+
+    // after every search with its score for sideToMove. the result from white's point of
+    // view, 1 or -1, once the losing side resigns, 0 while the game goes on
+    int record(Color sideToMove, int score);
+};
+
+// xorshift64, the state must not be zero
+uint64_t nextRandom(uint64_t &state);
+
+// plays plies random legal moves on board so that games don't all repeat each other.
+// false when the line ended the game
+bool playRandomOpening(chessBoard &board, int plies, uint64_t &random);
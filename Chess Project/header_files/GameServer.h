@@ -0,0 +1,147 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "GameRules.h"
+#include "chessBoard.h"
+
+// binary protocol, little endian. every request and reply starts with a messageHeader and
+// is followed by length payload bytes:
+//   CREATE  payload: FEN or nothing for the start position        -> STATE with the new id
+//   MOVE    payload: uint16 chessMove data                         -> STATE
+//   STATUS  no payload                                             -> POSITION
+//   RESIGN  payload: uint8 color that resigns                      -> STATE
+//   CLOSE   no payload, the game is forgotten                      -> STATE
+// failures come back as ERROR with the reason in code
+enum messageType : uint8_t
+{
+    MESSAGE_CREATE = 1,
+    MESSAGE_MOVE = 2,
+    MESSAGE_STATUS = 3,
+    MESSAGE_RESIGN = 4,
+    MESSAGE_CLOSE = 5,
+    MESSAGE_STATE = 0x81,
+    MESSAGE_POSITION = 0x82,
+    MESSAGE_ERROR = 0xFF
+};
+
+enum messageError : uint8_t
+{
+    ERROR_NONE = 0,
+    ERROR_BAD_REQUEST = 1,
+    ERROR_UNKNOWN_GAME = 2,
+    ERROR_ILLEGAL_MOVE = 3,
+    ERROR_GAME_OVER = 4,
+    ERROR_TOO_MANY_GAMES = 5
+};
+
+enum gameOutcome : uint8_t
+{
+    OUTCOME_ONGOING = 0,
+    OUTCOME_WHITE_WINS = 1,
+    OUTCOME_BLACK_WINS = 2,
+    OUTCOME_DRAW = 3
+};
+
+enum gameEnding : uint8_t
+{
+    ENDING_NONE = 0,
+    ENDING_CHECKMATE = 1,
+    ENDING_STALEMATE = 2,
+    ENDING_FIFTY_MOVES = 3,
+    ENDING_REPETITION = 4,
+    ENDING_MATERIAL = 5,
+    ENDING_RESIGNATION = 6
+};
+
+#pragma pack(push, 1)
+struct messageHeader
+{
+    uint8_t type = 0;
+    uint8_t code = 0; // messageError in ERROR replies
+    uint16_t length = 0;
+    uint32_t gameId = 0;
+};
+
+// STATE payload, POSITION adds the FEN after it
+struct gameState
+{
+    uint8_t outcome = OUTCOME_ONGOING;
+    uint8_t ending = ENDING_NONE;
+    uint8_t sideToMove = 0; // 0 white, 1 black
+    uint8_t inCheck = 0;
+    uint16_t plies = 0;
+    uint16_t lastMove = 0;
+};
+#pragma pack(pop)
+static_assert(sizeof(messageHeader) == 8, "messageHeader is part of the wire format");
+static_assert(sizeof(gameState) == 8, "gameState is part of the wire format");
+
+// hosts any number of games for any number of clients on one epoll loop. games belong to the
+// server, not to a connection, so several clients (two bots and a referee) can share one game.
+//
+// linux only: the protocol handling is portable, the sockets use epoll and eventfd
+class gameServer
+{
+private:
+    struct hostedGame
+    {
+        chessBoard board;
+        gameState state;
+        gameHistory history;
+    };
+
+    struct connection
+    {
+        int socket = -1;
+        std::vector<uint8_t> input;
+        std::vector<uint8_t> output;
+        size_t outputSent = 0;
+        uint32_t events = 0; // what epoll watches, set by acceptClients
+        bool peerClosed = false; // no more requests, closed once the replies are out
+    };
+
+    std::unordered_map<uint32_t, std::unique_ptr<hostedGame>> games;
+    uint32_t nextGameId = 1;
+    size_t maxGames;
+    std::vector<chessMove> legalMoves;
+
+    int epollDescriptor = -1;
+    int wakeDescriptor = -1;
+    std::vector<int> listeners;
+    std::string unixPath;
+    std::unordered_map<int, std::unique_ptr<connection>> connections;
+
+    void updateState(hostedGame &game);
+    void appendReply(std::vector<uint8_t> &reply, uint8_t type, uint8_t code, uint32_t gameId, const void *payload, size_t length);
+    bool addListener(int socket);
+    void acceptClients(int listener);
+    void readClient(connection &client);
+    void writeClient(connection &client);
+    void closeClient(int socket);
+
+public:
+    explicit gameServer(size_t gameLimit = 100000);
+    ~gameServer();
+    gameServer(const gameServer &) = delete;
+    gameServer &operator=(const gameServer &) = delete;
+
+    // any number of listeners before run(), false with a message on std::cerr when one fails
+    bool listenUnix(const std::string &path);
+    // loopback only, the protocol has no authentication
+    bool listenTcp(uint16_t port);
+    // serves until stop()
+    void run();
+    // safe from other threads and signal handlers
+    void stop();
+
+    // handles one complete request and appends the reply, no sockets involved
+    void handleMessage(const messageHeader &header, const uint8_t *payload, std::vector<uint8_t> &reply);
+    size_t gameCount() const
+    {
+        return games.size();
+    }
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// read only memory mapping of a whole file
+// used for the endgame tables so that only the pages we touch become resident
+class mappedFile
+{
+private:
+    const uint8_t *view = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+
+public:
+    mappedFile() = default;
+    ~mappedFile();
+    mappedFile(const mappedFile &) = delete;
+    mappedFile &operator=(const mappedFile &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+
+    bool isOpen() const
+    {
+        return view != nullptr;
+    }
+
+    const uint8_t *data() const
+    {
+        return view;
+    }
+
+    size_t size() const
+    {
+        return length;
+    }
+};
@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "chessBoard.h"
+#include "PositionCache.h"
+
+enum class mateStatus
+{
+    PROVEN,    // the side to move mates within mateIn moves
+    DISPROVEN, // no mate within the move limit, whatever the attacker plays
+    UNKNOWN    // node or time limit reached first
+};
+
+struct mateLimits
+{
+    int maxMoves = 5;      // moves of the side to move, mate in 1 .. maxMoves
+    uint64_t maxNodes = 0; // 0 means no node limit
+    int timeMs = 0;        // 0 means no time limit
+};
+
+struct mateResult
+{
+    mateStatus status = mateStatus::UNKNOWN;
+    int mateIn = 0; // shortest mate when proven, the move count being tried otherwise
+    std::vector<chessMove> line;
+    uint64_t nodes = 0;
+    double seconds = 0.0;
+};
+
+// depth-first proof-number search for forced mates by the side to move
+// a node is proven when the attacker can force mate from it and disproven when it can't;
+// proof and disproof numbers (how many leaves still have to be settled) steer the search
+// to the most promising line. "mate in n" is searched for n = 1 .. maxMoves so the first
+// proof is the shortest one, and because the moves left are part of every node no line
+// can repeat. all numbers live in a fixed size positionCache, so memory stays bounded:
+// once it is full the cheapest subtrees are forgotten and re-searched when needed
+// with more than one thread every thread works from the root, a shared busy counter
+// steers them into different children
+class mateSolver
+{
+private:
+    struct threadContext
+    {
+        int id = 0;
+        uint64_t nodes = 0;
+        std::atomic<uint64_t> publishedNodes{0};
+    };
+
+    positionCache table;
+    std::vector<std::unique_ptr<threadContext>> threads;
+    std::unique_ptr<std::atomic<uint8_t>[]> busy;
+
+    std::atomic<bool> stopRequested{false};
+    std::atomic<bool> rootSolved{false};
+    uint64_t nodeLimit = 0;
+    std::chrono::steady_clock::time_point deadline;
+    bool hasDeadline = false;
+
+    mateStatus solveFixed(chessBoard &board, int movesLeft);
+    void search(threadContext &thread, chessBoard &board, uint64_t key, bool orNode, int movesLeft,
+                uint32_t phiThreshold, uint32_t deltaThreshold, uint32_t &proof, uint32_t &disproof);
+    bool lookup(uint64_t key, uint32_t &proof, uint32_t &disproof) const;
+    int lookupWork(uint64_t key) const;
+    void store(uint64_t key, uint32_t proof, uint32_t disproof, uint64_t work);
+    void extractLine(chessBoard &board, int movesLeft, std::vector<chessMove> &line) const;
+    bool shouldStop(threadContext &thread);
+    uint64_t totalNodes() const;
+
+public:
+    explicit mateSolver(size_t hashMegabytes = 64, int threadCount = 1);
+
+    // blocks until the position is solved or a limit is reached, the board is left as it was
+    mateResult solve(chessBoard &board, const mateLimits &limits);
+    void stop()
+    {
+        stopRequested.store(true, std::memory_order_relaxed);
+    }
+    // only while no solve is running
+    void setThreads(int threadCount);
+    void setHashSize(size_t megabytes)
+    {
+        table.resize(megabytes);
+    }
+    uint64_t getNodes() const
+    {
+        return totalNodes();
+    }
+};
+
+// runs a mateSolver on its own thread, the same way searchWorker runs the search
+class mateWorker
+{
+private:
+    mateSolver solver;
+    std::thread thread;
+    std::atomic<bool> busy{false};
+    std::mutex resultMutex;
+    bool resultReady = false;
+    mateResult result;
+    std::chrono::steady_clock::time_point startTime;
+
+public:
+    ~mateWorker();
+
+    void setThreads(int threadCount)
+    {
+        solver.setThreads(threadCount);
+    }
+
+    bool start(const std::string &fen, const mateLimits &limits);
+    void cancel();
+
+    bool isBusy() const
+    {
+        return busy.load(std::memory_order_acquire);
+    }
+    bool takeResult(mateResult &out);
+
+    uint64_t getNodes() const
+    {
+        return solver.getNodes();
+    }
+    double getElapsedSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// efficiently updatable neural network evaluation
+// 768 inputs per perspective (colour x piece type x square, seen from that side),
+// one int16 hidden layer of nnueHiddenSize neurons per perspective, clipped to 0..127,
+// and an int8 output layer over both halves with the side to move first
+const int nnueInputSize = 768;
+const int nnueHiddenSize = 256;
+
+// hidden layer sums for both perspectives (0 = white, 1 = black)
+struct alignas(64) nnueAccumulator
+{
+    int16_t values[2][nnueHiddenSize];
+};
+
+enum class nnueKernel
+{
+    SCALAR,
+    SSE41,
+    AVX2
+};
+
+class nnueNetwork
+{
+private:
+    std::vector<int16_t> featureBias;    // nnueHiddenSize
+    std::vector<int16_t> featureWeights; // nnueInputSize columns of nnueHiddenSize
+    std::vector<int8_t> outputWeights;   // 2 * nnueHiddenSize
+    int32_t outputBias = 0;
+    int32_t outputDivisor = 1;
+    nnueKernel kernel = nnueKernel::SCALAR;
+    bool loaded = false;
+
+    void (*addColumn)(int16_t *values, const int16_t *column) = nullptr;
+    void (*subtractColumn)(int16_t *values, const int16_t *column) = nullptr;
+    int32_t (*clippedDot)(const int16_t *values, const int8_t *weights) = nullptr;
+
+public:
+    nnueNetwork();
+
+    // file: "CNN1", uint32 hidden size, int16 biases, int16 weights, int8 output
+    // weights, int32 output bias, int32 output divisor, all little endian
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+    // random weights of a realistic size, for benchmarks and tests only
+    void randomize(uint64_t seed);
+    bool isLoaded() const
+    {
+        return loaded;
+    }
+
+    // the fastest kernel the CPU supports is picked on construction
+    static bool isKernelSupported(nnueKernel kernel);
+    static const char *kernelName(nnueKernel kernel);
+    bool selectKernel(nnueKernel kernel);
+    nnueKernel getKernel() const
+    {
+        return kernel;
+    }
+
+    // feature for a piece (colour 0 white, type as pieceType, square as row * 8 + column)
+    static int featureIndex(int perspective, int color, int type, int square)
+    {
+        int relativeColor = color ^ perspective;
+        int relativeSquare = perspective == 0 ? square : square ^ 56;
+        return relativeColor * 384 + type * 64 + relativeSquare;
+    }
+
+    void resetAccumulator(nnueAccumulator &accumulator) const;
+    void addFeature(nnueAccumulator &accumulator, int perspective, int feature) const
+    {
+        addColumn(accumulator.values[perspective], &featureWeights[size_t(feature) * nnueHiddenSize]);
+    }
+    void removeFeature(nnueAccumulator &accumulator, int perspective, int feature) const
+    {
+        subtractColumn(accumulator.values[perspective], &featureWeights[size_t(feature) * nnueHiddenSize]);
+    }
+
+    // centipawns for the side to move
+    int evaluate(const nnueAccumulator &accumulator, int sideToMove) const;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// fixed size hash table keyed by chessBoard::positionKey(), shared by any number of
+// threads without locks. every bucket is one 64 byte cache line holding four entries;
+// an entry stores key ^ data next to data so a read that races with a write fails
+// the key check instead of returning a mix of two positions
+//
+// the 64 bit data word is split into a 48 bit payload owned by the caller, an 8 bit
+// priority (search depth, perft depth, ...) and the 8 bit generation it was written in.
+// when a bucket is full the entry with the lowest priority, made older by every
+// generation it has missed, is replaced
+class positionCache
+{
+public:
+    static const int payloadBits = 48;
+    static const uint64_t payloadMask = (uint64_t(1) << payloadBits) - 1;
+    static const int entriesPerBucket = 4;
+
+private:
+    struct entry
+    {
+        std::atomic<uint64_t> keyXorData;
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) bucket
+    {
+        entry entries[entriesPerBucket];
+    };
+
+    bucket *buckets = nullptr;
+    uint64_t bucketMask = 0;
+    size_t allocatedBytes = 0;
+    bool hugePages = false;
+    uint8_t generation = 1;
+
+    void release();
+
+public:
+    explicit positionCache(size_t megabytes = 16, bool useHugePages = false);
+    ~positionCache();
+    positionCache(const positionCache &) = delete;
+    positionCache &operator=(const positionCache &) = delete;
+
+    // rounds down to a power of two number of buckets, false when the memory is not available
+    bool resize(size_t megabytes, bool useHugePages = false);
+    void clear();
+    // called once per search (or game move), lets stale entries age out
+    void newGeneration()
+    {
+        // generation 0 is never used so that a written entry is never all zero
+        generation = static_cast<uint8_t>(generation == 255 ? 1 : generation + 1);
+    }
+
+    // starts loading the bucket for key so a probe a little later finds it in cache
+    void prefetch(uint64_t key) const
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&buckets[key & bucketMask]);
+#else
+        (void)key;
+#endif
+    }
+
+    bool probe(uint64_t key, uint64_t &payload, int &priority) const;
+    void store(uint64_t key, uint64_t payload, int priority);
+
+    size_t bucketCount() const
+    {
+        return static_cast<size_t>(bucketMask + 1);
+    }
+    size_t sizeInBytes() const
+    {
+        return allocatedBytes;
+    }
+    bool usesHugePages() const
+    {
+        return hugePages;
+    }
+    // permille of sampled entries written in the current generation
+    int hashfull() const;
+};
@@ -0,0 +1,253 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "chessBoard.h"
+#include "PositionCache.h"
+
+// scores are in centipawns from the side to move, mates count down from mateScore
+const int mateScore = 32000;
+const int mateBound = mateScore - 256;
+const int infiniteScore = 32767;
+const int maxSearchPly = 128;
+// a won ending from the endgame tables, below every mate so that a mate the search can see
+// still comes first
+const int tablebaseWinScore = mateBound - maxSearchPly - 1;
+
+struct searchLimits
+{
+    int maxDepth = 64;
+    int moveTimeMs = 0;    // 0 means no time limit
+    uint64_t maxNodes = 0; // 0 means no node limit
+    int multiPV = 1;       // lines reported, each searched without the first moves of the lines before it
+};
+
+struct searchLine
+{
+    int score = 0;
+    std::vector<chessMove> moves;
+};
+
+struct searchResult
+{
+    chessMove bestMove;
+    int score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    double seconds = 0.0;
+    std::vector<chessMove> principalVariation;
+    // the best line first, then up to multiPV - 1 alternatives from the same depth
+    std::vector<searchLine> lines;
+
+    uint64_t nodesPerSecond() const
+    {
+        return seconds > 0.0 ? static_cast<uint64_t>(nodes / seconds) : 0;
+    }
+};
+
+// search results kept in a positionCache: move, score and bound in the payload,
+// the depth as the replacement priority
+class transpositionTable
+{
+public:
+    enum boundType : uint8_t
+    {
+        BOUND_NONE,
+        BOUND_UPPER,
+        BOUND_LOWER,
+        BOUND_EXACT
+    };
+
+    struct entry
+    {
+        uint16_t move = 0;
+        int16_t score = 0;
+        int8_t depth = 0;
+        uint8_t bound = BOUND_NONE;
+    };
+
+private:
+    positionCache cache;
+
+public:
+    explicit transpositionTable(size_t megabytes = 16) : cache(megabytes) {}
+    void resize(size_t megabytes)
+    {
+        cache.resize(megabytes);
+    }
+    void clear()
+    {
+        cache.clear();
+    }
+    void newSearch()
+    {
+        cache.newGeneration();
+    }
+    void prefetch(uint64_t key) const
+    {
+        cache.prefetch(key);
+    }
+    int hashfull() const
+    {
+        return cache.hashfull();
+    }
+
+    bool probe(uint64_t key, entry &out) const;
+    void store(uint64_t key, chessMove move, int score, int depth, boundType bound);
+};
+
+// iterative deepening alpha-beta with quiescence search
+// with more than one thread it runs Lazy SMP: helper threads search the same root
+// with their own move ordering statistics and only share the transposition table
+// think() blocks, stop() may be called from any other thread
+class chessSearch
+{
+private:
+    // everything a search thread keeps to itself
+    struct threadState
+    {
+        int id = 0;
+        chessMove killers[maxSearchPly][2];
+        int history[2][64][64];
+        std::vector<uint64_t> pathKeys;
+        std::vector<chessMove> excludedRootMoves;
+        uint64_t nodes = 0;
+        std::atomic<uint64_t> publishedNodes{0};
+    };
+
+    transpositionTable table;
+    std::vector<std::unique_ptr<threadState>> threads;
+
+    std::atomic<bool> stopRequested{false};
+    std::atomic<int> sharedDepth{0};
+    uint64_t nodeLimit = 0;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point deadline;
+    bool hasDeadline = false;
+    std::function<void(const searchResult &)> iterationCallback;
+
+    // endgame tables, set up by think() for the whole search: the most pieces any loaded
+    // Syzygy table or bitbase covers, whether to probe below the root, and the root moves
+    // the tables say give the result away
+    int endgamePieces = 0;
+    bool probeEndgames = false;
+    std::vector<chessMove> tablebaseLosingMoves;
+
+    void iterate(threadState &thread, chessBoard &board, const searchLimits &limits, searchResult *result);
+    void searchMultiPV(threadState &thread, chessBoard &board, int depth, int multiPV, int bestScore, searchResult *result);
+    int negamax(threadState &thread, chessBoard &board, int depth, int ply, int alpha, int beta, std::vector<chessMove> &pv);
+    int quiescence(threadState &thread, chessBoard &board, int ply, int alpha, int beta);
+    void orderMoves(const threadState &thread, const chessBoard &board, std::vector<chessMove> &moves, chessMove hashMove, int ply) const;
+    bool probeRootTables(chessBoard &board, const std::vector<chessMove> &rootMoves, searchResult &result);
+    bool shouldStop(threadState &thread);
+    uint64_t totalNodes() const;
+
+public:
+    explicit chessSearch(size_t hashMegabytes = 16, int threadCount = 1);
+
+    // gameKeys are the positions of the game since its last capture or pawn move, oldest
+    // first, with or without the root at the end. the search scores a return to any of
+    // them as a draw, like a repetition inside the tree
+    searchResult think(chessBoard &board, const searchLimits &limits, const std::vector<uint64_t> &gameKeys = {});
+    void stop()
+    {
+        stopRequested.store(true, std::memory_order_relaxed);
+    }
+    // forgets the hash and move ordering statistics, for a new game
+    void clear();
+    // only while no search is running
+    void setThreads(int threadCount);
+    int getThreads() const
+    {
+        return static_cast<int>(threads.size());
+    }
+    void setHashSize(size_t megabytes)
+    {
+        table.resize(megabytes);
+    }
+    // called on the searching thread after every completed depth, for UCI "info" lines
+    void setIterationCallback(std::function<void(const searchResult &)> callback)
+    {
+        iterationCallback = std::move(callback);
+    }
+
+    // live progress of the running search, safe to read from other threads
+    uint64_t getNodes() const
+    {
+        return totalNodes();
+    }
+    int getCompletedDepth() const
+    {
+        return sharedDepth.load(std::memory_order_relaxed);
+    }
+
+    // static evaluation from the point of view of the side to move
+    static int evaluate(const chessBoard &board);
+};
+
+// runs a chessSearch on its own thread so the caller (the SFML loop) never waits for it
+class searchWorker
+{
+private:
+    chessSearch search;
+    std::thread thread;
+    std::atomic<bool> busy{false};
+    std::mutex resultMutex;
+    bool resultReady = false;
+    searchResult result;
+    bool iterationReady = false;
+    searchResult iteration;
+    std::chrono::steady_clock::time_point startTime;
+    const nnueNetwork *network = nullptr;
+
+public:
+    searchWorker();
+    ~searchWorker();
+
+    // evaluate with this network instead of the built in tables, nullptr to go back
+    // the network must outlive every search started afterwards
+    void setNetwork(const nnueNetwork *net)
+    {
+        network = net;
+    }
+
+    // only while no search is running
+    void setThreads(int threadCount)
+    {
+        search.setThreads(threadCount);
+    }
+
+    // the position is copied through its FEN, the caller may keep changing its board
+    bool start(const std::string &fen, const searchLimits &limits);
+    // stops the search, waits for the thread and throws the result away
+    void cancel();
+    void newGame();
+
+    bool isBusy() const
+    {
+        return busy.load(std::memory_order_acquire);
+    }
+    // true once, when a finished search has a result waiting
+    bool takeResult(searchResult &out);
+    // true once per completed depth of the running search, for live analysis
+    bool takeIteration(searchResult &out);
+
+    uint64_t getNodes() const
+    {
+        return search.getNodes();
+    }
+    int getCompletedDepth() const
+    {
+        return search.getCompletedDepth();
+    }
+    double getElapsedSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+};
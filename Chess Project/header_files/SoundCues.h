@@ -0,0 +1,97 @@
+#pragma once
+#include <SFML/Audio.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+enum class soundCue {MOVE, CAPTURE, CHECK, CHECKMATE};
+
+// the move, capture, check and mate sounds. every cue has a few voices on one buffer,
+// played round robin so that a cue fired again while it is still sounding takes the
+// voice that started longest ago instead of cutting off the latest one. the game thread
+// only writes cues into a ring, an audio thread plays them, so a move never waits on
+// OpenAL
+class soundCues
+{
+private:
+    static const int cueCount = 4;
+    static const int voicesPerCue = 4;
+    // a power of two. dozens of moves a second fill a few slots, a full ring drops the cue
+    static const size_t ringSize = 64;
+
+    struct request
+    {
+        soundCue cue = soundCue::MOVE;
+        int64_t triggerMicroseconds = 0;
+    };
+
+    sf::SoundBuffer buffers[cueCount];
+    sf::Sound voices[cueCount][voicesPerCue];
+    bool loaded[cueCount] = {};
+    // audio thread only
+    int nextVoice[cueCount] = {};
+
+    // single producer (play), single consumer (the audio thread)
+    request ring[ringSize];
+    std::atomic<size_t> ringHead{0};
+    std::atomic<size_t> ringTail{0};
+    // the audio thread sleeps on wakeCount (a futex, WaitOnAddress on Windows) and play
+    // bumps it when sleeping is set, neither side takes a lock
+    std::atomic<bool> sleeping{false};
+    std::atomic<bool> stopping{false};
+    std::atomic<uint32_t> wakeCount{0};
+    std::thread worker;
+
+    std::atomic<uint64_t> playedCount{0};
+    std::atomic<uint64_t> stolenCount{0};
+    std::atomic<uint64_t> droppedCount{0};
+    std::atomic<int64_t> totalLatencyMicroseconds{0};
+    std::atomic<int64_t> maxLatencyMicroseconds{0};
+
+    static int64_t nowMicroseconds();
+    void audioLoop();
+    void playQueued();
+
+public:
+    soundCues() = default;
+    soundCues(const soundCues &) = delete;
+    soundCues &operator=(const soundCues &) = delete;
+    ~soundCues();
+
+    // creates the cue's buffer from decoded samples and points its voices at it. call it
+    // for every cue before start, false when there are no samples or OpenAL refuses them
+    bool load(soundCue cue, const sf::Int16 *samples, size_t sampleCount, unsigned channels, unsigned sampleRate, float volume);
+
+    bool isLoaded(soundCue cue) const
+    {
+        return loaded[static_cast<int>(cue)];
+    }
+
+    // starts the audio thread, the voices belong to it from here on
+    void start();
+    void stop();
+
+    // queues the cue and returns, without waiting on the audio thread or OpenAL. a cue
+    // that isn't loaded is ignored
+    void play(soundCue cue);
+
+    // from play to the voice being started, not counting the audio device's own buffering
+    float averageLatencyMs() const;
+    float maxLatencyMs() const;
+
+    uint64_t getPlayedCount() const
+    {
+        return playedCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getStolenCount() const
+    {
+        return stolenCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getDroppedCount() const
+    {
+        return droppedCount.load(std::memory_order_relaxed);
+    }
+};
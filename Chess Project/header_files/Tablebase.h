@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "chessBoard.h"
+
+// Syzygy win/draw/loss values, cursed wins and blessed losses are the results
+// that the fifty move rule turns into draws
+enum syzygyWDL
+{
+    WDL_LOSS = -2,
+    WDL_BLESSED_LOSS = -1,
+    WDL_DRAW = 0,
+    WDL_CURSED_WIN = 1,
+    WDL_WIN = 2
+};
+
+class syzygyTable;
+
+// probes Syzygy WDL (.rtbw) and DTZ (.rtbz) files found in a local directory
+// init() only reads the directory listing, every file is memory mapped the first
+// time a position needs it. probes are safe from several threads at once as long
+// as each thread passes its own board
+class syzygyTablebases
+{
+private:
+    enum probeState
+    {
+        PROBE_FAIL,
+        PROBE_OK,
+        PROBE_CHANGE_STM,
+        PROBE_ZEROING_BEST_MOVE
+    };
+
+    std::vector<std::unique_ptr<syzygyTable>> tables;
+    std::unordered_map<uint64_t, syzygyTable *> wdlByKey;
+    std::unordered_map<uint64_t, syzygyTable *> dtzByKey;
+    int largestTable = 0;
+
+    syzygyTablebases();
+
+    bool mapTable(syzygyTable &table);
+    int probeTable(chessBoard &board, syzygyTable *table, int wdl, probeState &state);
+    int search(chessBoard &board, bool checkZeroingMoves, probeState &state);
+    int probeDTZInternal(chessBoard &board, probeState &state);
+
+public:
+    ~syzygyTablebases();
+    static syzygyTablebases &instance();
+
+    // scans the directory for table files, returns the number of WDL tables found
+    // must not run while other threads are probing
+    int init(const std::string &directory);
+    int maxPieces() const
+    {
+        return largestTable;
+    }
+
+    // wdl and dtz are from the point of view of the side to move, dtz counts plies
+    // both fail when the position has castling rights or no table covers it
+    bool probeWDL(chessBoard &board, int &wdl);
+    bool probeDTZ(chessBoard &board, int &dtz);
+
+    // picks the move that keeps the best result and reaches the next zeroing move fastest
+    bool probeRoot(chessBoard &board, chessMove &bestMove, int &wdl, int &dtz);
+
+    // runs every placement of the leading pieces of a pawnless table through the index and
+    // checks it against the table size, needs no files. false with the counts on std::cerr
+    bool checkIndexing() const;
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// scoped timing zones written as a Chrome trace (chrome://tracing or ui.perfetto.dev).
+// everything here is compiled out unless the whole build defines CHESS_TRACE, so the
+// zones can stay in hot code:
+//
+//   void chessBoard::isCheckmate(...)
+//   {
+//       TRACE_ZONE("chessBoard::isCheckmate");
+//
+// every thread records into its own buffer, only that thread writes to it so the lock
+// inside is never contended. a buffer keeps the latest traceBufferEvents zones, older
+// ones are overwritten. buffers outlive their threads so search helpers that already
+// finished still show up in the dump
+#ifdef CHESS_TRACE
+
+static const size_t traceBufferEvents = 1 << 18;
+
+// names must be string literals, only the pointer is stored
+class traceZone
+{
+private:
+    const char *name;
+    uint64_t start;
+
+public:
+    explicit traceZone(const char *zoneName);
+    ~traceZone();
+    traceZone(const traceZone &) = delete;
+    traceZone &operator=(const traceZone &) = delete;
+};
+
+// label for the calling thread's row in the viewer
+void traceThreadName(const char *name);
+// writes what every thread has recorded so far, recording carries on.
+// false with a message on std::cerr when the file can't be written
+bool traceDump(const std::string &path);
+
+#define TRACE_JOIN_INNER(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN_INNER(a, b)
+#define TRACE_ZONE(name) traceZone TRACE_JOIN(traceZoneAt, __LINE__)(name)
+#define TRACE_THREAD(name) traceThreadName(name)
+#define TRACE_DUMP(path) traceDump(path)
+
+#else
+
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_THREAD(name) ((void)0)
+#define TRACE_DUMP(path) ((void)0)
+
+#endif
@@ -0,0 +1,88 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "chessBoard.h"
+
+// one training position in 32 bytes: the occupied squares as a bitboard (bit row * 8 + column)
+// followed by a 4 bit code per piece in square order, then the state FEN needs and the labels
+struct packedSample
+{
+    uint64_t occupancy = 0;
+    uint8_t pieces[16] = {}; // color * 6 + type, low nibble first
+    uint8_t flags = 0;       // bit 0 black to move, bits 1-4 castling rights KQkq
+    uint8_t enPassant = 64;  // row * 8 + column of the target square, 64 when there is none
+    uint8_t halfmoveClock = 0;
+    int8_t result = 0;  // game result for the side to move: 1 win, 0 draw, -1 loss
+    int16_t score = 0;  // search score in centipawns for the side to move
+    uint16_t move = 0;  // chessMove data of the move played
+};
+static_assert(sizeof(packedSample) == 32, "packedSample must stay 32 bytes");
+
+// false when the position can't be packed (more than 32 pieces)
+bool packSample(const chessBoard &board, int score, chessMove move, packedSample &sample);
+// the position of a sample as FEN, the fullmove number is not stored and comes back as 1
+std::string sampleToFEN(const packedSample &sample);
+
+// block compression for sample files: LZ77 with 64 KiB offsets in the LZ4 token layout,
+// fast enough to keep up with the generator on a single writer thread
+void compressBlock(const uint8_t *input, size_t size, std::vector<uint8_t> &output);
+bool decompressBlock(const uint8_t *input, size_t size, uint8_t *output, size_t outputSize);
+
+// sample file: "CTD1", then blocks of { uint32 sample count, uint32 stored bytes, uint32 flags, data }
+// where flag 1 marks a compressed block. write() only copies into the block being filled,
+// full blocks are compressed and written by a background thread
+class sampleWriter
+{
+private:
+    std::ofstream out;
+    bool compress = false;
+    size_t blockSamples = 0;
+    std::vector<packedSample> filling;
+    std::deque<std::vector<packedSample>> pending;
+    std::mutex mutex;
+    std::condition_variable hasWork;
+    std::condition_variable hasSpace;
+    std::thread writerThread;
+    bool closing = false;
+    bool failed = false;
+    uint64_t samples = 0;
+    uint64_t bytes = 0;
+
+    static const size_t maxPendingBlocks = 4;
+    void writerLoop();
+    bool writeBlock(const std::vector<packedSample> &block);
+
+public:
+    sampleWriter() = default;
+    ~sampleWriter();
+    sampleWriter(const sampleWriter &) = delete;
+    sampleWriter &operator=(const sampleWriter &) = delete;
+
+    bool open(const std::string &path, bool compressBlocks, size_t samplesPerBlock = 16384);
+    // safe to call from several threads, blocks only while the writer is behind
+    void write(const packedSample *data, size_t count);
+    // flushes the last partial block; false if anything failed to write
+    bool close();
+
+    uint64_t samplesWritten();
+    uint64_t bytesWritten();
+};
+
+class sampleReader
+{
+private:
+    std::ifstream in;
+    std::vector<uint8_t> stored;
+
+public:
+    bool open(const std::string &path);
+    // the next block of samples, false at the end of the file or on a damaged block
+    bool readBlock(std::vector<packedSample> &block);
+};
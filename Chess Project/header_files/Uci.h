@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "GameRules.h"
+#include "Nnue.h"
+#include "Search.h"
+
+// Universal Chess Interface front end for chessSearch: reads commands from one stream and
+// answers on another, so tournament managers can run the engine without any SFML
+// supported: uci, isready, setoption (Hash, Threads, MultiPV, EvalFile, BitbasePath, SyzygyPath),
+// ucinewgame, position startpos|fen ... [moves ...],
+// go [depth|movetime|nodes|wtime|btime|winc|binc|movestogo|infinite|ponder], stop, ponderhit,
+// bench [depth], quit
+//
+// after go infinite and go ponder bestmove waits for stop (or ponderhit) even when the
+// search ends on its own. ponderhit starts the clock go ponder was given
+class uciEngine
+{
+private:
+    std::istream &input;
+    std::ostream &output;
+    std::mutex outputMutex;
+
+    chessSearch search;
+    std::unique_ptr<chessBoard> board;
+    gameHistory history; // of board, the search sees repetitions of the game's positions
+    std::unique_ptr<chessBoard> searchBoard;
+    std::unique_ptr<nnueNetwork> network;
+    std::thread searchThread;
+    std::atomic<bool> searching{false};
+    int multiPV = 1;
+
+    // go infinite and go ponder hold the search's bestmove back until stop or ponderhit
+    std::mutex holdMutex;
+    std::condition_variable holdChanged;
+    bool holdBestMove = false;
+    bool pondering = false;
+    int ponderTimeMs = 0; // what the clock allows once ponderhit arrives, 0 for no limit
+    std::thread ponderTimer;
+
+    void send(const std::string &line);
+    void waitForSearch();
+    void stopSearch();
+    void releaseBestMove();
+    void handlePonderHit();
+    void handlePosition(std::istringstream &args);
+    void handleGo(std::istringstream &args);
+    void handleSetOption(std::istringstream &args);
+
+public:
+    uciEngine(std::istream &in, std::ostream &out);
+    ~uciEngine();
+
+    // processes commands until "quit" or the end of the input
+    void run();
+    // false once "quit" was handled
+    bool handleCommand(const std::string &line);
+
+    // fixed positions searched to a fixed depth with one thread and a cleared hash,
+    // so the node count only changes when the search itself does; returns the nodes
+    static uint64_t bench(int depth, std::ostream &out);
+};
@@ -1,9 +1,13 @@
 #pragma once
 #include <array>
+#include <cstdint>
 #include <vector>
 #include <memory>
+#include <string>
 #include "Pieces.h"
 #include "Rook.h"
+#include "Bitbase.h"
+#include "Nnue.h"
 
 struct position
 {
@@ -11,6 +15,56 @@ struct position
     int column;
 };
 
+// compact move used by the engine side of the code
+// bits 0-5 hold the start square, bits 6-11 the end square (row * 8 + column)
+// and bits 12-14 the promotion piece type (0 when the move is not a promotion)
+struct chessMove
+{
+    uint16_t data = 0;
+
+    chessMove() = default;
+    chessMove(int fromRow, int fromColumn, int toRow, int toColumn, pieceType promotion = pieceType::KING)
+        : data(static_cast<uint16_t>((fromRow * 8 + fromColumn) | ((toRow * 8 + toColumn) << 6) |
+                                     ((promotion == pieceType::KING ? 0 : static_cast<int>(promotion)) << 12))) {}
+
+    int fromRow() const { return (data & 63) / 8; }
+    int fromColumn() const { return (data & 63) % 8; }
+    int toRow() const { return ((data >> 6) & 63) / 8; }
+    int toColumn() const { return ((data >> 6) & 63) % 8; }
+    bool isPromotion() const { return (data >> 12) != 0; }
+    pieceType promotion() const { return isPromotion() ? static_cast<pieceType>(data >> 12) : pieceType::KING; }
+    bool isNull() const { return data == 0; }
+    bool operator==(const chessMove &other) const { return data == other.data; }
+    bool operator!=(const chessMove &other) const { return data != other.data; }
+
+    // coordinate notation as used by UCI, e.g. e2e4 or e7e8q
+    std::string toString() const
+    {
+        static const char promotionLetters[] = "kqrbnp";
+        std::string text = {static_cast<char>('a' + fromColumn()), static_cast<char>('8' - fromRow()),
+                            static_cast<char>('a' + toColumn()), static_cast<char>('8' - toRow())};
+        if (isPromotion())
+        {
+            text += promotionLetters[static_cast<int>(promotion())];
+        }
+        return text;
+    }
+};
+
+// everything makeMove changes that unmakeMove can't work out on its own
+struct moveUndo
+{
+    std::unique_ptr<Piece> captured;
+    int capturedRow = -1;
+    int capturedColumn = -1;
+    std::unique_ptr<Piece> promotedPawn;
+    bool moverHadMoved = false;
+    bool rookHadMoved = false;
+    int previousEnPassantRow = -1;
+    int previousEnPassantColumn = -1;
+    int previousHalfmoveClock = 0;
+};
+
 class chessBoard
 {
 private:
@@ -22,6 +76,26 @@ private:
     bool isCastlingValid(int kingXPos, int kingYPos, int rookXPos, int rookYPos, Color color);
     bool isPathClear(int startX, int startY, int endX, int endY) const;
     void pawnPromotion(int x, int y);
+    void addPawnMoves(int row, int col, Color color, std::vector<chessMove> &moves) const;
+    void addCastlingMoves(Color color, std::vector<chessMove> &moves) const;
+    bool applyPlayerMove(int startX, int startY, int endX, int endY, pieceType promotion);
+    static void (*messageHandler)(const std::string &message);
+    static pieceType (*promotionHandler)(Color color);
+
+    // network accumulators, kept in step with every piece that moves once a network is attached
+    struct squareChange
+    {
+        int row;
+        int column;
+        int before;
+    };
+    static const int maxSquareChanges = 4;
+    const nnueNetwork *network = nullptr;
+    std::unique_ptr<nnueAccumulator> accumulator;
+    int featurePiece(int row, int column) const;
+    int collectSquareChanges(int fromRow, int fromColumn, int toRow, int toColumn, pieceType mover, squareChange *changes) const;
+    void applySquareChanges(const squareChange *changes, int count);
+    void refreshAccumulator();
 
 public:
     chessBoard();
@@ -37,11 +111,17 @@ public:
 
     void initializeBoard();
 
-    bool movePiece(int startX, int startY, int endX, int endY);
+    // promotion picks the piece a pawn turns into, KING means ask the promotion handler
+    bool movePiece(int startX, int startY, int endX, int endY, pieceType promotion = pieceType::KING);
     bool isEmptySquare(int x, int y) const;
 
+    // movePiece describes castling, captures, promotions and checks through the message
+    // handler and asks the promotion handler when it isn't told the piece. without
+    // handlers it stays quiet and promotes to a queen
+    static void setMessageHandler(void (*handler)(const std::string &message));
+    static void setPromotionHandler(pieceType (*handler)(Color color));
+
     Piece *getPieceAt(int x, int y) const;
-    void displayBoard() const;
     position getKingPosition(Color kingColor) const;
     bool canEnemyPieceAttack(int targetX, int targetY, Color enemyColor) const;
     bool isKingInCheck(Color kingColor) const;
@@ -54,6 +134,55 @@ public:
     bool isStalemate(Color color);
     bool tryCastling(Color color, bool kingSide);
 
+    // console front end, defined in chessConsole.cc so the rules need no iostream.
+    // useConsole prints movePiece's messages and asks for promotions on stdin
+    static void useConsole();
+    void displayBoard() const;
+    // asks on the console which piece a pawn of this color turns into
+    static pieceType promptPromotionPiece(Color color);
+
+    // exact result for the side to move when a Syzygy table or a loaded endgame bitbase covers this material
+    wdlResult probeEndgame();
+
+    // engine interface: silent, no prompts, no legality checks in makeMove
+    static std::unique_ptr<Piece> createPiece(pieceType type, Color color);
+    bool loadFEN(const std::string &fen);
+    std::string toFEN() const;
+    bool isSquareAttacked(int row, int column, Color byColor) const;
+    void generateLegalMoves(std::vector<chessMove> &moves);
+    bool isCapture(const chessMove &move) const;
+    // standard algebraic notation for a legal move in this position, with + or # appended
+    std::string toSAN(const chessMove &move);
+    // the legal move written as SAN, check marks and annotations ("+", "#", "!", "?") ignored.
+    // false when no legal move matches
+    bool fromSAN(const std::string &text, chessMove &move);
+    void makeMove(const chessMove &move, moveUndo &undo);
+    void unmakeMove(const chessMove &move, moveUndo &undo);
+    bool hasCastlingRights() const;
+    // Zobrist hash of pieces, side to move, castling rights and en-passant file
+    uint64_t positionKey() const;
+    int pieceCount() const;
+    // neither side can mate: bare kings or a single minor piece left
+    bool isInsufficientMaterial() const;
+
+    // NNUE evaluation: attaching refreshes the accumulators from scratch, after that
+    // movePiece, makeMove and unmakeMove only add and remove the features that changed
+    void attachNetwork(const nnueNetwork *net);
+    const nnueNetwork *getNetwork() const
+    {
+        return network;
+    }
+    // centipawns for the side to move, only with a network attached
+    int evaluateNetwork() const;
+
     int enPassantTargetRow = -1;
     int enPassantTargetColumn = -1;
+    int halfmoveClock = 0;
+    int fullmoveNumber = 1;
+
+    // calls made on this board so far, read by the GUI's performance overlay: isMoveValid
+    // for clicks and hints, generateLegalMoves for check, mate and SAN. plain counters: a
+    // board is only ever used by one thread
+    uint64_t isMoveValidCalls = 0;
+    uint64_t generateLegalMovesCalls = 0;
 };
\ No newline at end of file
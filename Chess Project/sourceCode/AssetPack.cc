@@ -0,0 +1,154 @@
+#include "../header_files/AssetPack.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+// on disk layout: 16 byte header (magic, entry count, size of the index), the index with
+// per file its offset, size, name length and name, then the files, each starting on an
+// 8 byte boundary
+static const char assetPackMagic[4] = {'C', 'A', 'P', '1'};
+static const size_t assetPackHeaderSize = 16;
+static const size_t assetPackAlignment = 8;
+
+bool assetPack::open(const std::string &path)
+{
+    close();
+    if (!mapping.open(path))
+    {
+        std::cerr << "Error opening asset pack: " << path << std::endl;
+        return false;
+    }
+    const uint8_t *view = mapping.data();
+    size_t length = mapping.size();
+    uint32_t count = 0;
+    uint64_t indexSize = 0;
+    if (length < assetPackHeaderSize || std::memcmp(view, assetPackMagic, 4) != 0)
+    {
+        std::cerr << "Invalid asset pack: " << path << std::endl;
+        close();
+        return false;
+    }
+    std::memcpy(&count, view + 4, sizeof(count));
+    std::memcpy(&indexSize, view + 8, sizeof(indexSize));
+
+    // every offset and name is checked against the mapping, a truncated pack is rejected
+    // here rather than read past its end later
+    size_t position = assetPackHeaderSize;
+    bool valid = indexSize <= length - assetPackHeaderSize;
+    for (uint32_t i = 0; i < count && valid; i++)
+    {
+        entry file;
+        uint32_t nameLength = 0;
+        if (position + 20 > assetPackHeaderSize + indexSize)
+        {
+            valid = false;
+            break;
+        }
+        std::memcpy(&file.offset, view + position, sizeof(file.offset));
+        std::memcpy(&file.size, view + position + 8, sizeof(file.size));
+        std::memcpy(&nameLength, view + position + 16, sizeof(nameLength));
+        position += 20;
+        if (nameLength > assetPackHeaderSize + indexSize - position || file.offset > length || file.size > length - file.offset)
+        {
+            valid = false;
+            break;
+        }
+        file.name.assign(reinterpret_cast<const char *>(view + position), nameLength);
+        position += nameLength;
+        entries.push_back(file);
+    }
+    if (!valid)
+    {
+        std::cerr << "Invalid asset pack: " << path << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void assetPack::close()
+{
+    mapping.close();
+    entries.clear();
+}
+
+bool assetPack::find(const std::string &name, const uint8_t *&data, size_t &size) const
+{
+    // a couple of dozen entries, a linear scan beats anything smarter
+    for (const entry &file : entries)
+    {
+        if (file.name == name)
+        {
+            data = mapping.data() + file.offset;
+            size = static_cast<size_t>(file.size);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool assetPack::write(const std::string &path, const std::vector<std::string> &files)
+{
+    std::vector<std::vector<char>> contents;
+    std::vector<std::string> names;
+    for (const std::string &file : files)
+    {
+        std::ifstream in(file, std::ios::binary);
+        if (!in)
+        {
+            std::cerr << "Error reading asset: " << file << std::endl;
+            return false;
+        }
+        contents.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        names.push_back(std::filesystem::path(file).filename().string());
+    }
+
+    uint64_t indexSize = 0;
+    for (const std::string &name : names)
+    {
+        indexSize += 20 + name.size();
+    }
+    std::vector<char> index;
+    uint64_t offset = assetPackHeaderSize + indexSize;
+    std::vector<uint64_t> offsets;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        offset = (offset + assetPackAlignment - 1) / assetPackAlignment * assetPackAlignment;
+        offsets.push_back(offset);
+        uint64_t size = contents[i].size();
+        uint32_t nameLength = static_cast<uint32_t>(names[i].size());
+        char fields[20];
+        std::memcpy(fields, &offset, sizeof(offset));
+        std::memcpy(fields + 8, &size, sizeof(size));
+        std::memcpy(fields + 16, &nameLength, sizeof(nameLength));
+        index.insert(index.end(), fields, fields + sizeof(fields));
+        index.insert(index.end(), names[i].begin(), names[i].end());
+        offset += size;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cerr << "Error writing asset pack: " << path << std::endl;
+        return false;
+    }
+    char header[assetPackHeaderSize] = {};
+    uint32_t count = static_cast<uint32_t>(files.size());
+    std::memcpy(header, assetPackMagic, 4);
+    std::memcpy(header + 4, &count, sizeof(count));
+    std::memcpy(header + 8, &indexSize, sizeof(indexSize));
+    out.write(header, assetPackHeaderSize);
+    out.write(index.data(), static_cast<std::streamsize>(index.size()));
+    uint64_t written = assetPackHeaderSize + indexSize;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        static const char zeros[assetPackAlignment] = {};
+        out.write(zeros, static_cast<std::streamsize>(offsets[i] - written));
+        out.write(contents[i].data(), static_cast<std::streamsize>(contents[i].size()));
+        written = offsets[i] + contents[i].size();
+    }
+    return static_cast<bool>(out);
+}
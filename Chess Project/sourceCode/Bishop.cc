@@ -6,10 +6,11 @@ bishop::bishop(Color c) : Piece(c) {}
 
 bool bishop::isValidMove(int startX, int startY, int endX, int endY, const chessBoard &board) const
 {
-    // bishop diagonally
+    // bishop diagonally, and at least one square: with start == end the path walk below
+    // would never meet the end square and run off the board
     int dx = abs(endX - startX);
     int dy = abs(endY - startY);
-    if (dx != dy)
+    if (dx != dy || dx == 0)
     {
         return false;
     }
@@ -0,0 +1,1213 @@
+#include "../header_files/Bitbase.h"
+#include "../header_files/chessBoard.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
+// on disk layout: 32 byte header followed by the 2 bit entries
+static const char bitbaseMagic[4] = {'C', 'B', 'B', '1'};
+static const size_t bitbaseHeaderSize = 32;
+static const size_t bitbaseMaterialLength = 16;
+
+// 2 bit codes stored per entry, UNKNOWN only exists while generating
+enum : uint8_t
+{
+    STATE_DRAW = 0,
+    STATE_WIN = 1,
+    STATE_LOSS = 2,
+    STATE_ILLEGAL = 3,
+    STATE_UNKNOWN = 4
+};
+
+enum : int
+{
+    MIRROR_FILES = 1,
+    FLIP_RANKS = 2,
+    TRANSPOSE = 4
+};
+
+static const int kingSteps[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+static const int knightSteps[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+static const int rookDirections[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+static const int bishopDirections[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+
+typedef std::array<int8_t, 64> occupancy;
+
+static int rankOf(int sq)
+{
+    return 7 - sq / 8;
+}
+
+static int fileOf(int sq)
+{
+    return sq % 8;
+}
+
+static Color opposite(Color c)
+{
+    return c == Color::WHITE ? Color::BLACK : Color::WHITE;
+}
+
+static int transformSquare(int sq, int transform)
+{
+    int row = sq / 8;
+    int col = sq % 8;
+    if (transform & MIRROR_FILES)
+    {
+        col = 7 - col;
+    }
+    if (transform & FLIP_RANKS)
+    {
+        row = 7 - row;
+    }
+    if (transform & TRANSPOSE)
+    {
+        int oldRow = row;
+        row = 7 - col;
+        col = 7 - oldRow;
+    }
+    return row * 8 + col;
+}
+
+// a1, b1, c1, d1, b2, c2, d2, c3, d3, d4
+static const int kingTriangle[10] = {56, 57, 58, 59, 49, 50, 51, 42, 43, 35};
+
+static int triangleIndex(int sq)
+{
+    for (int i = 0; i < 10; i++)
+    {
+        if (kingTriangle[i] == sq)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int pieceOrder(char symbol)
+{
+    switch (symbol)
+    {
+    case 'Q':
+        return 0;
+    case 'R':
+        return 1;
+    case 'B':
+        return 2;
+    case 'N':
+        return 3;
+    case 'P':
+        return 4;
+    default:
+        return -1;
+    }
+}
+
+static int pieceValue(char symbol)
+{
+    switch (symbol)
+    {
+    case 'Q':
+        return 9;
+    case 'R':
+        return 5;
+    case 'B':
+    case 'N':
+        return 3;
+    default:
+        return 1;
+    }
+}
+
+static pieceType typeFromSymbol(char symbol)
+{
+    switch (symbol)
+    {
+    case 'Q':
+        return pieceType::QUEEN;
+    case 'R':
+        return pieceType::ROOK;
+    case 'B':
+        return pieceType::BISHOP;
+    case 'N':
+        return pieceType::KNIGHT;
+    default:
+        return pieceType::PAWN;
+    }
+}
+
+// splits "KRKP" into the non king pieces of each side
+static bool splitMaterial(const std::string &name, std::string &white, std::string &black)
+{
+    if (name.size() < 2 || name[0] != 'K')
+    {
+        return false;
+    }
+    size_t second = name.find('K', 1);
+    if (second == std::string::npos || name.find('K', second + 1) != std::string::npos)
+    {
+        return false;
+    }
+    white = name.substr(1, second - 1);
+    black = name.substr(second + 1);
+    for (char c : white + black)
+    {
+        if (pieceOrder(c) < 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 3 bits per (colour, piece type) count
+static uint64_t materialKeyOf(const std::string &white, const std::string &black)
+{
+    uint64_t key = 0;
+    for (char c : white)
+    {
+        key += uint64_t(1) << (3 * pieceOrder(c));
+    }
+    for (char c : black)
+    {
+        key += uint64_t(1) << (3 * (5 + pieceOrder(c)));
+    }
+    return key;
+}
+
+static uint64_t materialKeyOf(const endgamePosition &pos, bool swapColors)
+{
+    uint64_t key = 0;
+    for (int i = 2; i < pos.count; i++)
+    {
+        int order = static_cast<int>(pos.type[i]) - 1;
+        bool white = (pos.color[i] == Color::WHITE) != swapColors;
+        key += uint64_t(1) << (3 * ((white ? 0 : 5) + order));
+    }
+    return key;
+}
+
+static void buildOccupancy(const endgamePosition &pos, occupancy &occ)
+{
+    occ.fill(-1);
+    for (int i = 0; i < pos.count; i++)
+    {
+        occ[pos.square[i]] = static_cast<int8_t>(i);
+    }
+}
+
+static bool isPathClear(int from, int to, const occupancy &occ)
+{
+    int rowStep = (to / 8 > from / 8) ? 1 : (to / 8 < from / 8) ? -1 : 0;
+    int colStep = (to % 8 > from % 8) ? 1 : (to % 8 < from % 8) ? -1 : 0;
+    int row = from / 8 + rowStep;
+    int col = from % 8 + colStep;
+    while (row * 8 + col != to)
+    {
+        if (occ[row * 8 + col] != -1)
+        {
+            return false;
+        }
+        row += rowStep;
+        col += colStep;
+    }
+    return true;
+}
+
+static bool attacksSquare(const endgamePosition &pos, const occupancy &occ, int slot, int target)
+{
+    int from = pos.square[slot];
+    int dr = target / 8 - from / 8;
+    int dc = target % 8 - from % 8;
+    int adr = std::abs(dr);
+    int adc = std::abs(dc);
+
+    switch (pos.type[slot])
+    {
+    case pieceType::KING:
+        return std::max(adr, adc) == 1;
+    case pieceType::KNIGHT:
+        return adr * adc == 2;
+    case pieceType::PAWN:
+        return dr == (pos.color[slot] == Color::WHITE ? -1 : 1) && adc == 1;
+    case pieceType::ROOK:
+        return (adr == 0) != (adc == 0) && isPathClear(from, target, occ);
+    case pieceType::BISHOP:
+        return adr == adc && adr != 0 && isPathClear(from, target, occ);
+    case pieceType::QUEEN:
+        return ((adr == 0) != (adc == 0) || (adr == adc && adr != 0)) && isPathClear(from, target, occ);
+    }
+    return false;
+}
+
+static bool isSquareAttacked(const endgamePosition &pos, const occupancy &occ, int target, Color byColor)
+{
+    for (int i = 0; i < pos.count; i++)
+    {
+        if (pos.color[i] == byColor && pos.square[i] != target && attacksSquare(pos, occ, i, target))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool isKingAttacked(const endgamePosition &pos, const occupancy &occ, Color kingColor)
+{
+    int kingSquare = pos.square[kingColor == Color::WHITE ? 0 : 1];
+    return isSquareAttacked(pos, occ, kingSquare, opposite(kingColor));
+}
+
+static bool isLegalPosition(const endgamePosition &pos, occupancy &occ)
+{
+    occ.fill(-1);
+    for (int i = 0; i < pos.count; i++)
+    {
+        if (occ[pos.square[i]] != -1)
+        {
+            return false;
+        }
+        occ[pos.square[i]] = static_cast<int8_t>(i);
+        if (pos.type[i] == pieceType::PAWN && (pos.square[i] / 8 == 0 || pos.square[i] / 8 == 7))
+        {
+            return false;
+        }
+    }
+    int wk = pos.square[0];
+    int bk = pos.square[1];
+    if (std::max(std::abs(wk / 8 - bk / 8), std::abs(wk % 8 - bk % 8)) <= 1)
+    {
+        return false;
+    }
+    // the side that just moved can't have left its king in check
+    return !isKingAttacked(pos, occ, opposite(pos.sideToMove));
+}
+
+static void removeSlot(endgamePosition &pos, int slot)
+{
+    for (int i = slot; i < pos.count - 1; i++)
+    {
+        pos.square[i] = pos.square[i + 1];
+        pos.type[i] = pos.type[i + 1];
+        pos.color[i] = pos.color[i + 1];
+    }
+    pos.count--;
+}
+
+// calls visit(child, leftTable) for every legal move, stops early when visit returns false
+// leftTable is set for captures and promotions, whose result lives in another table
+template <typename Visit>
+static void forEachLegalMove(const endgamePosition &pos, Visit &&visit)
+{
+    occupancy occ;
+    buildOccupancy(pos, occ);
+    Color mover = pos.sideToMove;
+    int targets[28];
+
+    for (int slot = 0; slot < pos.count; slot++)
+    {
+        if (pos.color[slot] != mover)
+        {
+            continue;
+        }
+        int from = pos.square[slot];
+        int row = from / 8;
+        int col = from % 8;
+        int targetCount = 0;
+
+        switch (pos.type[slot])
+        {
+        case pieceType::KING:
+        case pieceType::KNIGHT:
+        {
+            const int(*steps)[2] = pos.type[slot] == pieceType::KING ? kingSteps : knightSteps;
+            for (int i = 0; i < 8; i++)
+            {
+                int r = row + steps[i][0];
+                int c = col + steps[i][1];
+                if (r >= 0 && r < 8 && c >= 0 && c < 8)
+                {
+                    targets[targetCount++] = r * 8 + c;
+                }
+            }
+            break;
+        }
+        case pieceType::PAWN:
+        {
+            int direction = (mover == Color::WHITE) ? -1 : 1;
+            int r = row + direction;
+            if (occ[r * 8 + col] == -1)
+            {
+                targets[targetCount++] = r * 8 + col;
+                bool onStartRow = (mover == Color::WHITE) ? (row == 6) : (row == 1);
+                if (onStartRow && occ[(r + direction) * 8 + col] == -1)
+                {
+                    targets[targetCount++] = (r + direction) * 8 + col;
+                }
+            }
+            for (int dc = -1; dc <= 1; dc += 2)
+            {
+                int c = col + dc;
+                if (c >= 0 && c < 8 && occ[r * 8 + c] != -1)
+                {
+                    targets[targetCount++] = r * 8 + c;
+                }
+            }
+            break;
+        }
+        default:
+        {
+            bool straight = pos.type[slot] != pieceType::BISHOP;
+            bool diagonal = pos.type[slot] != pieceType::ROOK;
+            for (int d = 0; d < 8; d++)
+            {
+                const int *dir = d < 4 ? rookDirections[d] : bishopDirections[d - 4];
+                if ((d < 4 && !straight) || (d >= 4 && !diagonal))
+                {
+                    continue;
+                }
+                int r = row + dir[0];
+                int c = col + dir[1];
+                while (r >= 0 && r < 8 && c >= 0 && c < 8)
+                {
+                    targets[targetCount++] = r * 8 + c;
+                    if (occ[r * 8 + c] != -1)
+                    {
+                        break;
+                    }
+                    r += dir[0];
+                    c += dir[1];
+                }
+            }
+            break;
+        }
+        }
+
+        for (int i = 0; i < targetCount; i++)
+        {
+            int to = targets[i];
+            int captured = occ[to];
+            if (captured != -1 && (pos.color[captured] == mover || captured < 2))
+            {
+                continue;
+            }
+
+            endgamePosition child = pos;
+            child.square[slot] = to;
+            child.sideToMove = opposite(mover);
+            int movedSlot = slot;
+            if (captured != -1)
+            {
+                removeSlot(child, captured);
+                if (captured < slot)
+                {
+                    movedSlot--;
+                }
+            }
+
+            occupancy childOcc;
+            buildOccupancy(child, childOcc);
+            if (isKingAttacked(child, childOcc, mover))
+            {
+                continue;
+            }
+
+            bool promotion = pos.type[slot] == pieceType::PAWN && (to / 8 == 0 || to / 8 == 7);
+            if (promotion)
+            {
+                const pieceType promotions[4] = {pieceType::QUEEN, pieceType::ROOK, pieceType::BISHOP, pieceType::KNIGHT};
+                for (pieceType promoted : promotions)
+                {
+                    child.type[movedSlot] = promoted;
+                    if (!visit(child, true))
+                    {
+                        return;
+                    }
+                }
+            }
+            else if (!visit(child, captured != -1))
+            {
+                return;
+            }
+        }
+    }
+}
+
+// calls visit(parent) for every legal position that reaches pos with a quiet, non promoting move
+template <typename Visit>
+static void forEachPredecessor(const endgamePosition &pos, Visit &&visit)
+{
+    occupancy occ;
+    buildOccupancy(pos, occ);
+    Color mover = opposite(pos.sideToMove);
+    int origins[28];
+
+    for (int slot = 0; slot < pos.count; slot++)
+    {
+        if (pos.color[slot] != mover)
+        {
+            continue;
+        }
+        int to = pos.square[slot];
+        int row = to / 8;
+        int col = to % 8;
+        int originCount = 0;
+
+        switch (pos.type[slot])
+        {
+        case pieceType::KING:
+        case pieceType::KNIGHT:
+        {
+            const int(*steps)[2] = pos.type[slot] == pieceType::KING ? kingSteps : knightSteps;
+            for (int i = 0; i < 8; i++)
+            {
+                int r = row + steps[i][0];
+                int c = col + steps[i][1];
+                if (r >= 0 && r < 8 && c >= 0 && c < 8 && occ[r * 8 + c] == -1)
+                {
+                    origins[originCount++] = r * 8 + c;
+                }
+            }
+            break;
+        }
+        case pieceType::PAWN:
+        {
+            int direction = (mover == Color::WHITE) ? -1 : 1;
+            int r = row - direction;
+            if (r >= 1 && r <= 6 && occ[r * 8 + col] == -1)
+            {
+                origins[originCount++] = r * 8 + col;
+                bool doubleStep = (mover == Color::WHITE) ? (row == 4) : (row == 3);
+                int startRow = r - direction;
+                if (doubleStep && occ[startRow * 8 + col] == -1)
+                {
+                    origins[originCount++] = startRow * 8 + col;
+                }
+            }
+            break;
+        }
+        default:
+        {
+            bool straight = pos.type[slot] != pieceType::BISHOP;
+            bool diagonal = pos.type[slot] != pieceType::ROOK;
+            for (int d = 0; d < 8; d++)
+            {
+                const int *dir = d < 4 ? rookDirections[d] : bishopDirections[d - 4];
+                if ((d < 4 && !straight) || (d >= 4 && !diagonal))
+                {
+                    continue;
+                }
+                int r = row + dir[0];
+                int c = col + dir[1];
+                while (r >= 0 && r < 8 && c >= 0 && c < 8 && occ[r * 8 + c] == -1)
+                {
+                    origins[originCount++] = r * 8 + c;
+                    r += dir[0];
+                    c += dir[1];
+                }
+            }
+            break;
+        }
+        }
+
+        for (int i = 0; i < originCount; i++)
+        {
+            endgamePosition parent = pos;
+            parent.square[slot] = origins[i];
+            parent.sideToMove = mover;
+            occupancy parentOcc;
+            if (isLegalPosition(parent, parentOcc))
+            {
+                visit(parent);
+            }
+        }
+    }
+}
+
+template <typename Body>
+static void parallelFor(size_t count, unsigned threadCount, Body &&body)
+{
+    if (threadCount <= 1 || count < 4096)
+    {
+        body(size_t(0), count, 0u);
+        return;
+    }
+    std::vector<std::thread> workers;
+    size_t chunk = (count + threadCount - 1) / threadCount;
+    for (unsigned t = 0; t < threadCount; t++)
+    {
+        size_t begin = t * chunk;
+        size_t end = std::min(count, begin + chunk);
+        if (begin >= end)
+        {
+            break;
+        }
+        workers.emplace_back([&body, begin, end, t]()
+                             { body(begin, end, t); });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+endgameBitbase::endgameBitbase(const std::string &materialName) : material(materialName)
+{
+    std::string white, black;
+    if (!splitMaterial(material, white, black))
+    {
+        return;
+    }
+    materialKey = materialKeyOf(white, black);
+    for (char c : white)
+    {
+        pieceTypes.push_back(typeFromSymbol(c));
+        pieceColors.push_back(Color::WHITE);
+    }
+    for (char c : black)
+    {
+        pieceTypes.push_back(typeFromSymbol(c));
+        pieceColors.push_back(Color::BLACK);
+    }
+    hasPawns = material.find('P') != std::string::npos;
+
+    entryCount = 2 * (hasPawns ? 32 : 10) * 64;
+    for (size_t i = 0; i < pieceTypes.size(); i++)
+    {
+        entryCount *= 64;
+    }
+}
+
+void endgameBitbase::canonicalize(endgamePosition &pos) const
+{
+    int wk = pos.square[0];
+    int transform = 0;
+    if (fileOf(wk) > 3)
+    {
+        transform |= MIRROR_FILES;
+    }
+    if (!hasPawns)
+    {
+        if (rankOf(wk) > 3)
+        {
+            transform |= FLIP_RANKS;
+        }
+        int mapped = transformSquare(wk, transform);
+        if (rankOf(mapped) > fileOf(mapped))
+        {
+            transform |= TRANSPOSE;
+        }
+    }
+    if (transform)
+    {
+        for (int i = 0; i < pos.count; i++)
+        {
+            pos.square[i] = transformSquare(pos.square[i], transform);
+        }
+    }
+
+    // white pieces first, then by piece type, identical pieces by square
+    for (int i = 3; i < pos.count; i++)
+    {
+        for (int j = i; j > 2; j--)
+        {
+            auto before = std::make_tuple(pos.color[j - 1], pos.type[j - 1], pos.square[j - 1]);
+            auto current = std::make_tuple(pos.color[j], pos.type[j], pos.square[j]);
+            if (current >= before)
+            {
+                break;
+            }
+            std::swap(pos.square[j], pos.square[j - 1]);
+            std::swap(pos.type[j], pos.type[j - 1]);
+            std::swap(pos.color[j], pos.color[j - 1]);
+        }
+    }
+}
+
+uint64_t endgameBitbase::indexOf(const endgamePosition &pos) const
+{
+    int wk = pos.square[0];
+    int kingIndex = hasPawns ? (wk / 8) * 4 + wk % 8 : triangleIndex(wk);
+    uint64_t index = (pos.sideToMove == Color::WHITE ? 0 : 1) * (hasPawns ? 32 : 10) + kingIndex;
+    index = index * 64 + pos.square[1];
+    for (int i = 2; i < pos.count; i++)
+    {
+        index = index * 64 + pos.square[i];
+    }
+    return index;
+}
+
+bool endgameBitbase::positionAt(uint64_t index, endgamePosition &pos) const
+{
+    if (index >= entryCount)
+    {
+        return false;
+    }
+    pos.count = 2 + static_cast<int>(pieceTypes.size());
+    for (int i = pos.count - 1; i >= 2; i--)
+    {
+        pos.square[i] = static_cast<int>(index % 64);
+        pos.type[i] = pieceTypes[i - 2];
+        pos.color[i] = pieceColors[i - 2];
+        index /= 64;
+    }
+    pos.square[1] = static_cast<int>(index % 64);
+    index /= 64;
+
+    int kingSquares = hasPawns ? 32 : 10;
+    int kingIndex = static_cast<int>(index % kingSquares);
+    pos.square[0] = hasPawns ? (kingIndex / 4) * 8 + kingIndex % 4 : kingTriangle[kingIndex];
+    pos.sideToMove = (index / kingSquares) ? Color::BLACK : Color::WHITE;
+
+    pos.type[0] = pieceType::KING;
+    pos.color[0] = Color::WHITE;
+    pos.type[1] = pieceType::KING;
+    pos.color[1] = Color::BLACK;
+    return true;
+}
+
+wdlResult endgameBitbase::probeCanonical(const endgamePosition &pos) const
+{
+    if (!data)
+    {
+        return wdlResult::UNKNOWN;
+    }
+    uint64_t index = indexOf(pos);
+    switch ((data[index >> 2] >> ((index & 3) * 2)) & 3)
+    {
+    case STATE_WIN:
+        return wdlResult::WIN;
+    case STATE_LOSS:
+        return wdlResult::LOSS;
+    case STATE_DRAW:
+        return wdlResult::DRAW;
+    default:
+        return wdlResult::UNKNOWN;
+    }
+}
+
+void endgameBitbase::countResults(uint64_t &wins, uint64_t &draws, uint64_t &losses) const
+{
+    wins = draws = losses = 0;
+    if (!data)
+    {
+        return;
+    }
+    for (uint64_t i = 0; i < entryCount; i++)
+    {
+        switch ((data[i >> 2] >> ((i & 3) * 2)) & 3)
+        {
+        case STATE_WIN:
+            wins++;
+            break;
+        case STATE_LOSS:
+            losses++;
+            break;
+        case STATE_DRAW:
+            draws++;
+            break;
+        }
+    }
+}
+
+bool endgameBitbase::save(const std::string &path) const
+{
+    if (!data)
+    {
+        return false;
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cerr << "Error writing bitbase: " << path << std::endl;
+        return false;
+    }
+    char header[bitbaseHeaderSize] = {};
+    std::memcpy(header, bitbaseMagic, 4);
+    std::memcpy(header + 8, material.data(), std::min(material.size(), bitbaseMaterialLength - 1));
+    std::memcpy(header + 24, &entryCount, sizeof(entryCount));
+    out.write(header, bitbaseHeaderSize);
+    out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>((entryCount + 3) / 4));
+    return static_cast<bool>(out);
+}
+
+bool endgameBitbase::load(const std::string &path)
+{
+    if (!mapping.open(path))
+    {
+        std::cerr << "Error opening bitbase: " << path << std::endl;
+        return false;
+    }
+    const uint8_t *view = mapping.data();
+    uint64_t storedCount = 0;
+    std::memcpy(&storedCount, view + 24, sizeof(storedCount));
+    std::string storedMaterial(reinterpret_cast<const char *>(view + 8));
+
+    if (mapping.size() < bitbaseHeaderSize + (entryCount + 3) / 4 || std::memcmp(view, bitbaseMagic, 4) != 0 ||
+        storedMaterial != material || storedCount != entryCount)
+    {
+        std::cerr << "Invalid bitbase file: " << path << std::endl;
+        mapping.close();
+        return false;
+    }
+    ownedData.clear();
+    ownedData.shrink_to_fit();
+    data = view + bitbaseHeaderSize;
+    return true;
+}
+
+// retrograde solver for one table, the tables reached by captures and promotions must already be in the registry
+class bitbaseGenerator
+{
+private:
+    endgameBitbase &table;
+    const bitbaseRegistry &registry;
+    unsigned threadCount;
+    std::vector<uint8_t> state;
+
+    wdlResult childResult(const endgamePosition &child, bool leftTable, bool useTable) const
+    {
+        if (leftTable)
+        {
+            return child.count == 2 ? wdlResult::DRAW : registry.probe(child);
+        }
+        if (!useTable)
+        {
+            return wdlResult::UNKNOWN;
+        }
+        endgamePosition canonical = child;
+        table.canonicalize(canonical);
+        switch (state[table.indexOf(canonical)])
+        {
+        case STATE_WIN:
+            return wdlResult::WIN;
+        case STATE_LOSS:
+            return wdlResult::LOSS;
+        case STATE_DRAW:
+            return wdlResult::DRAW;
+        default:
+            return wdlResult::UNKNOWN;
+        }
+    }
+
+    // useTable is false during the first pass, when other threads are still filling the table
+    uint8_t evaluate(const endgamePosition &pos, bool useTable) const
+    {
+        bool anyMove = false;
+        bool everyReplyWins = true;
+        bool winning = false;
+        forEachLegalMove(pos, [&](const endgamePosition &child, bool leftTable)
+                         {
+            anyMove = true;
+            wdlResult result = childResult(child, leftTable, useTable);
+            if (result == wdlResult::LOSS)
+            {
+                winning = true;
+                return false;
+            }
+            if (result != wdlResult::WIN)
+            {
+                everyReplyWins = false;
+            }
+            return true; });
+
+        if (winning)
+        {
+            return STATE_WIN;
+        }
+        if (!anyMove)
+        {
+            occupancy occ;
+            buildOccupancy(pos, occ);
+            return isKingAttacked(pos, occ, pos.sideToMove) ? STATE_LOSS : STATE_DRAW;
+        }
+        return everyReplyWins ? STATE_LOSS : STATE_UNKNOWN;
+    }
+
+public:
+    bitbaseGenerator(endgameBitbase &t, const bitbaseRegistry &r, unsigned threads)
+        : table(t), registry(r), threadCount(threads) {}
+
+    void run()
+    {
+        uint64_t entries = table.entryCount;
+        state.assign(entries, STATE_UNKNOWN);
+
+        // first pass: illegal positions, mates, stalemates and conversions into smaller tables
+        std::vector<std::vector<uint64_t>> found(threadCount);
+        parallelFor(entries, threadCount, [&](size_t begin, size_t end, unsigned thread)
+                    {
+            endgamePosition pos;
+            occupancy occ;
+            for (size_t index = begin; index < end; index++)
+            {
+                table.positionAt(index, pos);
+                if (!isLegalPosition(pos, occ))
+                {
+                    state[index] = STATE_ILLEGAL;
+                    continue;
+                }
+                uint8_t result = evaluate(pos, false);
+                state[index] = result;
+                if (result == STATE_WIN || result == STATE_LOSS)
+                {
+                    found[thread].push_back(index);
+                }
+            } });
+
+        std::vector<uint64_t> frontier;
+        for (auto &list : found)
+        {
+            frontier.insert(frontier.end(), list.begin(), list.end());
+            list.clear();
+        }
+
+        // every later pass only revisits parents of the positions resolved in the pass before
+        std::vector<std::vector<uint64_t>> candidates(threadCount);
+        std::vector<std::vector<std::pair<uint64_t, uint8_t>>> resolved(threadCount);
+        while (!frontier.empty())
+        {
+            parallelFor(frontier.size(), threadCount, [&](size_t begin, size_t end, unsigned thread)
+                        {
+                endgamePosition pos;
+                for (size_t i = begin; i < end; i++)
+                {
+                    table.positionAt(frontier[i], pos);
+                    // a king on the long diagonal has two canonical forms, so walk back from both
+                    int images = table.hasPawns ? 1 : 2;
+                    for (int image = 0; image < images; image++)
+                    {
+                        endgamePosition from = pos;
+                        if (image == 1)
+                        {
+                            for (int s = 0; s < from.count; s++)
+                            {
+                                from.square[s] = transformSquare(from.square[s], TRANSPOSE);
+                            }
+                        }
+                        forEachPredecessor(from, [&](endgamePosition &parent)
+                                           {
+                            table.canonicalize(parent);
+                            uint64_t parentIndex = table.indexOf(parent);
+                            if (state[parentIndex] == STATE_UNKNOWN)
+                            {
+                                candidates[thread].push_back(parentIndex);
+                            } });
+                    }
+                } });
+
+            std::vector<uint64_t> pending;
+            for (auto &list : candidates)
+            {
+                pending.insert(pending.end(), list.begin(), list.end());
+                list.clear();
+            }
+            std::sort(pending.begin(), pending.end());
+            pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+
+            parallelFor(pending.size(), threadCount, [&](size_t begin, size_t end, unsigned thread)
+                        {
+                endgamePosition pos;
+                for (size_t i = begin; i < end; i++)
+                {
+                    table.positionAt(pending[i], pos);
+                    uint8_t result = evaluate(pos, true);
+                    if (result != STATE_UNKNOWN)
+                    {
+                        resolved[thread].emplace_back(pending[i], result);
+                    }
+                } });
+
+            frontier.clear();
+            for (auto &list : resolved)
+            {
+                for (auto &entry : list)
+                {
+                    state[entry.first] = entry.second;
+                    frontier.push_back(entry.first);
+                }
+                list.clear();
+            }
+        }
+
+        // whatever neither side could force is a draw
+        table.ownedData.assign((entries + 3) / 4, 0);
+        for (uint64_t i = 0; i < entries; i++)
+        {
+            uint8_t code = state[i] == STATE_UNKNOWN ? uint8_t(STATE_DRAW) : state[i];
+            table.ownedData[i >> 2] |= static_cast<uint8_t>(code << ((i & 3) * 2));
+        }
+        state.clear();
+        state.shrink_to_fit();
+        table.data = table.ownedData.data();
+    }
+};
+
+bitbaseRegistry &bitbaseRegistry::instance()
+{
+    static bitbaseRegistry registry;
+    return registry;
+}
+
+std::string bitbaseRegistry::normalizeMaterial(const std::string &materialName)
+{
+    std::string name;
+    for (char c : materialName)
+    {
+        name += static_cast<char>(toupper(static_cast<unsigned char>(c)));
+    }
+    std::string white, black;
+    if (!splitMaterial(name, white, black) || white.size() + black.size() > 2)
+    {
+        return "";
+    }
+
+    auto byOrder = [](char a, char b)
+    { return pieceOrder(a) < pieceOrder(b); };
+    std::sort(white.begin(), white.end(), byOrder);
+    std::sort(black.begin(), black.end(), byOrder);
+
+    // the stronger side is always stored as white
+    auto strength = [](const std::string &side)
+    {
+        int value = 0;
+        for (char c : side)
+        {
+            value += pieceValue(c);
+        }
+        return std::make_tuple(side.size(), value);
+    };
+    if (strength(black) > strength(white) || (strength(black) == strength(white) && black > white))
+    {
+        std::swap(white, black);
+    }
+    return "K" + white + "K" + black;
+}
+
+bool bitbaseRegistry::generate(const std::string &materialName, unsigned threadCount)
+{
+    std::string name = normalizeMaterial(materialName);
+    if (name.empty())
+    {
+        std::cerr << "Unsupported bitbase material: " << materialName << std::endl;
+        return false;
+    }
+    if (find(name))
+    {
+        return true;
+    }
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // captures and promotions lead into these tables
+    std::string white, black;
+    splitMaterial(name, white, black);
+    std::vector<std::string> dependencies;
+    for (int side = 0; side < 2; side++)
+    {
+        const std::string &own = side == 0 ? white : black;
+        const std::string &other = side == 0 ? black : white;
+        for (size_t i = 0; i < own.size(); i++)
+        {
+            std::string fewer = own.substr(0, i) + own.substr(i + 1);
+            if (!fewer.empty() || !other.empty())
+            {
+                dependencies.push_back(side == 0 ? "K" + fewer + "K" + other : "K" + other + "K" + fewer);
+            }
+            if (own[i] == 'P')
+            {
+                for (char promoted : {'Q', 'R', 'B', 'N'})
+                {
+                    std::string changed = own;
+                    changed[i] = promoted;
+                    dependencies.push_back(side == 0 ? "K" + changed + "K" + other : "K" + other + "K" + changed);
+                }
+            }
+        }
+    }
+    for (const std::string &dependency : dependencies)
+    {
+        if (!generate(dependency, threadCount))
+        {
+            return false;
+        }
+    }
+
+    auto table = std::make_unique<endgameBitbase>(name);
+    auto start = std::chrono::steady_clock::now();
+    bitbaseGenerator generator(*table, *this, threadCount);
+    generator.run();
+    table->generationSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::unique_lock<std::shared_mutex> lock(tablesMutex);
+    tables[table->getMaterialKey()] = std::move(table);
+    return true;
+}
+
+bool bitbaseRegistry::load(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    char header[bitbaseHeaderSize] = {};
+    if (!in.read(header, bitbaseHeaderSize) || std::memcmp(header, bitbaseMagic, 4) != 0)
+    {
+        std::cerr << "Invalid bitbase file: " << path << std::endl;
+        return false;
+    }
+    header[8 + bitbaseMaterialLength - 1] = '\0';
+    std::string name = normalizeMaterial(header + 8);
+    if (name.empty())
+    {
+        std::cerr << "Invalid bitbase file: " << path << std::endl;
+        return false;
+    }
+
+    auto table = std::make_unique<endgameBitbase>(name);
+    if (!table->load(path))
+    {
+        return false;
+    }
+    std::unique_lock<std::shared_mutex> lock(tablesMutex);
+    tables[table->getMaterialKey()] = std::move(table);
+    return true;
+}
+
+bool bitbaseRegistry::loadDirectory(const std::string &directory)
+{
+    std::error_code error;
+    bool anyLoaded = false;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.path().extension() == ".cbb")
+        {
+            anyLoaded = load(entry.path().string()) || anyLoaded;
+        }
+    }
+    return anyLoaded;
+}
+
+bool bitbaseRegistry::saveAll(const std::string &directory) const
+{
+    std::shared_lock<std::shared_mutex> lock(tablesMutex);
+    bool ok = true;
+    for (const auto &entry : tables)
+    {
+        std::filesystem::path path = std::filesystem::path(directory) / (entry.second->getMaterial() + ".cbb");
+        ok = entry.second->save(path.string()) && ok;
+    }
+    return ok;
+}
+
+const endgameBitbase *bitbaseRegistry::find(const std::string &materialName) const
+{
+    std::string white, black;
+    if (!splitMaterial(normalizeMaterial(materialName), white, black))
+    {
+        return nullptr;
+    }
+    std::shared_lock<std::shared_mutex> lock(tablesMutex);
+    auto it = tables.find(materialKeyOf(white, black));
+    return it == tables.end() ? nullptr : it->second.get();
+}
+
+std::vector<std::string> bitbaseRegistry::loadedMaterials() const
+{
+    std::shared_lock<std::shared_mutex> lock(tablesMutex);
+    std::vector<std::string> names;
+    for (const auto &entry : tables)
+    {
+        names.push_back(entry.second->getMaterial());
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+wdlResult bitbaseRegistry::probe(const endgamePosition &pos) const
+{
+    if (pos.count < 3 || pos.count > 4)
+    {
+        return pos.count == 2 ? wdlResult::DRAW : wdlResult::UNKNOWN;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(tablesMutex);
+    auto it = tables.find(materialKeyOf(pos, false));
+    if (it != tables.end())
+    {
+        endgamePosition canonical = pos;
+        it->second->canonicalize(canonical);
+        return it->second->probeCanonical(canonical);
+    }
+
+    // same material with the colours swapped: mirror the board top to bottom
+    it = tables.find(materialKeyOf(pos, true));
+    if (it == tables.end())
+    {
+        return wdlResult::UNKNOWN;
+    }
+    endgamePosition swapped = pos;
+    for (int i = 0; i < pos.count; i++)
+    {
+        swapped.square[i] = transformSquare(pos.square[i], FLIP_RANKS);
+        swapped.color[i] = opposite(pos.color[i]);
+    }
+    std::swap(swapped.square[0], swapped.square[1]);
+    std::swap(swapped.color[0], swapped.color[1]);
+    swapped.sideToMove = opposite(pos.sideToMove);
+    it->second->canonicalize(swapped);
+    return it->second->probeCanonical(swapped);
+}
+
+wdlResult bitbaseRegistry::probe(const chessBoard &board) const
+{
+    // the bitbases hold neither castling rights nor en-passant squares
+    if (board.enPassantTargetColumn != -1 || board.hasCastlingRights())
+    {
+        return wdlResult::UNKNOWN;
+    }
+    endgamePosition pos;
+    pos.count = 2;
+    bool whiteKing = false, blackKing = false;
+    for (int i = 0; i < 8; i++)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            Piece *piece = board.getPieceAt(i, j);
+            if (!piece)
+            {
+                continue;
+            }
+            if (piece->getType() == pieceType::KING)
+            {
+                int slot = piece->getColor() == Color::WHITE ? 0 : 1;
+                (slot == 0 ? whiteKing : blackKing) = true;
+                pos.square[slot] = i * 8 + j;
+                pos.type[slot] = pieceType::KING;
+                pos.color[slot] = piece->getColor();
+                continue;
+            }
+            if (pos.count == 4)
+            {
+                return wdlResult::UNKNOWN;
+            }
+            pos.square[pos.count] = i * 8 + j;
+            pos.type[pos.count] = piece->getType();
+            pos.color[pos.count] = piece->getColor();
+            pos.count++;
+        }
+    }
+    if (!whiteKing || !blackKing)
+    {
+        return wdlResult::UNKNOWN;
+    }
+    pos.sideToMove = board.getPlayerTurn();
+    return probe(pos);
+}
@@ -0,0 +1,91 @@
+#include "../header_files/BoardArt.h"
+#include "../header_files/Pieces.h"
+
+#include <algorithm>
+#include <iostream>
+
+void boardArt::compose(const sf::Image (&images)[12])
+{
+    const unsigned padding = 2;
+    const unsigned solidSize = 4;
+
+    unsigned cellWidth = 1, cellHeight = 1;
+    for (int i = 0; i < 12; i++)
+    {
+        cellWidth = std::max(cellWidth, images[i].getSize().x);
+        cellHeight = std::max(cellHeight, images[i].getSize().y);
+    }
+
+    unsigned solidY = 2 * (cellHeight + padding);
+    atlasImage.create(6 * (cellWidth + padding), solidY + solidSize, sf::Color::Transparent);
+    for (int i = 0; i < 12; i++)
+    {
+        unsigned x = (i % 6) * (cellWidth + padding);
+        unsigned y = (i / 6) * (cellHeight + padding);
+        atlasImage.copy(images[i], x, y);
+        pieceRects[i] = sf::IntRect(x, y, images[i].getSize().x, images[i].getSize().y);
+    }
+    for (unsigned x = 0; x < solidSize; x++)
+    {
+        for (unsigned y = 0; y < solidSize; y++)
+        {
+            atlasImage.setPixel(x, solidY + y, sf::Color::White);
+        }
+    }
+    solidTexel = sf::Vector2f(solidSize / 2.f, solidY + solidSize / 2.f);
+}
+
+bool boardArt::upload()
+{
+    if (!atlas.loadFromImage(atlasImage))
+    {
+        std::cerr << "Error creating the piece atlas" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int boardArt::pieceIndexAt(const chessBoard &board, int square)
+{
+    Piece *piece = board.getPieceAt(square / 8, square % 8);
+    return piece ? static_cast<int>(piece->getType()) + (piece->getColor() == Color::WHITE ? 0 : 6) : -1;
+}
+
+void boardArt::writeQuad(sf::Vertex *quad, float x, float y, float width, float height, sf::Color color, sf::FloatRect texture)
+{
+    sf::Vector2f corners[4] = {sf::Vector2f(x, y), sf::Vector2f(x + width, y), sf::Vector2f(x + width, y + height),
+                               sf::Vector2f(x, y + height)};
+    sf::Vector2f texels[4] = {sf::Vector2f(texture.left, texture.top), sf::Vector2f(texture.left + texture.width, texture.top),
+                              sf::Vector2f(texture.left + texture.width, texture.top + texture.height),
+                              sf::Vector2f(texture.left, texture.top + texture.height)};
+    const int order[6] = {0, 1, 2, 0, 2, 3};
+    for (int i = 0; i < 6; i++)
+    {
+        quad[i] = sf::Vertex(corners[order[i]], color, texels[order[i]]);
+    }
+}
+
+void boardArt::writePieceQuad(sf::Vertex *quad, int pieceIndex, float x, float y, float squareSize, sf::Color color) const
+{
+    sf::IntRect rect = pieceIndex >= 0 ? pieceRects[pieceIndex] : sf::IntRect();
+    float scale = std::max(rect.width, rect.height) > 0 ? squareSize / std::max(rect.width, rect.height) : 0.f;
+    float width = rect.width * scale;
+    float height = rect.height * scale;
+    writeQuad(quad, x + (squareSize - width) / 2, y + (squareSize - height) / 2, width, height, color,
+              sf::FloatRect(static_cast<float>(rect.left), static_cast<float>(rect.top), static_cast<float>(rect.width),
+                            static_cast<float>(rect.height)));
+}
+
+void boardArt::writePosition(sf::Vertex *vertices, const chessBoard &board, float x, float y, float squareSize) const
+{
+    for (int square = 0; square < 64; square++)
+    {
+        int row = square / 8;
+        int column = square % 8;
+        float squareX = x + column * squareSize;
+        float squareY = y + row * squareSize;
+        writeQuad(&vertices[square * 6], squareX, squareY, squareSize, squareSize,
+                  (row + column) % 2 == 0 ? darkSquare : lightSquare, solid());
+        writePieceQuad(&vertices[(64 + square) * 6], pieceIndexAt(board, square), squareX, squareY, squareSize, sf::Color::White);
+    }
+}
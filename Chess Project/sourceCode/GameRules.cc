@@ -0,0 +1,73 @@
+#include "../header_files/GameRules.h"
+
+#include <algorithm>
+
+void gameHistory::reset(const chessBoard &board)
+{
+    keys.assign(1, board.positionKey());
+}
+
+void gameHistory::record(const chessBoard &board)
+{
+    if (board.halfmoveClock == 0)
+    {
+        keys.clear();
+    }
+    keys.push_back(board.positionKey());
+}
+
+adjudication gameHistory::adjudicate(chessBoard &board, std::vector<chessMove> &legal) const
+{
+    board.generateLegalMoves(legal);
+    if (legal.empty())
+    {
+        return board.isKingInCheck(board.getPlayerTurn()) ? adjudication::CHECKMATE : adjudication::STALEMATE;
+    }
+    if (board.halfmoveClock >= 100)
+    {
+        return adjudication::FIFTY_MOVES;
+    }
+    if (!keys.empty() && std::count(keys.begin(), keys.end(), keys.back()) >= 3)
+    {
+        return adjudication::REPETITION;
+    }
+    if (board.isInsufficientMaterial())
+    {
+        return adjudication::MATERIAL;
+    }
+    return adjudication::ONGOING;
+}
+
+int resignationRule::record(Color sideToMove, int score)
+{
+    int whiteScore = sideToMove == Color::WHITE ? score : -score;
+    int result = whiteScore <= -margin ? -1 : whiteScore >= margin ? 1 : 0;
+    streak = result != 0 && result == streakResult ? streak + 1 : result != 0 ? 1 : 0;
+    streakResult = result;
+    return streak >= plies ? result : 0;
+}
+
+uint64_t nextRandom(uint64_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+bool playRandomOpening(chessBoard &board, int plies, uint64_t &random)
+{
+    std::vector<chessMove> moves;
+    for (int ply = 0; ply < plies; ply++)
+    {
+        board.generateLegalMoves(moves);
+        if (moves.empty())
+        {
+            return false;
+        }
+        moveUndo undo;
+        board.makeMove(moves[nextRandom(random) % moves.size()], undo);
+    }
+    board.generateLegalMoves(moves);
+    return !moves.empty();
+}
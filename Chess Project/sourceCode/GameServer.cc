@@ -0,0 +1,489 @@
+#include "../header_files/GameServer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// a client that stops reading its replies is dropped once this much is waiting for it
+static const size_t maxPendingOutput = 4 << 20;
+static const size_t maxPayload = 1024;
+
+gameServer::gameServer(size_t gameLimit) : maxGames(gameLimit)
+{
+    epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    wakeDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollDescriptor < 0 || wakeDescriptor < 0)
+    {
+        std::cerr << "Could not create the event loop: " << std::strerror(errno) << std::endl;
+        return;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wakeDescriptor;
+    epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, wakeDescriptor, &event);
+}
+
+gameServer::~gameServer()
+{
+    for (auto &entry : connections)
+    {
+        close(entry.first);
+    }
+    for (int listener : listeners)
+    {
+        close(listener);
+    }
+    if (!unixPath.empty())
+    {
+        unlink(unixPath.c_str());
+    }
+    if (wakeDescriptor >= 0)
+    {
+        close(wakeDescriptor);
+    }
+    if (epollDescriptor >= 0)
+    {
+        close(epollDescriptor);
+    }
+}
+
+bool gameServer::addListener(int socket)
+{
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = socket;
+    if (listen(socket, SOMAXCONN) < 0 || epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, socket, &event) < 0)
+    {
+        std::cerr << "Could not listen: " << std::strerror(errno) << std::endl;
+        close(socket);
+        return false;
+    }
+    listeners.push_back(socket);
+    return true;
+}
+
+bool gameServer::listenUnix(const std::string &path)
+{
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Socket path too long: " << path << std::endl;
+        return false;
+    }
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+    {
+        std::cerr << "Could not create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    // a socket file left behind by an earlier run would make bind fail, anything else at
+    // that path is not ours to remove
+    struct stat existing;
+    if (lstat(path.c_str(), &existing) == 0)
+    {
+        if (!S_ISSOCK(existing.st_mode))
+        {
+            std::cerr << "Not a socket, leaving it alone: " << path << std::endl;
+            close(listener);
+            return false;
+        }
+        unlink(path.c_str());
+    }
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        std::cerr << "Could not bind " << path << ": " << std::strerror(errno) << std::endl;
+        close(listener);
+        return false;
+    }
+    unixPath = path;
+    return addListener(listener);
+}
+
+bool gameServer::listenTcp(uint16_t port)
+{
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+    {
+        std::cerr << "Could not create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        std::cerr << "Could not bind port " << port << ": " << std::strerror(errno) << std::endl;
+        close(listener);
+        return false;
+    }
+    return addListener(listener);
+}
+
+void gameServer::stop()
+{
+    uint64_t one = 1;
+    ssize_t written = write(wakeDescriptor, &one, sizeof(one));
+    (void)written;
+}
+
+void gameServer::run()
+{
+    std::vector<epoll_event> events(256);
+    bool running = epollDescriptor >= 0 && wakeDescriptor >= 0;
+    while (running)
+    {
+        int ready = epoll_wait(epollDescriptor, events.data(), static_cast<int>(events.size()), -1);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            std::cerr << "epoll_wait failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        for (int i = 0; i < ready; i++)
+        {
+            int descriptor = events[i].data.fd;
+            if (descriptor == wakeDescriptor)
+            {
+                running = false;
+                continue;
+            }
+            if (std::find(listeners.begin(), listeners.end(), descriptor) != listeners.end())
+            {
+                acceptClients(descriptor);
+                continue;
+            }
+
+            auto found = connections.find(descriptor);
+            if (found == connections.end())
+            {
+                continue;
+            }
+            // requests that arrived before a hang up are still answered, reading sees the end
+            if (events[i].events & EPOLLIN)
+            {
+                readClient(*found->second);
+            }
+            else if (events[i].events & (EPOLLERR | EPOLLHUP))
+            {
+                closeClient(descriptor);
+                continue;
+            }
+            // reading may have closed it
+            found = connections.find(descriptor);
+            if (found != connections.end() && (events[i].events & EPOLLOUT))
+            {
+                writeClient(*found->second);
+            }
+        }
+    }
+}
+
+void gameServer::acceptClients(int listener)
+{
+    while (true)
+    {
+        int socket = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (socket < 0)
+        {
+            return;
+        }
+        // replies are small and the clients wait for them, don't let Nagle hold them back
+        int yes = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = socket;
+        if (epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, socket, &event) < 0)
+        {
+            close(socket);
+            continue;
+        }
+        auto client = std::make_unique<connection>();
+        client->socket = socket;
+        client->events = event.events;
+        connections[socket] = std::move(client);
+    }
+}
+
+void gameServer::closeClient(int socket)
+{
+    epoll_ctl(epollDescriptor, EPOLL_CTL_DEL, socket, nullptr);
+    close(socket);
+    connections.erase(socket);
+}
+
+// reads what is there, answers every complete request and sends the replies in one go. a
+// client that hung up still gets the replies to the requests it sent before
+void gameServer::readClient(connection &client)
+{
+    uint8_t buffer[65536];
+    while (true)
+    {
+        ssize_t received = recv(client.socket, buffer, sizeof(buffer), 0);
+        if (received > 0)
+        {
+            client.input.insert(client.input.end(), buffer, buffer + received);
+            continue;
+        }
+        if (received == 0)
+        {
+            client.peerClosed = true;
+            break;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            closeClient(client.socket);
+            return;
+        }
+        if (errno != EINTR)
+        {
+            break;
+        }
+    }
+
+    size_t offset = 0;
+    while (client.input.size() - offset >= sizeof(messageHeader))
+    {
+        messageHeader header;
+        std::memcpy(&header, client.input.data() + offset, sizeof(header));
+        if (header.length > maxPayload)
+        {
+            closeClient(client.socket);
+            return;
+        }
+        if (client.input.size() - offset < sizeof(header) + header.length)
+        {
+            break;
+        }
+        handleMessage(header, client.input.data() + offset + sizeof(header), client.output);
+        offset += sizeof(header) + header.length;
+    }
+    client.input.erase(client.input.begin(), client.input.begin() + offset);
+
+    if (client.output.size() - client.outputSent > maxPendingOutput)
+    {
+        closeClient(client.socket);
+        return;
+    }
+    writeClient(client);
+}
+
+// sends as much as the socket takes, the rest waits for EPOLLOUT
+void gameServer::writeClient(connection &client)
+{
+    while (client.outputSent < client.output.size())
+    {
+        ssize_t sent = send(client.socket, client.output.data() + client.outputSent, client.output.size() - client.outputSent, MSG_NOSIGNAL);
+        if (sent > 0)
+        {
+            client.outputSent += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        closeClient(client.socket);
+        return;
+    }
+
+    bool pending = client.outputSent < client.output.size();
+    if (!pending)
+    {
+        client.output.clear();
+        client.outputSent = 0;
+        if (client.peerClosed)
+        {
+            closeClient(client.socket);
+            return;
+        }
+    }
+    // after a hang up only the replies are waited for, the end of the input would keep
+    // waking the loop
+    uint32_t events = (client.peerClosed ? 0u : static_cast<uint32_t>(EPOLLIN)) | (pending ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    if (events != client.events)
+    {
+        client.events = events;
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = client.socket;
+        epoll_ctl(epollDescriptor, EPOLL_CTL_MOD, client.socket, &event);
+    }
+}
+
+void gameServer::appendReply(std::vector<uint8_t> &reply, uint8_t type, uint8_t code, uint32_t gameId, const void *payload, size_t length)
+{
+    messageHeader header;
+    header.type = type;
+    header.code = code;
+    header.length = static_cast<uint16_t>(length);
+    header.gameId = gameId;
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&header);
+    reply.insert(reply.end(), bytes, bytes + sizeof(header));
+    bytes = static_cast<const uint8_t *>(payload);
+    reply.insert(reply.end(), bytes, bytes + length);
+}
+
+// the side to move, check and whether the game just ended by the rules
+void gameServer::updateState(hostedGame &game)
+{
+    chessBoard &board = game.board;
+    Color turn = board.getPlayerTurn();
+    game.state.sideToMove = turn == Color::WHITE ? 0 : 1;
+    game.state.inCheck = board.isKingInCheck(turn) ? 1 : 0;
+
+    switch (game.history.adjudicate(board, legalMoves))
+    {
+    case adjudication::ONGOING:
+        return;
+    case adjudication::CHECKMATE:
+        game.state.ending = ENDING_CHECKMATE;
+        game.state.outcome = turn == Color::WHITE ? OUTCOME_BLACK_WINS : OUTCOME_WHITE_WINS;
+        return;
+    case adjudication::STALEMATE:
+        game.state.ending = ENDING_STALEMATE;
+        break;
+    case adjudication::FIFTY_MOVES:
+        game.state.ending = ENDING_FIFTY_MOVES;
+        break;
+    case adjudication::REPETITION:
+        game.state.ending = ENDING_REPETITION;
+        break;
+    case adjudication::MATERIAL:
+        game.state.ending = ENDING_MATERIAL;
+        break;
+    }
+    game.state.outcome = OUTCOME_DRAW;
+}
+
+void gameServer::handleMessage(const messageHeader &header, const uint8_t *payload, std::vector<uint8_t> &reply)
+{
+    auto fail = [&](messageError error)
+    {
+        appendReply(reply, MESSAGE_ERROR, error, header.gameId, nullptr, 0);
+    };
+
+    if (header.type == MESSAGE_CREATE)
+    {
+        if (games.size() >= maxGames)
+        {
+            fail(ERROR_TOO_MANY_GAMES);
+            return;
+        }
+        auto game = std::make_unique<hostedGame>();
+        if (header.length > 0 && !game->board.loadFEN(std::string(reinterpret_cast<const char *>(payload), header.length)))
+        {
+            fail(ERROR_BAD_REQUEST);
+            return;
+        }
+        game->history.reset(game->board);
+        updateState(*game);
+        uint32_t id = nextGameId++;
+        appendReply(reply, MESSAGE_STATE, ERROR_NONE, id, &game->state, sizeof(gameState));
+        games[id] = std::move(game);
+        return;
+    }
+
+    auto found = games.find(header.gameId);
+    if (found == games.end())
+    {
+        fail(ERROR_UNKNOWN_GAME);
+        return;
+    }
+    hostedGame &game = *found->second;
+
+    switch (header.type)
+    {
+    case MESSAGE_MOVE:
+    {
+        if (header.length != sizeof(uint16_t))
+        {
+            fail(ERROR_BAD_REQUEST);
+            return;
+        }
+        if (game.state.outcome != OUTCOME_ONGOING)
+        {
+            fail(ERROR_GAME_OVER);
+            return;
+        }
+        chessMove move;
+        std::memcpy(&move.data, payload, sizeof(move.data));
+        game.board.generateLegalMoves(legalMoves);
+        if (std::find(legalMoves.begin(), legalMoves.end(), move) == legalMoves.end())
+        {
+            fail(ERROR_ILLEGAL_MOVE);
+            return;
+        }
+        moveUndo undo;
+        game.board.makeMove(move, undo);
+        game.history.record(game.board);
+        game.state.plies++;
+        game.state.lastMove = move.data;
+        updateState(game);
+        appendReply(reply, MESSAGE_STATE, ERROR_NONE, header.gameId, &game.state, sizeof(gameState));
+        break;
+    }
+    case MESSAGE_STATUS:
+    {
+        std::string fen = game.board.toFEN();
+        std::vector<uint8_t> position(sizeof(gameState) + fen.size());
+        std::memcpy(position.data(), &game.state, sizeof(gameState));
+        std::memcpy(position.data() + sizeof(gameState), fen.data(), fen.size());
+        appendReply(reply, MESSAGE_POSITION, ERROR_NONE, header.gameId, position.data(), position.size());
+        break;
+    }
+    case MESSAGE_RESIGN:
+    {
+        if (header.length != 1 || payload[0] > 1)
+        {
+            fail(ERROR_BAD_REQUEST);
+            return;
+        }
+        if (game.state.outcome != OUTCOME_ONGOING)
+        {
+            fail(ERROR_GAME_OVER);
+            return;
+        }
+        game.state.outcome = payload[0] == 0 ? OUTCOME_BLACK_WINS : OUTCOME_WHITE_WINS;
+        game.state.ending = ENDING_RESIGNATION;
+        appendReply(reply, MESSAGE_STATE, ERROR_NONE, header.gameId, &game.state, sizeof(gameState));
+        break;
+    }
+    case MESSAGE_CLOSE:
+    {
+        gameState last = game.state;
+        games.erase(found);
+        appendReply(reply, MESSAGE_STATE, ERROR_NONE, header.gameId, &last, sizeof(gameState));
+        break;
+    }
+    default:
+        fail(ERROR_BAD_REQUEST);
+        break;
+    }
+}
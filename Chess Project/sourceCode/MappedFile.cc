@@ -0,0 +1,105 @@
+#include "../header_files/MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+mappedFile::~mappedFile()
+{
+    close();
+}
+
+bool mappedFile::open(const std::string &path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void *address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!address)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    view = static_cast<const uint8_t *>(address);
+    length = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void *address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // table probes jump all over the file, read ahead would only waste memory
+    madvise(address, static_cast<size_t>(info.st_size), MADV_RANDOM);
+
+    fileDescriptor = fd;
+    view = static_cast<const uint8_t *>(address);
+    length = static_cast<size_t>(info.st_size);
+#endif
+    return true;
+}
+
+void mappedFile::close()
+{
+    if (!view)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(view);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    munmap(const_cast<uint8_t *>(view), length);
+    ::close(fileDescriptor);
+    fileDescriptor = -1;
+#endif
+    view = nullptr;
+    length = 0;
+}
@@ -0,0 +1,466 @@
+#include "../header_files/MateSolver.h"
+#include "../header_files/Trace.h"
+
+#include <algorithm>
+
+// proof and disproof numbers are 24 bits each so both fit the positionCache payload
+static const uint32_t infiniteNumber = (1u << 24) - 1;
+static const int solvedBonus = 128;
+static const int busySlots = 1 << 16;
+
+static uint32_t saturatingAdd(uint32_t a, uint32_t b)
+{
+    if (a >= infiniteNumber || b >= infiniteNumber)
+    {
+        return infiniteNumber;
+    }
+    return std::min(a + b, infiniteNumber - 1);
+}
+
+static uint32_t clampThreshold(int64_t value)
+{
+    return static_cast<uint32_t>(std::max<int64_t>(0, std::min<int64_t>(value, infiniteNumber)));
+}
+
+// the same position is a different node for every number of moves left and for either side attacking
+static uint64_t nodeKey(uint64_t positionKey, int movesLeft, bool orNode)
+{
+    uint64_t z = static_cast<uint64_t>(movesLeft * 2 + (orNode ? 1 : 0)) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return positionKey ^ (z ^ (z >> 31));
+}
+
+mateSolver::mateSolver(size_t hashMegabytes, int threadCount)
+    : table(hashMegabytes), busy(new std::atomic<uint8_t>[busySlots])
+{
+    for (int i = 0; i < busySlots; i++)
+    {
+        busy[i].store(0, std::memory_order_relaxed);
+    }
+    setThreads(threadCount);
+}
+
+void mateSolver::setThreads(int threadCount)
+{
+    threads.clear();
+    for (int i = 0; i < std::max(1, threadCount); i++)
+    {
+        threads.push_back(std::make_unique<threadContext>());
+        threads.back()->id = i;
+    }
+}
+
+uint64_t mateSolver::totalNodes() const
+{
+    uint64_t total = 0;
+    for (const auto &thread : threads)
+    {
+        total += thread->publishedNodes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+bool mateSolver::shouldStop(threadContext &thread)
+{
+    if ((thread.nodes & 1023) == 0)
+    {
+        thread.publishedNodes.store(thread.nodes, std::memory_order_relaxed);
+        if (hasDeadline && std::chrono::steady_clock::now() >= deadline)
+        {
+            stopRequested.store(true, std::memory_order_relaxed);
+        }
+        if (nodeLimit && thread.id == 0 && totalNodes() >= nodeLimit)
+        {
+            stopRequested.store(true, std::memory_order_relaxed);
+        }
+    }
+    return stopRequested.load(std::memory_order_relaxed) || rootSolved.load(std::memory_order_relaxed);
+}
+
+bool mateSolver::lookup(uint64_t key, uint32_t &proof, uint32_t &disproof) const
+{
+    uint64_t payload;
+    int priority;
+    if (!table.probe(key, payload, priority))
+    {
+        return false;
+    }
+    proof = static_cast<uint32_t>(payload & infiniteNumber);
+    disproof = static_cast<uint32_t>((payload >> 24) & infiniteNumber);
+    return true;
+}
+
+int mateSolver::lookupWork(uint64_t key) const
+{
+    uint64_t payload;
+    int priority;
+    return table.probe(key, payload, priority) ? priority : -1;
+}
+
+// entries are kept by the size of the subtree behind them, solved ones above all open
+// ones except for leaves, which are cheaper to settle again than to keep
+void mateSolver::store(uint64_t key, uint32_t proof, uint32_t disproof, uint64_t work)
+{
+    uint32_t oldProof, oldDisproof;
+    if (lookup(key, oldProof, oldDisproof) && (oldProof == 0 || oldDisproof == 0))
+    {
+        // another thread already settled it, an open estimate must not replace that
+        return;
+    }
+    bool solved = proof == 0 || disproof == 0;
+    int priority = solved && work > 1 ? solvedBonus : 0;
+    while (work > 0 && priority < 255)
+    {
+        work >>= 1;
+        priority++;
+    }
+    table.store(key, static_cast<uint64_t>(proof) | (static_cast<uint64_t>(disproof) << 24), priority);
+}
+
+// expands one node until its numbers cross a threshold. in phi/delta form an OR node
+// (attacker to move) has phi = proof and delta = disproof, an AND node the other way
+// round, so both kinds pick the child with the smallest delta and sum the children's phi.
+// the children's numbers are also kept locally: a full table may drop them before the
+// next pass and the search would then pick the same child again without progress
+void mateSolver::search(threadContext &thread, chessBoard &board, uint64_t key, bool orNode, int movesLeft,
+                        uint32_t phiThreshold, uint32_t deltaThreshold, uint32_t &proof, uint32_t &disproof)
+{
+    thread.nodes++;
+    uint64_t startNodes = thread.nodes;
+
+    std::vector<chessMove> moves;
+    board.generateLegalMoves(moves);
+    if (moves.empty() || (!orNode && movesLeft == 0))
+    {
+        bool mated = !orNode && moves.empty() && board.isKingInCheck(board.getPlayerTurn());
+        proof = mated ? 0 : infiniteNumber;
+        disproof = mated ? infiniteNumber : 0;
+        store(key, proof, disproof, 1);
+        return;
+    }
+
+    // the attacker's last move: the node is proven when one of the moves mates, there is
+    // nothing to search below it and nothing worth keeping in the table but the answer
+    Color attacked = board.getPlayerTurn() == Color::WHITE ? Color::BLACK : Color::WHITE;
+    if (orNode && movesLeft == 1)
+    {
+        bool mate = false;
+        for (size_t i = 0; i < moves.size() && !mate; i++)
+        {
+            moveUndo undo;
+            board.makeMove(moves[i], undo);
+            if (board.isKingInCheck(attacked))
+            {
+                std::vector<chessMove> replies;
+                board.generateLegalMoves(replies);
+                mate = replies.empty();
+            }
+            board.unmakeMove(moves[i], undo);
+        }
+        proof = mate ? 0 : infiniteNumber;
+        disproof = mate ? infiniteNumber : 0;
+        store(key, proof, disproof, 1);
+        return;
+    }
+
+    struct child
+    {
+        chessMove move;
+        uint64_t key;
+        uint32_t proof;
+        uint32_t disproof;
+    };
+    std::vector<child> children;
+    children.reserve(moves.size());
+    int childMovesLeft = orNode ? movesLeft - 1 : movesLeft;
+    for (const chessMove &move : moves)
+    {
+        moveUndo undo;
+        board.makeMove(move, undo);
+        children.push_back({move, nodeKey(board.positionKey(), childMovesLeft, !orNode), 1, 1});
+        board.unmakeMove(move, undo);
+    }
+
+    bool shared = threads.size() > 1;
+    uint32_t phi = 0;
+    uint32_t delta = 0;
+    while (true)
+    {
+        phi = infiniteNumber;
+        delta = 0;
+        size_t best = 0;
+        uint32_t bestDelta = infiniteNumber;
+        uint32_t bestPhi = 0;
+        uint32_t secondDelta = infiniteNumber;
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            // the table is newer when another thread has been in this child
+            lookup(children[i].key, children[i].proof, children[i].disproof);
+            // the child's own phi and delta, it is the other kind of node
+            uint32_t childPhi = orNode ? children[i].disproof : children[i].proof;
+            uint32_t childDelta = orNode ? children[i].proof : children[i].disproof;
+            phi = std::min(phi, childDelta);
+            delta = saturatingAdd(delta, childPhi);
+
+            // children other threads are inside look worse, so threads spread out
+            uint32_t selectDelta = childDelta;
+            if (shared && childDelta != 0 && childDelta < infiniteNumber)
+            {
+                selectDelta = saturatingAdd(childDelta, busy[children[i].key & (busySlots - 1)].load(std::memory_order_relaxed));
+            }
+            if (selectDelta < bestDelta)
+            {
+                secondDelta = bestDelta;
+                bestDelta = selectDelta;
+                bestPhi = childPhi;
+                best = i;
+            }
+            else if (selectDelta < secondDelta)
+            {
+                secondDelta = selectDelta;
+            }
+        }
+
+        if (phi >= phiThreshold || delta >= deltaThreshold || shouldStop(thread))
+        {
+            break;
+        }
+
+        // the 1 + 1/4 trick: stay in the best child a little longer before switching back
+        int64_t childPhiThreshold = static_cast<int64_t>(deltaThreshold) + bestPhi - delta;
+        int64_t childDeltaThreshold = std::min<int64_t>(phiThreshold, std::max<int64_t>(secondDelta + 1, secondDelta + secondDelta / 4));
+
+        moveUndo undo;
+        std::atomic<uint8_t> &busyCount = busy[children[best].key & (busySlots - 1)];
+        if (shared)
+        {
+            busyCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        board.makeMove(children[best].move, undo);
+        search(thread, board, children[best].key, !orNode, childMovesLeft, clampThreshold(childPhiThreshold),
+               clampThreshold(childDeltaThreshold), children[best].proof, children[best].disproof);
+        board.unmakeMove(children[best].move, undo);
+        if (shared)
+        {
+            busyCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    proof = orNode ? phi : delta;
+    disproof = orNode ? delta : phi;
+    store(key, proof, disproof, thread.nodes - startNodes + 1);
+}
+
+mateStatus mateSolver::solveFixed(chessBoard &board, int movesLeft)
+{
+    TRACE_ZONE("mateSolver::solveFixed");
+    rootSolved.store(false, std::memory_order_relaxed);
+    uint64_t rootKey = nodeKey(board.positionKey(), movesLeft, true);
+    std::atomic<int> status{static_cast<int>(mateStatus::UNKNOWN)};
+
+    auto work = [this, rootKey, movesLeft, &status](threadContext &thread, chessBoard &position)
+    {
+        uint32_t proof = 1, disproof = 1;
+        while (!stopRequested.load(std::memory_order_relaxed) && !rootSolved.load(std::memory_order_relaxed))
+        {
+            search(thread, position, rootKey, true, movesLeft, infiniteNumber, infiniteNumber, proof, disproof);
+            if (proof == 0 || disproof == 0)
+            {
+                status.store(static_cast<int>(proof == 0 ? mateStatus::PROVEN : mateStatus::DISPROVEN), std::memory_order_relaxed);
+                rootSolved.store(true, std::memory_order_relaxed);
+            }
+        }
+        thread.publishedNodes.store(thread.nodes, std::memory_order_relaxed);
+    };
+
+    std::vector<std::unique_ptr<chessBoard>> helperBoards;
+    std::vector<std::thread> helpers;
+    std::string fen = board.toFEN();
+    for (size_t i = 1; i < threads.size(); i++)
+    {
+        helperBoards.push_back(std::make_unique<chessBoard>());
+        helperBoards.back()->loadFEN(fen);
+        threadContext *thread = threads[i].get();
+        chessBoard *helperBoard = helperBoards.back().get();
+        helpers.emplace_back([&work, thread, helperBoard]()
+                             {
+            TRACE_THREAD("mate helper");
+            work(*thread, *helperBoard); });
+    }
+    work(*threads[0], board);
+    for (std::thread &helper : helpers)
+    {
+        helper.join();
+    }
+
+    return static_cast<mateStatus>(status.load(std::memory_order_relaxed));
+}
+
+// follows proven children: any mating move for the attacker, the defence with the
+// largest subtree for the defender. stops early if an entry was overwritten
+void mateSolver::extractLine(chessBoard &board, int movesLeft, std::vector<chessMove> &line) const
+{
+    std::vector<std::pair<chessMove, std::unique_ptr<moveUndo>>> played;
+    bool orNode = true;
+    while (movesLeft > 0 || !orNode)
+    {
+        std::vector<chessMove> moves;
+        board.generateLegalMoves(moves);
+        int childMovesLeft = orNode ? movesLeft - 1 : movesLeft;
+        chessMove chosen;
+        int chosenWork = -1;
+        for (const chessMove &move : moves)
+        {
+            moveUndo undo;
+            board.makeMove(move, undo);
+            uint64_t childKey = nodeKey(board.positionKey(), childMovesLeft, !orNode);
+            uint32_t proof, disproof;
+            bool proven = lookup(childKey, proof, disproof) && proof == 0;
+            if (orNode && childMovesLeft == 0 && !proven)
+            {
+                // mating moves are leaves and may have been replaced, look at the board instead
+                std::vector<chessMove> replies;
+                board.generateLegalMoves(replies);
+                proven = replies.empty() && board.isKingInCheck(board.getPlayerTurn());
+            }
+            int childWork = lookupWork(childKey);
+            board.unmakeMove(move, undo);
+            if (!proven)
+            {
+                continue;
+            }
+            if (orNode ? chosen.isNull() : childWork > chosenWork)
+            {
+                chosen = move;
+                chosenWork = childWork;
+            }
+        }
+        if (chosen.isNull())
+        {
+            break;
+        }
+        line.push_back(chosen);
+        played.emplace_back(chosen, std::make_unique<moveUndo>());
+        board.makeMove(chosen, *played.back().second);
+        movesLeft = childMovesLeft;
+        orNode = !orNode;
+    }
+    for (auto it = played.rbegin(); it != played.rend(); ++it)
+    {
+        board.unmakeMove(it->first, *it->second);
+    }
+}
+
+mateResult mateSolver::solve(chessBoard &board, const mateLimits &limits)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    stopRequested.store(false, std::memory_order_relaxed);
+    nodeLimit = limits.maxNodes;
+    hasDeadline = limits.timeMs > 0;
+    deadline = startTime + std::chrono::milliseconds(limits.timeMs);
+    table.clear();
+    for (auto &thread : threads)
+    {
+        thread->nodes = 0;
+        thread->publishedNodes.store(0, std::memory_order_relaxed);
+    }
+
+    mateResult result;
+    result.status = mateStatus::DISPROVEN;
+    for (int moves = 1; moves <= limits.maxMoves; moves++)
+    {
+        result.mateIn = moves;
+        mateStatus status = solveFixed(board, moves);
+        if (status == mateStatus::PROVEN)
+        {
+            result.status = status;
+            extractLine(board, moves, result.line);
+            break;
+        }
+        if (status == mateStatus::UNKNOWN)
+        {
+            result.status = status;
+            break;
+        }
+    }
+
+    result.nodes = totalNodes();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return result;
+}
+
+mateWorker::~mateWorker()
+{
+    cancel();
+}
+
+bool mateWorker::start(const std::string &fen, const mateLimits &limits)
+{
+    if (isBusy())
+    {
+        return false;
+    }
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+
+    auto board = std::make_unique<chessBoard>();
+    if (!board->loadFEN(fen))
+    {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        resultReady = false;
+    }
+
+    startTime = std::chrono::steady_clock::now();
+    busy.store(true, std::memory_order_release);
+    thread = std::thread([this, board = std::move(board), limits]()
+                         {
+        TRACE_THREAD("mate finder");
+        mateResult found = solver.solve(*board, limits);
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            result = found;
+            resultReady = true;
+        }
+        busy.store(false, std::memory_order_release); });
+    return true;
+}
+
+void mateWorker::cancel()
+{
+    // solve() clears the stop flag when it starts, keep asking until it has finished
+    while (isBusy())
+    {
+        solver.stop();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+    std::lock_guard<std::mutex> lock(resultMutex);
+    resultReady = false;
+}
+
+bool mateWorker::takeResult(mateResult &out)
+{
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if (!resultReady)
+        {
+            return false;
+        }
+        out = result;
+        resultReady = false;
+    }
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+    return true;
+}
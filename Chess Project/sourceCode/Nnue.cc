@@ -0,0 +1,306 @@
+#include "../header_files/Nnue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#define NNUE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+// scalar kernels, always available
+
+static void addColumnScalar(int16_t *values, const int16_t *column)
+{
+    for (int i = 0; i < nnueHiddenSize; i++)
+    {
+        values[i] = static_cast<int16_t>(values[i] + column[i]);
+    }
+}
+
+static void subtractColumnScalar(int16_t *values, const int16_t *column)
+{
+    for (int i = 0; i < nnueHiddenSize; i++)
+    {
+        values[i] = static_cast<int16_t>(values[i] - column[i]);
+    }
+}
+
+static int32_t clippedDotScalar(const int16_t *values, const int8_t *weights)
+{
+    int32_t sum = 0;
+    for (int i = 0; i < nnueHiddenSize; i++)
+    {
+        sum += std::min<int32_t>(std::max<int32_t>(values[i], 0), 127) * weights[i];
+    }
+    return sum;
+}
+
+#ifdef NNUE_X86_KERNELS
+// compiled for the target instruction set per function, so the rest of the program
+// still runs on CPUs without it; only called after the runtime check
+
+__attribute__((target("sse4.1"))) static void addColumnSse41(int16_t *values, const int16_t *column)
+{
+    for (int i = 0; i < nnueHiddenSize; i += 8)
+    {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(values + i));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(column + i));
+        _mm_store_si128(reinterpret_cast<__m128i *>(values + i), _mm_add_epi16(v, c));
+    }
+}
+
+__attribute__((target("sse4.1"))) static void subtractColumnSse41(int16_t *values, const int16_t *column)
+{
+    for (int i = 0; i < nnueHiddenSize; i += 8)
+    {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(values + i));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(column + i));
+        _mm_store_si128(reinterpret_cast<__m128i *>(values + i), _mm_sub_epi16(v, c));
+    }
+}
+
+__attribute__((target("sse4.1"))) static int32_t clippedDotSse41(const int16_t *values, const int8_t *weights)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i limit = _mm_set1_epi16(127);
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < nnueHiddenSize; i += 16)
+    {
+        __m128i low = _mm_load_si128(reinterpret_cast<const __m128i *>(values + i));
+        __m128i high = _mm_load_si128(reinterpret_cast<const __m128i *>(values + i + 8));
+        low = _mm_min_epi16(_mm_max_epi16(low, zero), limit);
+        high = _mm_min_epi16(_mm_max_epi16(high, zero), limit);
+        __m128i activations = _mm_packus_epi16(low, high);
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i));
+        // 127 * 127 * 2 still fits the int16 pairs maddubs produces
+        __m128i products = _mm_maddubs_epi16(activations, w);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("avx2"))) static void addColumnAvx2(int16_t *values, const int16_t *column)
+{
+    for (int i = 0; i < nnueHiddenSize; i += 16)
+    {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(column + i));
+        _mm256_store_si256(reinterpret_cast<__m256i *>(values + i), _mm256_add_epi16(v, c));
+    }
+}
+
+__attribute__((target("avx2"))) static void subtractColumnAvx2(int16_t *values, const int16_t *column)
+{
+    for (int i = 0; i < nnueHiddenSize; i += 16)
+    {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(column + i));
+        _mm256_store_si256(reinterpret_cast<__m256i *>(values + i), _mm256_sub_epi16(v, c));
+    }
+}
+
+__attribute__((target("avx2"))) static int32_t clippedDotAvx2(const int16_t *values, const int8_t *weights)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i limit = _mm256_set1_epi16(127);
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < nnueHiddenSize; i += 32)
+    {
+        __m256i low = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i));
+        __m256i high = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i + 16));
+        low = _mm256_min_epi16(_mm256_max_epi16(low, zero), limit);
+        high = _mm256_min_epi16(_mm256_max_epi16(high, zero), limit);
+        // packus works per 128 bit lane, the permute puts the bytes back in order
+        __m256i activations = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i));
+        __m256i products = _mm256_maddubs_epi16(activations, w);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    return _mm_cvtsi128_si32(half);
+}
+#endif
+
+bool nnueNetwork::isKernelSupported(nnueKernel kernel)
+{
+    switch (kernel)
+    {
+    case nnueKernel::SCALAR:
+        return true;
+#ifdef NNUE_X86_KERNELS
+    case nnueKernel::SSE41:
+        return __builtin_cpu_supports("sse4.1");
+    case nnueKernel::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+const char *nnueNetwork::kernelName(nnueKernel kernel)
+{
+    switch (kernel)
+    {
+    case nnueKernel::SSE41:
+        return "sse4.1";
+    case nnueKernel::AVX2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+bool nnueNetwork::selectKernel(nnueKernel requested)
+{
+    if (!isKernelSupported(requested))
+    {
+        return false;
+    }
+    kernel = requested;
+    addColumn = addColumnScalar;
+    subtractColumn = subtractColumnScalar;
+    clippedDot = clippedDotScalar;
+#ifdef NNUE_X86_KERNELS
+    if (requested == nnueKernel::SSE41)
+    {
+        addColumn = addColumnSse41;
+        subtractColumn = subtractColumnSse41;
+        clippedDot = clippedDotSse41;
+    }
+    else if (requested == nnueKernel::AVX2)
+    {
+        addColumn = addColumnAvx2;
+        subtractColumn = subtractColumnAvx2;
+        clippedDot = clippedDotAvx2;
+    }
+#endif
+    return true;
+}
+
+nnueNetwork::nnueNetwork()
+    : featureBias(nnueHiddenSize), featureWeights(size_t(nnueInputSize) * nnueHiddenSize), outputWeights(2 * nnueHiddenSize)
+{
+    for (nnueKernel candidate : {nnueKernel::AVX2, nnueKernel::SSE41, nnueKernel::SCALAR})
+    {
+        if (selectKernel(candidate))
+        {
+            break;
+        }
+    }
+}
+
+template <typename T>
+static bool readValues(std::ifstream &in, T *values, size_t count)
+{
+    // the file is little endian like every platform we build for
+    in.read(reinterpret_cast<char *>(values), static_cast<std::streamsize>(count * sizeof(T)));
+    return static_cast<bool>(in);
+}
+
+template <typename T>
+static void writeValues(std::ofstream &out, const T *values, size_t count)
+{
+    out.write(reinterpret_cast<const char *>(values), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+bool nnueNetwork::load(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        return false;
+    }
+
+    char magic[4];
+    uint32_t hiddenSize = 0;
+    in.read(magic, 4);
+    if (!readValues(in, &hiddenSize, 1) || std::memcmp(magic, "CNN1", 4) != 0 || hiddenSize != nnueHiddenSize)
+    {
+        std::cerr << "Unsupported network file: " << path << std::endl;
+        return false;
+    }
+    if (!readValues(in, featureBias.data(), featureBias.size()) ||
+        !readValues(in, featureWeights.data(), featureWeights.size()) ||
+        !readValues(in, outputWeights.data(), outputWeights.size()) ||
+        !readValues(in, &outputBias, 1) || !readValues(in, &outputDivisor, 1) || outputDivisor == 0)
+    {
+        std::cerr << "Truncated network file: " << path << std::endl;
+        loaded = false;
+        return false;
+    }
+    loaded = true;
+    return true;
+}
+
+bool nnueNetwork::save(const std::string &path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        std::cerr << "Could not write " << path << std::endl;
+        return false;
+    }
+    uint32_t hiddenSize = nnueHiddenSize;
+    out.write("CNN1", 4);
+    writeValues(out, &hiddenSize, 1);
+    writeValues(out, featureBias.data(), featureBias.size());
+    writeValues(out, featureWeights.data(), featureWeights.size());
+    writeValues(out, outputWeights.data(), outputWeights.size());
+    writeValues(out, &outputBias, 1);
+    writeValues(out, &outputDivisor, 1);
+    return static_cast<bool>(out);
+}
+
+void nnueNetwork::randomize(uint64_t seed)
+{
+    uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    auto next = [&state](int range)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<int>(state % (2 * range + 1)) - range;
+    };
+
+    // small enough that 32 pieces can't overflow an int16 sum
+    for (int16_t &value : featureBias)
+    {
+        value = static_cast<int16_t>(next(64) + 32);
+    }
+    for (int16_t &value : featureWeights)
+    {
+        value = static_cast<int16_t>(next(40));
+    }
+    for (int8_t &value : outputWeights)
+    {
+        value = static_cast<int8_t>(next(127));
+    }
+    outputBias = 0;
+    outputDivisor = 256;
+    loaded = true;
+}
+
+void nnueNetwork::resetAccumulator(nnueAccumulator &accumulator) const
+{
+    for (int perspective = 0; perspective < 2; perspective++)
+    {
+        std::copy(featureBias.begin(), featureBias.end(), accumulator.values[perspective]);
+    }
+}
+
+int nnueNetwork::evaluate(const nnueAccumulator &accumulator, int sideToMove) const
+{
+    int32_t sum = clippedDot(accumulator.values[sideToMove], outputWeights.data()) +
+                  clippedDot(accumulator.values[sideToMove ^ 1], outputWeights.data() + nnueHiddenSize);
+    return (sum + outputBias) / outputDivisor;
+}
@@ -0,0 +1,206 @@
+#include "../header_files/PositionCache.h"
+
+#include <algorithm>
+#include <climits>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+positionCache::positionCache(size_t megabytes, bool useHugePages)
+{
+    resize(megabytes, useHugePages);
+}
+
+positionCache::~positionCache()
+{
+    release();
+}
+
+void positionCache::release()
+{
+    if (!buckets)
+    {
+        return;
+    }
+#ifdef _WIN32
+    VirtualFree(buckets, 0, MEM_RELEASE);
+#else
+    munmap(buckets, allocatedBytes);
+#endif
+    buckets = nullptr;
+    bucketMask = 0;
+    allocatedBytes = 0;
+    hugePages = false;
+}
+
+bool positionCache::resize(size_t megabytes, bool useHugePages)
+{
+    release();
+
+    size_t count = 1;
+    while (count * 2 * sizeof(bucket) <= std::max<size_t>(megabytes, 1) * 1024 * 1024)
+    {
+        count *= 2;
+    }
+    size_t bytes = count * sizeof(bucket);
+    void *memory = nullptr;
+
+    // page allocations are zero filled and aligned far beyond the 64 bytes a bucket needs
+#ifdef _WIN32
+    if (useHugePages)
+    {
+        // needs the "lock pages in memory" privilege, silently falls back without it
+        size_t largePage = GetLargePageMinimum();
+        if (largePage)
+        {
+            size_t rounded = (bytes + largePage - 1) / largePage * largePage;
+            memory = VirtualAlloc(nullptr, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (memory)
+            {
+                bytes = rounded;
+                hugePages = true;
+            }
+        }
+    }
+    if (!memory)
+    {
+        memory = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+#else
+    if (useHugePages)
+    {
+#ifdef MAP_HUGETLB
+        const size_t hugePageSize = 2 * 1024 * 1024;
+        size_t rounded = (bytes + hugePageSize - 1) / hugePageSize * hugePageSize;
+        memory = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            memory = nullptr;
+        }
+        else
+        {
+            bytes = rounded;
+            hugePages = true;
+        }
+#endif
+    }
+    if (!memory)
+    {
+        memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            memory = nullptr;
+        }
+#ifdef MADV_HUGEPAGE
+        // no reserved huge pages: ask for transparent ones instead
+        else if (useHugePages && madvise(memory, bytes, MADV_HUGEPAGE) == 0)
+        {
+            hugePages = true;
+        }
+#endif
+    }
+#endif
+
+    if (!memory)
+    {
+        return false;
+    }
+
+    buckets = static_cast<bucket *>(memory);
+    bucketMask = count - 1;
+    allocatedBytes = bytes;
+    for (size_t i = 0; i < count; i++)
+    {
+        new (&buckets[i]) bucket;
+    }
+    clear();
+    return true;
+}
+
+void positionCache::clear()
+{
+    for (uint64_t i = 0; i <= bucketMask && buckets; i++)
+    {
+        for (entry &slot : buckets[i].entries)
+        {
+            slot.keyXorData.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 1;
+}
+
+bool positionCache::probe(uint64_t key, uint64_t &payload, int &priority) const
+{
+    const bucket &target = buckets[key & bucketMask];
+    for (const entry &slot : target.entries)
+    {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if (data && (slot.keyXorData.load(std::memory_order_relaxed) ^ data) == key)
+        {
+            payload = data & payloadMask;
+            priority = static_cast<int>((data >> payloadBits) & 0xFF);
+            return true;
+        }
+    }
+    return false;
+}
+
+void positionCache::store(uint64_t key, uint64_t payload, int priority)
+{
+    bucket &target = buckets[key & bucketMask];
+    uint64_t data = (payload & payloadMask) | (uint64_t(std::min(std::max(priority, 0), 255)) << payloadBits) |
+                    (uint64_t(generation) << (payloadBits + 8));
+
+    // the same position is always overwritten, otherwise an empty entry is taken
+    // or the one least worth keeping: low priority, several generations old
+    entry *victim = nullptr;
+    int victimWorth = INT_MAX;
+    for (entry &slot : target.entries)
+    {
+        uint64_t old = slot.data.load(std::memory_order_relaxed);
+        if (old && (slot.keyXorData.load(std::memory_order_relaxed) ^ old) == key)
+        {
+            victim = &slot;
+            break;
+        }
+
+        int worth = INT_MIN;
+        if (old)
+        {
+            int oldGeneration = static_cast<int>(old >> (payloadBits + 8));
+            int age = (generation - oldGeneration + 255) % 255;
+            worth = static_cast<int>((old >> payloadBits) & 0xFF) - 8 * age;
+        }
+        if (worth < victimWorth)
+        {
+            victimWorth = worth;
+            victim = &slot;
+        }
+    }
+
+    victim->keyXorData.store(key ^ data, std::memory_order_relaxed);
+    victim->data.store(data, std::memory_order_relaxed);
+}
+
+int positionCache::hashfull() const
+{
+    uint64_t sampled = std::min<uint64_t>(1000, bucketMask + 1);
+    int used = 0;
+    for (uint64_t i = 0; i < sampled; i++)
+    {
+        for (const entry &slot : buckets[i].entries)
+        {
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if (data && (data >> (payloadBits + 8)) == generation)
+            {
+                used++;
+            }
+        }
+    }
+    return static_cast<int>(used * 1000 / (sampled * entriesPerBucket));
+}
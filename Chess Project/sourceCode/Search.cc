@@ -0,0 +1,915 @@
+#include "../header_files/Search.h"
+#include "../header_files/Tablebase.h"
+#include "../header_files/Trace.h"
+
+#include <algorithm>
+#include <cstring>
+
+// material in centipawns, indexed by pieceType
+static const int pieceValues[6] = {0, 900, 500, 330, 320, 100};
+
+// piece-square tables for white, written from rank 8 down to rank 1 so that
+// they are indexed like the board (row * 8 + column), black reads them mirrored
+static const int pawnTable[64] = {
+    0, 0, 0, 0, 0, 0, 0, 0,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    10, 10, 20, 30, 30, 20, 10, 10,
+    5, 5, 10, 25, 25, 10, 5, 5,
+    0, 0, 0, 20, 20, 0, 0, 0,
+    5, -5, -10, 0, 0, -10, -5, 5,
+    5, 10, 10, -20, -20, 10, 10, 5,
+    0, 0, 0, 0, 0, 0, 0, 0};
+
+static const int knightTable[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20, 0, 0, 0, 0, -20, -40,
+    -30, 0, 10, 15, 15, 10, 0, -30,
+    -30, 5, 15, 20, 20, 15, 5, -30,
+    -30, 0, 15, 20, 20, 15, 0, -30,
+    -30, 5, 10, 15, 15, 10, 5, -30,
+    -40, -20, 0, 5, 5, 0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50};
+
+static const int bishopTable[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10, 0, 0, 0, 0, 0, 0, -10,
+    -10, 0, 5, 10, 10, 5, 0, -10,
+    -10, 5, 5, 10, 10, 5, 5, -10,
+    -10, 0, 10, 10, 10, 10, 0, -10,
+    -10, 10, 10, 10, 10, 10, 10, -10,
+    -10, 5, 0, 0, 0, 0, 5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20};
+
+static const int rookTable[64] = {
+    0, 0, 0, 0, 0, 0, 0, 0,
+    5, 10, 10, 10, 10, 10, 10, 5,
+    -5, 0, 0, 0, 0, 0, 0, -5,
+    -5, 0, 0, 0, 0, 0, 0, -5,
+    -5, 0, 0, 0, 0, 0, 0, -5,
+    -5, 0, 0, 0, 0, 0, 0, -5,
+    -5, 0, 0, 0, 0, 0, 0, -5,
+    0, 0, 0, 5, 5, 0, 0, 0};
+
+static const int queenTable[64] = {
+    -20, -10, -10, -5, -5, -10, -10, -20,
+    -10, 0, 0, 0, 0, 0, 0, -10,
+    -10, 0, 5, 5, 5, 5, 0, -10,
+    -5, 0, 5, 5, 5, 5, 0, -5,
+    0, 0, 5, 5, 5, 5, 0, -5,
+    -10, 5, 5, 5, 5, 5, 0, -10,
+    -10, 0, 5, 0, 0, 0, 0, -10,
+    -20, -10, -10, -5, -5, -10, -10, -20};
+
+static const int kingMiddlegameTable[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+    20, 20, 0, 0, 0, 0, 20, 20,
+    20, 30, 10, 0, 0, 10, 30, 20};
+
+static const int kingEndgameTable[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10, 0, 0, -10, -20, -30,
+    -30, -10, 20, 30, 30, 20, -10, -30,
+    -30, -10, 30, 40, 40, 30, -10, -30,
+    -30, -10, 30, 40, 40, 30, -10, -30,
+    -30, -10, 20, 30, 30, 20, -10, -30,
+    -30, -30, 0, 0, 0, 0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50};
+
+// how much each piece counts towards the middlegame, 24 with all pieces on
+static const int phaseWeights[6] = {0, 4, 2, 1, 1, 0};
+
+// payload layout: move in bits 0-15, score 16-31, bound 32-39
+bool transpositionTable::probe(uint64_t key, entry &out) const
+{
+    uint64_t payload;
+    int priority;
+    if (!cache.probe(key, payload, priority))
+    {
+        return false;
+    }
+    out.move = static_cast<uint16_t>(payload);
+    out.score = static_cast<int16_t>(payload >> 16);
+    out.bound = static_cast<uint8_t>(payload >> 32);
+    out.depth = static_cast<int8_t>(priority);
+    return out.bound != BOUND_NONE;
+}
+
+void transpositionTable::store(uint64_t key, chessMove move, int score, int depth, boundType bound)
+{
+    // keep a deeper result for the same position unless the new one is exact
+    entry old;
+    if (probe(key, old))
+    {
+        if (old.depth > depth && bound != BOUND_EXACT)
+        {
+            return;
+        }
+        if (move.isNull())
+        {
+            move.data = old.move;
+        }
+    }
+    uint64_t payload = uint64_t(move.data) | (uint64_t(static_cast<uint16_t>(score)) << 16) | (uint64_t(bound) << 32);
+    cache.store(key, payload, depth);
+}
+
+// mate scores are stored relative to the node, not to the root
+static int scoreToTable(int score, int ply)
+{
+    return score >= mateBound ? score + ply : score <= -mateBound ? score - ply : score;
+}
+
+static int scoreFromTable(int score, int ply)
+{
+    return score >= mateBound ? score - ply : score <= -mateBound ? score + ply : score;
+}
+
+// a win found closer to the root scores higher, like a mate
+static int tablebaseScore(wdlResult result, int ply)
+{
+    return result == wdlResult::WIN ? tablebaseWinScore - ply : result == wdlResult::LOSS ? -tablebaseWinScore + ply : 0;
+}
+
+chessSearch::chessSearch(size_t hashMegabytes, int threadCount) : table(hashMegabytes)
+{
+    setThreads(threadCount);
+}
+
+void chessSearch::setThreads(int threadCount)
+{
+    threads.clear();
+    for (int i = 0; i < std::max(1, threadCount); i++)
+    {
+        threads.push_back(std::make_unique<threadState>());
+        threads.back()->id = i;
+    }
+    clear();
+}
+
+void chessSearch::clear()
+{
+    table.clear();
+    for (auto &thread : threads)
+    {
+        std::memset(thread->history, 0, sizeof(thread->history));
+        for (auto &slot : thread->killers)
+        {
+            slot[0] = chessMove();
+            slot[1] = chessMove();
+        }
+    }
+}
+
+uint64_t chessSearch::totalNodes() const
+{
+    uint64_t total = 0;
+    for (const auto &thread : threads)
+    {
+        total += thread->publishedNodes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+int chessSearch::evaluate(const chessBoard &board)
+{
+    if (board.getNetwork())
+    {
+        return board.evaluateNetwork();
+    }
+
+    int middlegame = 0;
+    int endgame = 0;
+    int phase = 0;
+
+    for (int row = 0; row < 8; row++)
+    {
+        for (int col = 0; col < 8; col++)
+        {
+            const Piece *piece = board.getPieceAt(row, col);
+            if (!piece)
+            {
+                continue;
+            }
+            bool white = piece->getColor() == Color::WHITE;
+            int square = white ? row * 8 + col : (7 - row) * 8 + col;
+            int type = static_cast<int>(piece->getType());
+            int middle = pieceValues[type];
+            int end = pieceValues[type];
+
+            switch (piece->getType())
+            {
+            case pieceType::PAWN:
+                middle += pawnTable[square];
+                end += pawnTable[square];
+                break;
+            case pieceType::KNIGHT:
+                middle += knightTable[square];
+                end += knightTable[square];
+                break;
+            case pieceType::BISHOP:
+                middle += bishopTable[square];
+                end += bishopTable[square];
+                break;
+            case pieceType::ROOK:
+                middle += rookTable[square];
+                end += rookTable[square];
+                break;
+            case pieceType::QUEEN:
+                middle += queenTable[square];
+                end += queenTable[square];
+                break;
+            case pieceType::KING:
+                middle += kingMiddlegameTable[square];
+                end += kingEndgameTable[square];
+                break;
+            }
+
+            phase += phaseWeights[type];
+            middlegame += white ? middle : -middle;
+            endgame += white ? end : -end;
+        }
+    }
+
+    // blend towards the endgame tables as pieces come off
+    phase = std::min(phase, 24);
+    int score = (middlegame * phase + endgame * (24 - phase)) / 24;
+    return board.getPlayerTurn() == Color::WHITE ? score : -score;
+}
+
+bool chessSearch::shouldStop(threadState &thread)
+{
+    if ((thread.nodes & 1023) == 0)
+    {
+        thread.publishedNodes.store(thread.nodes, std::memory_order_relaxed);
+        if (hasDeadline && std::chrono::steady_clock::now() >= deadline)
+        {
+            stopRequested.store(true, std::memory_order_relaxed);
+        }
+        // the node limit covers all threads together, the main thread watches it
+        if (nodeLimit && thread.id == 0 && totalNodes() >= nodeLimit)
+        {
+            stopRequested.store(true, std::memory_order_relaxed);
+        }
+    }
+    return stopRequested.load(std::memory_order_relaxed);
+}
+
+// hash move first, then captures by most valuable victim / least valuable attacker,
+// then killer moves and finally quiet moves by their history score
+void chessSearch::orderMoves(const threadState &thread, const chessBoard &board, std::vector<chessMove> &moves, chessMove hashMove, int ply) const
+{
+    int side = board.getPlayerTurn() == Color::WHITE ? 0 : 1;
+    std::vector<std::pair<int, chessMove>> scored;
+    scored.reserve(moves.size());
+
+    for (const chessMove &move : moves)
+    {
+        int score;
+        const Piece *mover = board.getPieceAt(move.fromRow(), move.fromColumn());
+        const Piece *victim = board.getPieceAt(move.toRow(), move.toColumn());
+        if (move == hashMove)
+        {
+            score = 1 << 30;
+        }
+        else if (victim || board.isCapture(move))
+        {
+            int victimValue = victim ? pieceValues[static_cast<int>(victim->getType())] : pieceValues[static_cast<int>(pieceType::PAWN)];
+            score = (1 << 28) + victimValue * 16 - pieceValues[static_cast<int>(mover->getType())] / 16;
+        }
+        else if (move.isPromotion())
+        {
+            score = (1 << 28) + pieceValues[static_cast<int>(move.promotion())];
+        }
+        else if (move == thread.killers[ply][0])
+        {
+            score = (1 << 27) + 1;
+        }
+        else if (move == thread.killers[ply][1])
+        {
+            score = 1 << 27;
+        }
+        else
+        {
+            score = thread.history[side][move.fromRow() * 8 + move.fromColumn()][move.toRow() * 8 + move.toColumn()];
+        }
+        scored.emplace_back(score, move);
+    }
+
+    std::stable_sort(scored.begin(), scored.end(), [](const std::pair<int, chessMove> &a, const std::pair<int, chessMove> &b)
+                     { return a.first > b.first; });
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        moves[i] = scored[i].second;
+    }
+}
+
+int chessSearch::quiescence(threadState &thread, chessBoard &board, int ply, int alpha, int beta)
+{
+    thread.nodes++;
+    if (shouldStop(thread))
+    {
+        return 0;
+    }
+
+    bool inCheck = board.isKingInCheck(board.getPlayerTurn());
+    int bestScore = -infiniteScore;
+    int standPat = 0;
+
+    // outside of check the side to move may decline every capture
+    if (!inCheck)
+    {
+        standPat = evaluate(board);
+        if (standPat >= beta || ply >= maxSearchPly - 1)
+        {
+            return standPat;
+        }
+        alpha = std::max(alpha, standPat);
+        bestScore = standPat;
+    }
+
+    std::vector<chessMove> moves;
+    board.generateLegalMoves(moves);
+    if (moves.empty())
+    {
+        return inCheck ? -mateScore + ply : 0;
+    }
+    if (!inCheck)
+    {
+        moves.erase(std::remove_if(moves.begin(), moves.end(), [&board](const chessMove &move)
+                                   { return !board.isCapture(move) && !move.isPromotion(); }),
+                    moves.end());
+    }
+    orderMoves(thread, board, moves, chessMove(), ply);
+
+    moveUndo undo;
+    for (const chessMove &move : moves)
+    {
+        // delta pruning: even winning this piece for free can't reach alpha
+        if (!inCheck && !move.isPromotion())
+        {
+            const Piece *victim = board.getPieceAt(move.toRow(), move.toColumn());
+            int gain = victim ? pieceValues[static_cast<int>(victim->getType())] : pieceValues[static_cast<int>(pieceType::PAWN)];
+            if (standPat + gain + 200 <= alpha)
+            {
+                continue;
+            }
+        }
+
+        board.makeMove(move, undo);
+        int score = -quiescence(thread, board, ply + 1, -beta, -alpha);
+        board.unmakeMove(move, undo);
+
+        if (stopRequested.load(std::memory_order_relaxed))
+        {
+            return 0;
+        }
+        if (score > bestScore)
+        {
+            bestScore = score;
+            if (score > alpha)
+            {
+                alpha = score;
+                if (alpha >= beta)
+                {
+                    break;
+                }
+            }
+        }
+    }
+    return bestScore;
+}
+
+int chessSearch::negamax(threadState &thread, chessBoard &board, int depth, int ply, int alpha, int beta, std::vector<chessMove> &pv)
+{
+    pv.clear();
+    uint64_t key = board.positionKey();
+    table.prefetch(key);
+
+    if (ply > 0)
+    {
+        // fifty move rule and repetitions of positions on the current line count as draws
+        if (board.halfmoveClock >= 100)
+        {
+            return 0;
+        }
+        int size = static_cast<int>(thread.pathKeys.size());
+        for (int i = size - 2; i >= 0 && size - i <= board.halfmoveClock; i -= 2)
+        {
+            if (thread.pathKeys[i] == key)
+            {
+                return 0;
+            }
+        }
+
+        // no line from here can beat a mate we have already found closer to the root
+        alpha = std::max(alpha, -mateScore + ply);
+        beta = std::min(beta, mateScore - ply - 1);
+        if (alpha >= beta)
+        {
+            return alpha;
+        }
+
+        // the exact result once the tables cover the position. probed after captures and
+        // pawn moves only, that is when the material changes and the fifty move count
+        // starts over, so that the fifty move rule can't turn the result
+        if (probeEndgames && board.halfmoveClock == 0 && board.pieceCount() <= endgamePieces)
+        {
+            wdlResult known = board.probeEndgame();
+            if (known != wdlResult::UNKNOWN)
+            {
+                return tablebaseScore(known, ply);
+            }
+        }
+    }
+
+    bool inCheck = board.isKingInCheck(board.getPlayerTurn());
+    if (inCheck)
+    {
+        depth++;
+    }
+    if (depth <= 0)
+    {
+        return quiescence(thread, board, ply, alpha, beta);
+    }
+
+    thread.nodes++;
+    if (shouldStop(thread))
+    {
+        return 0;
+    }
+
+    chessMove hashMove;
+    transpositionTable::entry hit;
+    if (table.probe(key, hit))
+    {
+        hashMove.data = hit.move;
+        int score = scoreFromTable(hit.score, ply);
+        if (ply > 0 && hit.depth >= depth &&
+            (hit.bound == transpositionTable::BOUND_EXACT ||
+             (hit.bound == transpositionTable::BOUND_LOWER && score >= beta) ||
+             (hit.bound == transpositionTable::BOUND_UPPER && score <= alpha)))
+        {
+            return score;
+        }
+    }
+    if (ply >= maxSearchPly - 1)
+    {
+        return evaluate(board);
+    }
+
+    std::vector<chessMove> moves;
+    board.generateLegalMoves(moves);
+    if (moves.empty())
+    {
+        return inCheck ? -mateScore + ply : 0;
+    }
+    // multi-PV: the root moves of the lines already found sit this search out, and so do
+    // the ones the endgame tables say give the result away
+    bool excluding = ply == 0 && (!thread.excludedRootMoves.empty() || !tablebaseLosingMoves.empty());
+    if (excluding)
+    {
+        moves.erase(std::remove_if(moves.begin(), moves.end(), [this, &thread](const chessMove &move)
+                                   { return std::find(thread.excludedRootMoves.begin(), thread.excludedRootMoves.end(), move) !=
+                                                thread.excludedRootMoves.end() ||
+                                            std::find(tablebaseLosingMoves.begin(), tablebaseLosingMoves.end(), move) !=
+                                                tablebaseLosingMoves.end(); }),
+                    moves.end());
+        if (moves.empty())
+        {
+            return -infiniteScore;
+        }
+    }
+    orderMoves(thread, board, moves, hashMove, ply);
+
+    int side = board.getPlayerTurn() == Color::WHITE ? 0 : 1;
+    int originalAlpha = alpha;
+    int bestScore = -infiniteScore;
+    chessMove bestMove;
+    std::vector<chessMove> childPv;
+    moveUndo undo;
+
+    thread.pathKeys.push_back(key);
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        const chessMove move = moves[i];
+        bool quiet = !board.isCapture(move) && !move.isPromotion();
+
+        board.makeMove(move, undo);
+        int score;
+        if (i == 0)
+        {
+            score = -negamax(thread, board, depth - 1, ply + 1, -beta, -alpha, childPv);
+        }
+        else
+        {
+            // late quiet moves are searched shallower with a null window first
+            int reduction = (depth >= 3 && i >= 3 && quiet && !inCheck) ? (i >= 8 ? 2 : 1) : 0;
+            score = -negamax(thread, board, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha, childPv);
+            if (score > alpha && reduction)
+            {
+                score = -negamax(thread, board, depth - 1, ply + 1, -alpha - 1, -alpha, childPv);
+            }
+            if (score > alpha && score < beta)
+            {
+                score = -negamax(thread, board, depth - 1, ply + 1, -beta, -alpha, childPv);
+            }
+        }
+        board.unmakeMove(move, undo);
+
+        if (stopRequested.load(std::memory_order_relaxed))
+        {
+            thread.pathKeys.pop_back();
+            return 0;
+        }
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestMove = move;
+            if (score > alpha)
+            {
+                alpha = score;
+                pv.assign(1, move);
+                pv.insert(pv.end(), childPv.begin(), childPv.end());
+                if (alpha >= beta)
+                {
+                    if (quiet)
+                    {
+                        if (thread.killers[ply][0] != move)
+                        {
+                            thread.killers[ply][1] = thread.killers[ply][0];
+                            thread.killers[ply][0] = move;
+                        }
+                        thread.history[side][move.fromRow() * 8 + move.fromColumn()][move.toRow() * 8 + move.toColumn()] += depth * depth;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    thread.pathKeys.pop_back();
+
+    // without all root moves the score is not the position's
+    if (excluding)
+    {
+        return bestScore;
+    }
+    transpositionTable::boundType bound = bestScore >= beta ? transpositionTable::BOUND_LOWER
+                                          : bestScore > originalAlpha ? transpositionTable::BOUND_EXACT
+                                                                      : transpositionTable::BOUND_UPPER;
+    table.store(key, bestMove, scoreToTable(bestScore, ply), depth, bound);
+    return bestScore;
+}
+
+// the best line is already searched, the alternatives are searched one after the other with
+// the root moves of the lines before them left out. an interrupted depth keeps what it has
+void chessSearch::searchMultiPV(threadState &thread, chessBoard &board, int depth, int multiPV, int bestScore, searchResult *result)
+{
+    std::vector<searchLine> lines;
+    lines.push_back({bestScore, result->principalVariation});
+    std::vector<chessMove> pv;
+    for (int k = 1; k < multiPV; k++)
+    {
+        thread.excludedRootMoves.clear();
+        for (const searchLine &line : lines)
+        {
+            if (!line.moves.empty())
+            {
+                thread.excludedRootMoves.push_back(line.moves[0]);
+            }
+        }
+        int score = negamax(thread, board, depth, 0, -infiniteScore, infiniteScore, pv);
+        thread.excludedRootMoves.clear();
+        if (stopRequested.load(std::memory_order_relaxed) || pv.empty())
+        {
+            break;
+        }
+        lines.push_back({score, pv});
+    }
+    // an alternative can come out above the best line when the search is unstable
+    std::stable_sort(lines.begin() + 1, lines.end(), [](const searchLine &a, const searchLine &b)
+                     { return a.score > b.score; });
+    result->lines = std::move(lines);
+}
+
+// iterative deepening for one thread, only the main thread (the one with a result) reports
+// depths; helpers with odd ids run one iteration ahead so the threads spread over two depths
+void chessSearch::iterate(threadState &thread, chessBoard &board, const searchLimits &limits, searchResult *result)
+{
+    std::vector<chessMove> pv;
+    int maxDepth = std::min(limits.maxDepth, maxSearchPly - 1);
+    for (int depth = 1 + (thread.id & 1); depth <= maxDepth; depth++)
+    {
+        TRACE_ZONE("chessSearch::iteration");
+        int score = negamax(thread, board, depth, 0, -infiniteScore, infiniteScore, pv);
+        if (!result)
+        {
+            if (stopRequested.load(std::memory_order_relaxed))
+            {
+                break;
+            }
+            continue;
+        }
+
+        // an interrupted iteration is only trusted when nothing deeper exists yet
+        if (stopRequested.load(std::memory_order_relaxed) && result->depth > 0)
+        {
+            break;
+        }
+        result->depth = depth;
+        result->score = score;
+        if (!pv.empty())
+        {
+            result->bestMove = pv[0];
+            result->principalVariation = pv;
+        }
+        searchMultiPV(thread, board, depth, limits.multiPV, score, result);
+        sharedDepth.store(depth, std::memory_order_relaxed);
+        if (iterationCallback)
+        {
+            thread.publishedNodes.store(thread.nodes, std::memory_order_relaxed);
+            result->nodes = totalNodes();
+            result->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            iterationCallback(*result);
+        }
+
+        if (stopRequested.load(std::memory_order_relaxed) || std::abs(score) >= mateScore - depth)
+        {
+            break;
+        }
+
+        // the next iteration takes longer than all earlier ones together
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        if (hasDeadline && elapsed * 2000.0 > limits.moveTimeMs)
+        {
+            break;
+        }
+    }
+    thread.publishedNodes.store(thread.nodes, std::memory_order_relaxed);
+}
+
+// with the root inside the tables a Syzygy root probe answers outright, with the move that
+// wins fastest or loses slowest by DTZ. the WDL bitbases have no distances: moves that give
+// the result away are left out and the search picks among the rest. below the root only
+// captures and pawn moves are probed, so a winning side prefers the pawn pushes and
+// captures that keep the win, which is what makes progress. true when the Syzygy answer
+// is the result
+bool chessSearch::probeRootTables(chessBoard &board, const std::vector<chessMove> &rootMoves, searchResult &result)
+{
+    tablebaseLosingMoves.clear();
+    endgamePieces = syzygyTablebases::instance().maxPieces();
+    for (const std::string &material : bitbaseRegistry::instance().loadedMaterials())
+    {
+        endgamePieces = std::max(endgamePieces, static_cast<int>(material.size()));
+    }
+    probeEndgames = endgamePieces > 0;
+    if (board.pieceCount() > endgamePieces)
+    {
+        return false;
+    }
+
+    chessMove tableMove;
+    int wdl = 0, dtz = 0;
+    if (syzygyTablebases::instance().probeRoot(board, tableMove, wdl, dtz))
+    {
+        result.bestMove = tableMove;
+        result.score = tablebaseScore(wdl == WDL_WIN ? wdlResult::WIN : wdl == WDL_LOSS ? wdlResult::LOSS : wdlResult::DRAW, 0);
+        result.depth = 1;
+        result.principalVariation = {tableMove};
+        result.lines = {{result.score, result.principalVariation}};
+        return true;
+    }
+
+    wdlResult rootResult = board.probeEndgame();
+    if (rootResult == wdlResult::UNKNOWN)
+    {
+        return false;
+    }
+    moveUndo undo;
+    for (const chessMove &move : rootMoves)
+    {
+        board.makeMove(move, undo);
+        wdlResult reply = board.probeEndgame();
+        board.unmakeMove(move, undo);
+        // the reply's result is the opponent's: our win is their loss
+        wdlResult ours = reply == wdlResult::LOSS ? wdlResult::WIN : reply == wdlResult::WIN ? wdlResult::LOSS : reply;
+        if (reply != wdlResult::UNKNOWN && tablebaseScore(ours, 0) < tablebaseScore(rootResult, 0))
+        {
+            tablebaseLosingMoves.push_back(move);
+        }
+    }
+    return false;
+}
+
+searchResult chessSearch::think(chessBoard &board, const searchLimits &limits, const std::vector<uint64_t> &gameKeys)
+{
+    TRACE_ZONE("chessSearch::think");
+    stopRequested.store(false, std::memory_order_relaxed);
+    sharedDepth.store(0, std::memory_order_relaxed);
+    nodeLimit = limits.maxNodes;
+    startTime = std::chrono::steady_clock::now();
+    hasDeadline = limits.moveTimeMs > 0;
+    deadline = startTime + std::chrono::milliseconds(limits.moveTimeMs);
+    table.newSearch();
+
+    // negamax pushes the root itself
+    size_t earlierPositions = gameKeys.size();
+    if (earlierPositions > 0 && gameKeys.back() == board.positionKey())
+    {
+        earlierPositions--;
+    }
+
+    for (auto &thread : threads)
+    {
+        thread->nodes = 0;
+        thread->publishedNodes.store(0, std::memory_order_relaxed);
+        thread->pathKeys.assign(gameKeys.begin(), gameKeys.begin() + earlierPositions);
+
+        // older statistics still help ordering but shouldn't dominate the new search
+        for (auto &side : thread->history)
+        {
+            for (auto &from : side)
+            {
+                for (int &value : from)
+                {
+                    value /= 8;
+                }
+            }
+        }
+    }
+
+    searchResult result;
+    std::vector<chessMove> rootMoves;
+    board.generateLegalMoves(rootMoves);
+    if (rootMoves.empty())
+    {
+        result.score = board.isKingInCheck(board.getPlayerTurn()) ? -mateScore : 0;
+        return result;
+    }
+    result.bestMove = rootMoves[0];
+
+    if (probeRootTables(board, rootMoves, result))
+    {
+        sharedDepth.store(1, std::memory_order_relaxed);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        if (iterationCallback)
+        {
+            iterationCallback(result);
+        }
+        return result;
+    }
+    for (const chessMove &move : rootMoves)
+    {
+        if (std::find(tablebaseLosingMoves.begin(), tablebaseLosingMoves.end(), move) == tablebaseLosingMoves.end())
+        {
+            result.bestMove = move;
+            break;
+        }
+    }
+
+    // a single legal move, or the only one that keeps the tablebase result, needs no search
+    // when the clock is running
+    searchLimits mainLimits = limits;
+    if (hasDeadline && rootMoves.size() - tablebaseLosingMoves.size() == 1)
+    {
+        mainLimits.maxDepth = 1;
+    }
+
+    // helpers get their own copy of the position
+    std::vector<std::unique_ptr<chessBoard>> helperBoards;
+    std::vector<std::thread> helpers;
+    std::string fen = board.toFEN();
+    for (size_t i = 1; i < threads.size(); i++)
+    {
+        helperBoards.push_back(std::make_unique<chessBoard>());
+        helperBoards.back()->loadFEN(fen);
+        helperBoards.back()->attachNetwork(board.getNetwork());
+        threadState *state = threads[i].get();
+        chessBoard *helperBoard = helperBoards.back().get();
+        helpers.emplace_back([this, state, helperBoard, mainLimits]()
+                             {
+            TRACE_THREAD("search helper");
+            iterate(*state, *helperBoard, mainLimits, nullptr); });
+    }
+
+    iterate(*threads[0], board, mainLimits, &result);
+    stopRequested.store(true, std::memory_order_relaxed);
+    for (std::thread &helper : helpers)
+    {
+        helper.join();
+    }
+
+    result.nodes = totalNodes();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return result;
+}
+
+searchWorker::searchWorker()
+{
+    search.setIterationCallback([this](const searchResult &found)
+                                {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        iteration = found;
+        iterationReady = true; });
+}
+
+searchWorker::~searchWorker()
+{
+    cancel();
+}
+
+bool searchWorker::start(const std::string &fen, const searchLimits &limits)
+{
+    if (isBusy())
+    {
+        return false;
+    }
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+
+    auto board = std::make_unique<chessBoard>();
+    if (!board->loadFEN(fen))
+    {
+        return false;
+    }
+    board->attachNetwork(network);
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        resultReady = false;
+        iterationReady = false;
+    }
+
+    startTime = std::chrono::steady_clock::now();
+    busy.store(true, std::memory_order_release);
+    thread = std::thread([this, board = std::move(board), limits]()
+                         {
+        TRACE_THREAD("search");
+        searchResult found = search.think(*board, limits);
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            result = found;
+            resultReady = true;
+        }
+        busy.store(false, std::memory_order_release); });
+    return true;
+}
+
+void searchWorker::cancel()
+{
+    // think() clears the stop flag when it starts, keep asking until it has finished
+    while (isBusy())
+    {
+        search.stop();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+    std::lock_guard<std::mutex> lock(resultMutex);
+    resultReady = false;
+    iterationReady = false;
+}
+
+void searchWorker::newGame()
+{
+    cancel();
+    search.clear();
+}
+
+bool searchWorker::takeResult(searchResult &out)
+{
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if (!resultReady)
+        {
+            return false;
+        }
+        out = result;
+        resultReady = false;
+    }
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+    return true;
+}
+
+bool searchWorker::takeIteration(searchResult &out)
+{
+    std::lock_guard<std::mutex> lock(resultMutex);
+    if (!iterationReady)
+    {
+        return false;
+    }
+    out = iteration;
+    iterationReady = false;
+    return true;
+}
@@ -0,0 +1,181 @@
+#include "../header_files/SoundCues.h"
+#include "../header_files/Trace.h"
+
+#include <algorithm>
+#include <chrono>
+
+#ifdef _WIN32
+#if !defined(_WIN32_WINNT) || _WIN32_WINNT < 0x0602
+#undef _WIN32_WINNT
+#define _WIN32_WINNT 0x0602 // WaitOnAddress needs Windows 8
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "the audio thread waits on the address of wakeCount");
+
+// returns when word no longer holds expected, when woken, or spuriously
+static void waitOnWord(std::atomic<uint32_t> &word, uint32_t expected)
+{
+#ifdef _WIN32
+    WaitOnAddress(&word, &expected, sizeof(expected), INFINITE);
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    // no address wait here, the audio thread looks at the ring every millisecond instead
+    if (word.load() == expected)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+#endif
+}
+
+static void wakeOnWord(std::atomic<uint32_t> &word)
+{
+#ifdef _WIN32
+    WakeByAddressSingle(&word);
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+soundCues::~soundCues()
+{
+    stop();
+}
+
+int64_t soundCues::nowMicroseconds()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool soundCues::load(soundCue cue, const sf::Int16 *samples, size_t sampleCount, unsigned channels, unsigned sampleRate, float volume)
+{
+    int index = static_cast<int>(cue);
+    loaded[index] = false;
+    if (sampleCount == 0 || !buffers[index].loadFromSamples(samples, sampleCount, channels, sampleRate))
+    {
+        return false;
+    }
+    for (sf::Sound &voice : voices[index])
+    {
+        voice.setBuffer(buffers[index]);
+        voice.setVolume(volume);
+    }
+    loaded[index] = true;
+    return true;
+}
+
+void soundCues::start()
+{
+    if (worker.joinable())
+    {
+        return;
+    }
+    stopping = false;
+    worker = std::thread(&soundCues::audioLoop, this);
+}
+
+void soundCues::audioLoop()
+{
+    TRACE_THREAD("audio");
+    while (true)
+    {
+        playQueued();
+        // all sequentially consistent: play either sees sleeping and bumps wakeCount, which
+        // makes the wait return at once, or its cue is seen here before the thread sleeps
+        uint32_t seen = wakeCount.load();
+        sleeping = true;
+        bool empty = ringHead.load(std::memory_order_relaxed) == ringTail.load();
+        if (empty && !stopping)
+        {
+            waitOnWord(wakeCount, seen);
+        }
+        sleeping = false;
+        if (stopping && ringHead.load(std::memory_order_relaxed) == ringTail.load())
+        {
+            return;
+        }
+    }
+}
+
+void soundCues::stop()
+{
+    if (!worker.joinable())
+    {
+        return;
+    }
+    stopping = true;
+    wakeCount.fetch_add(1);
+    wakeOnWord(wakeCount);
+    worker.join();
+}
+
+void soundCues::play(soundCue cue)
+{
+    if (!isLoaded(cue))
+    {
+        return;
+    }
+    size_t tail = ringTail.load(std::memory_order_relaxed);
+    if (tail - ringHead.load(std::memory_order_acquire) == ringSize)
+    {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring[tail & (ringSize - 1)] = request{cue, nowMicroseconds()};
+    ringTail.store(tail + 1);
+    if (sleeping.load())
+    {
+        wakeCount.fetch_add(1);
+        wakeOnWord(wakeCount);
+    }
+}
+
+void soundCues::playQueued()
+{
+    size_t head = ringHead.load(std::memory_order_relaxed);
+    while (head != ringTail.load(std::memory_order_acquire))
+    {
+        TRACE_ZONE("soundCues::playQueued");
+        request queued = ring[head & (ringSize - 1)];
+        ringHead.store(++head, std::memory_order_release);
+
+        // the voices of a cue all last as long, the next one round robin is the one that
+        // started longest ago. play restarts it from the beginning if it is still sounding
+        int index = static_cast<int>(queued.cue);
+        sf::Sound &voice = voices[index][nextVoice[index]];
+        nextVoice[index] = (nextVoice[index] + 1) % voicesPerCue;
+        if (voice.getStatus() == sf::Sound::Playing)
+        {
+            stolenCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        voice.play();
+
+        int64_t latency = nowMicroseconds() - queued.triggerMicroseconds;
+        totalLatencyMicroseconds.fetch_add(latency, std::memory_order_relaxed);
+        if (latency > maxLatencyMicroseconds.load(std::memory_order_relaxed))
+        {
+            maxLatencyMicroseconds.store(latency, std::memory_order_relaxed);
+        }
+        playedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+float soundCues::averageLatencyMs() const
+{
+    uint64_t played = playedCount.load(std::memory_order_relaxed);
+    return played == 0 ? 0.f : totalLatencyMicroseconds.load(std::memory_order_relaxed) / 1000.f / played;
+}
+
+float soundCues::maxLatencyMs() const
+{
+    return maxLatencyMicroseconds.load(std::memory_order_relaxed) / 1000.f;
+}
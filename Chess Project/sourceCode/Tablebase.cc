@@ -0,0 +1,1325 @@
+#include "../header_files/Tablebase.h"
+#include "../header_files/MappedFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <mutex>
+
+// the decoding below follows the Syzygy file format by Ronald de Man:
+// positions are indexed with the same symmetry tricks as the generator and the
+// values are stored as canonical Huffman codes over "recursive pairing" symbols
+
+static const int maxTablePieces = 7;
+
+enum tableFlag
+{
+    FLAG_STM = 1,
+    FLAG_MAPPED = 2,
+    FLAG_WIN_PLIES = 4,
+    FLAG_LOSS_PLIES = 8,
+    FLAG_WIDE = 16,
+    FLAG_SINGLE_VALUE = 128
+};
+
+static const uint8_t wdlMagic[4] = {0x71, 0xE8, 0x23, 0x5D};
+static const uint8_t dtzMagic[4] = {0xD7, 0x66, 0x0C, 0xA5};
+
+typedef uint16_t symbol;
+
+static uint16_t readLittleEndian16(const uint8_t *p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t readLittleEndian32(const uint8_t *p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static uint32_t readBigEndian32(const uint8_t *p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static uint64_t readBigEndian64(const uint8_t *p)
+{
+    return (uint64_t(readBigEndian32(p)) << 32) | readBigEndian32(p + 4);
+}
+
+// Syzygy squares count from a1 = 0 to h8 = 63, chessBoard row 0 is rank 8
+static int tbRank(int sq)
+{
+    return sq >> 3;
+}
+
+static int tbFile(int sq)
+{
+    return sq & 7;
+}
+
+// negative below the a1-h8 diagonal, zero on it
+static int offDiagonal(int sq)
+{
+    return tbRank(sq) - tbFile(sq);
+}
+
+// pieces are coded like in the files: pawn 1 ... king 6, black pieces + 8
+static int tbPieceCode(pieceType type, Color color)
+{
+    int code = 0;
+    switch (type)
+    {
+    case pieceType::PAWN:
+        code = 1;
+        break;
+    case pieceType::KNIGHT:
+        code = 2;
+        break;
+    case pieceType::BISHOP:
+        code = 3;
+        break;
+    case pieceType::ROOK:
+        code = 4;
+        break;
+    case pieceType::QUEEN:
+        code = 5;
+        break;
+    case pieceType::KING:
+        code = 6;
+        break;
+    }
+    return code + (color == Color::BLACK ? 8 : 0);
+}
+
+static int signOf(int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+// index tables shared by every file
+static uint64_t binomial[maxTablePieces][64];
+static int mapPawns[64];
+static int leadPawnIndex[6][64];
+static int leadPawnsSize[6][4];
+static int mapB1H1H7[64];
+static int mapA1D1D4[64];
+static int mapKK[10][64];
+
+static void initIndexTables()
+{
+    int code = 0;
+    for (int s = 0; s < 64; s++)
+    {
+        if (offDiagonal(s) < 0)
+        {
+            mapB1H1H7[s] = code++;
+        }
+    }
+
+    // a1-d1-d4 triangle, squares on the diagonal come last
+    std::vector<int> diagonal;
+    code = 0;
+    for (int s : {0, 1, 2, 3, 9, 10, 11, 18, 19, 27})
+    {
+        if (offDiagonal(s) < 0)
+        {
+            mapA1D1D4[s] = code++;
+        }
+        else if (offDiagonal(s) == 0)
+        {
+            diagonal.push_back(s);
+        }
+    }
+    for (int s : diagonal)
+    {
+        mapA1D1D4[s] = code++;
+    }
+
+    // the 462 legal king pairs with the first king in the triangle; with the
+    // first king on the diagonal the second one must not be above it
+    std::vector<std::pair<int, int>> bothOnDiagonal;
+    code = 0;
+    for (int idx = 0; idx < 10; idx++)
+    {
+        for (int s1 = 0; s1 <= 27; s1++)
+        {
+            if (mapA1D1D4[s1] != idx || (idx == 0 && s1 != 1))
+            {
+                continue;
+            }
+            for (int s2 = 0; s2 < 64; s2++)
+            {
+                if (std::max(std::abs(tbRank(s1) - tbRank(s2)), std::abs(tbFile(s1) - tbFile(s2))) <= 1)
+                {
+                    continue;
+                }
+                if (!offDiagonal(s1) && offDiagonal(s2) > 0)
+                {
+                    continue;
+                }
+                if (!offDiagonal(s1) && !offDiagonal(s2))
+                {
+                    bothOnDiagonal.emplace_back(idx, s2);
+                }
+                else
+                {
+                    mapKK[idx][s2] = code++;
+                }
+            }
+        }
+    }
+    for (auto &pair : bothOnDiagonal)
+    {
+        mapKK[pair.first][pair.second] = code++;
+    }
+
+    binomial[0][0] = 1;
+    for (int n = 1; n < 64; n++)
+    {
+        for (int k = 0; k < maxTablePieces && k <= n; k++)
+        {
+            binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+        }
+    }
+
+    // mapPawns gives the number of squares left for the other pawns when the
+    // leading pawn (nearest the edge, then lowest rank) stands on the square
+    int availableSquares = 47;
+    for (int leadPawns = 1; leadPawns <= 5; leadPawns++)
+    {
+        for (int file = 0; file < 4; file++)
+        {
+            int idx = 0;
+            for (int rank = 1; rank <= 6; rank++)
+            {
+                int sq = rank * 8 + file;
+                if (leadPawns == 1)
+                {
+                    mapPawns[sq] = availableSquares--;
+                    mapPawns[sq ^ 7] = availableSquares--;
+                }
+                leadPawnIndex[leadPawns][sq] = idx;
+                idx += static_cast<int>(binomial[leadPawns - 1][mapPawns[sq]]);
+            }
+            leadPawnsSize[leadPawns][file] = idx;
+        }
+    }
+}
+
+static bool pawnsCompare(int a, int b)
+{
+    return mapPawns[a] < mapPawns[b];
+}
+
+// decoding data for one side to move (and one leading pawn file)
+struct pairsData
+{
+    uint8_t flags = 0;
+    size_t blockSize = 0;
+    size_t span = 0;
+    uint32_t numBlocks = 0;
+    int maxSymbolLength = 0;
+    int minSymbolLength = 0;
+    const uint8_t *lowestSymbol = nullptr;
+    const uint8_t *btree = nullptr;
+    const uint8_t *blockLength = nullptr;
+    size_t blockLengthSize = 0;
+    const uint8_t *sparseIndex = nullptr;
+    size_t sparseIndexSize = 0;
+    const uint8_t *data = nullptr;
+    std::vector<uint64_t> base64;
+    std::vector<uint8_t> symbolLength;
+    int pieces[maxTablePieces] = {};
+    uint64_t groupIndex[maxTablePieces + 1] = {};
+    int groupLength[maxTablePieces + 1] = {};
+    uint16_t mapIndex[4] = {};
+
+    // every symbol expands into a pair of 12 bit symbols
+    symbol left(symbol s) const
+    {
+        return static_cast<symbol>(((btree[3 * s + 1] & 0xF) << 8) | btree[3 * s]);
+    }
+    symbol right(symbol s) const
+    {
+        return static_cast<symbol>((btree[3 * s + 2] << 4) | (btree[3 * s + 1] >> 4));
+    }
+};
+
+class syzygyTable
+{
+public:
+    bool isDTZ = false;
+    std::string path;
+    uint64_t key = 0;
+    uint64_t key2 = 0;
+    int pieceCount = 0;
+    bool hasPawns = false;
+    bool hasUniquePieces = false;
+    int pawnCount[2] = {0, 0};
+
+    std::atomic<bool> ready{false};
+    bool usable = false;
+    mappedFile file;
+    pairsData items[2][4];
+    const uint8_t *dtzMap = nullptr;
+
+    pairsData *get(int stm, int file)
+    {
+        return &items[isDTZ ? 0 : stm % 2][hasPawns ? file : 0];
+    }
+};
+
+// one nibble per (colour, piece type) count
+static uint64_t materialKey(const int counts[2][6])
+{
+    uint64_t key = 0;
+    for (int c = 0; c < 2; c++)
+    {
+        for (int t = 0; t < 6; t++)
+        {
+            key |= uint64_t(counts[c][t]) << (4 * (c * 6 + t));
+        }
+    }
+    return key;
+}
+
+static uint64_t materialKey(const chessBoard &board)
+{
+    int counts[2][6] = {};
+    for (int i = 0; i < 8; i++)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            Piece *piece = board.getPieceAt(i, j);
+            if (piece)
+            {
+                counts[piece->getColor() == Color::WHITE ? 0 : 1][static_cast<int>(piece->getType())]++;
+            }
+        }
+    }
+    return materialKey(counts);
+}
+
+static uint8_t setSymbolLength(pairsData &d, symbol s, std::vector<bool> &visited)
+{
+    visited[s] = true;
+    symbol right = d.right(s);
+    if (right == 0xFFF)
+    {
+        return 0;
+    }
+    symbol left = d.left(s);
+    if (!visited[left])
+    {
+        d.symbolLength[left] = setSymbolLength(d, left, visited);
+    }
+    if (!visited[right])
+    {
+        d.symbolLength[right] = setSymbolLength(d, right, visited);
+    }
+    return static_cast<uint8_t>(d.symbolLength[left] + d.symbolLength[right] + 1);
+}
+
+static const uint8_t *setSizes(pairsData &d, const uint8_t *data)
+{
+    d.flags = *data++;
+    if (d.flags & FLAG_SINGLE_VALUE)
+    {
+        d.numBlocks = 0;
+        d.span = 0;
+        d.blockLengthSize = 0;
+        d.sparseIndexSize = 0;
+        d.minSymbolLength = *data++; // the single value every position shares
+        return data;
+    }
+
+    // the last group index is the number of positions in the table
+    int groups = 0;
+    while (d.groupLength[groups])
+    {
+        groups++;
+    }
+    uint64_t tableSize = d.groupIndex[groups];
+
+    d.blockSize = size_t(1) << *data++;
+    d.span = size_t(1) << *data++;
+    d.sparseIndexSize = static_cast<size_t>((tableSize + d.span - 1) / d.span);
+    int padding = *data++;
+    d.numBlocks = readLittleEndian32(data);
+    data += 4;
+    d.blockLengthSize = d.numBlocks + padding;
+    d.maxSymbolLength = *data++;
+    d.minSymbolLength = *data++;
+    d.lowestSymbol = data;
+    d.base64.assign(d.maxSymbolLength - d.minSymbolLength + 1, 0);
+
+    // longer codes have lower values, base64[i] is the lowest code of length
+    // minSymbolLength + i left aligned in 64 bits
+    for (int i = static_cast<int>(d.base64.size()) - 2; i >= 0; i--)
+    {
+        d.base64[i] = (d.base64[i + 1] + readLittleEndian16(d.lowestSymbol + 2 * i) - readLittleEndian16(d.lowestSymbol + 2 * (i + 1))) / 2;
+    }
+    for (size_t i = 0; i < d.base64.size(); i++)
+    {
+        d.base64[i] <<= 64 - i - d.minSymbolLength;
+    }
+
+    data += d.base64.size() * 2;
+    d.symbolLength.assign(readLittleEndian16(data), 0);
+    data += 2;
+    d.btree = data;
+
+    std::vector<bool> visited(d.symbolLength.size());
+    for (size_t s = 0; s < d.symbolLength.size(); s++)
+    {
+        if (!visited[s])
+        {
+            d.symbolLength[s] = setSymbolLength(d, static_cast<symbol>(s), visited);
+        }
+    }
+    return data + d.symbolLength.size() * 3 + (d.symbolLength.size() & 1);
+}
+
+static int decompressPairs(const pairsData &d, uint64_t index)
+{
+    if (d.flags & FLAG_SINGLE_VALUE)
+    {
+        return d.minSymbolLength;
+    }
+
+    // the sparse index points into the block list every "span" positions,
+    // walk from the nearest entry to the block that holds our index
+    uint32_t k = static_cast<uint32_t>(index / d.span);
+    const uint8_t *entry = d.sparseIndex + 6 * size_t(k);
+    uint32_t block = readLittleEndian32(entry);
+    int offset = readLittleEndian16(entry + 4);
+    offset += static_cast<int>(index % d.span) - static_cast<int>(d.span / 2);
+
+    while (offset < 0)
+    {
+        offset += readLittleEndian16(d.blockLength + 2 * size_t(--block)) + 1;
+    }
+    while (offset > readLittleEndian16(d.blockLength + 2 * size_t(block)))
+    {
+        offset -= readLittleEndian16(d.blockLength + 2 * size_t(block++)) + 1;
+    }
+
+    const uint8_t *ptr = d.data + uint64_t(block) * d.blockSize;
+    uint64_t buffer = readBigEndian64(ptr);
+    ptr += 8;
+    int bufferSize = 64;
+    symbol sym;
+
+    while (true)
+    {
+        int length = 0;
+        while (buffer < d.base64[length])
+        {
+            length++;
+        }
+        sym = static_cast<symbol>((buffer - d.base64[length]) >> (64 - length - d.minSymbolLength));
+        sym = static_cast<symbol>(sym + readLittleEndian16(d.lowestSymbol + 2 * length));
+
+        if (offset < d.symbolLength[sym] + 1)
+        {
+            break;
+        }
+        offset -= d.symbolLength[sym] + 1;
+        length += d.minSymbolLength;
+        buffer <<= length;
+        bufferSize -= length;
+
+        if (bufferSize <= 32)
+        {
+            bufferSize += 32;
+            buffer |= uint64_t(readBigEndian32(ptr)) << (64 - bufferSize);
+            ptr += 4;
+        }
+    }
+
+    // expand the pair tree until we reach the single value we want
+    while (d.symbolLength[sym])
+    {
+        symbol left = d.left(sym);
+        if (offset < d.symbolLength[left] + 1)
+        {
+            sym = left;
+        }
+        else
+        {
+            offset -= d.symbolLength[left] + 1;
+            sym = d.right(sym);
+        }
+    }
+    return d.left(sym);
+}
+
+static void setGroups(syzygyTable &table, pairsData &d, const int order[2], int file)
+{
+    int n = 0;
+    int firstLength = table.hasPawns ? 0 : table.hasUniquePieces ? 3 : 2;
+    d.groupLength[n] = 1;
+
+    // consecutive identical pieces share a group, KRKN gives (3, 1)
+    for (int i = 1; i < table.pieceCount; i++)
+    {
+        if (--firstLength > 0 || d.pieces[i] == d.pieces[i - 1])
+        {
+            d.groupLength[n]++;
+        }
+        else
+        {
+            d.groupLength[++n] = 1;
+        }
+    }
+    d.groupLength[++n] = 0;
+
+    // order[] says in which order the groups are multiplied into the index
+    bool pawnsOnBothSides = table.hasPawns && table.pawnCount[1];
+    int next = pawnsOnBothSides ? 2 : 1;
+    int freeSquares = 64 - d.groupLength[0] - (pawnsOnBothSides ? d.groupLength[1] : 0);
+    uint64_t idx = 1;
+
+    for (int k = 0; next < n || k == order[0] || k == order[1]; k++)
+    {
+        if (k == order[0])
+        {
+            d.groupIndex[0] = idx;
+            idx *= table.hasPawns ? leadPawnsSize[d.groupLength[0]][file] : table.hasUniquePieces ? 31332 : 462;
+        }
+        else if (k == order[1])
+        {
+            d.groupIndex[1] = idx;
+            idx *= binomial[d.groupLength[1]][48 - d.groupLength[0]];
+        }
+        else
+        {
+            d.groupIndex[next] = idx;
+            idx *= binomial[d.groupLength[next]][freeSquares];
+            freeSquares -= d.groupLength[next++];
+        }
+    }
+    d.groupIndex[n] = idx;
+}
+
+static const uint8_t *setDtzMap(syzygyTable &table, const uint8_t *data, int maxFile)
+{
+    table.dtzMap = data;
+    for (int f = 0; f <= maxFile; f++)
+    {
+        pairsData *d = table.get(0, f);
+        if (!(d->flags & FLAG_MAPPED))
+        {
+            continue;
+        }
+        if (d->flags & FLAG_WIDE)
+        {
+            data += reinterpret_cast<uintptr_t>(data) & 1;
+            for (int i = 0; i < 4; i++)
+            {
+                d->mapIndex[i] = static_cast<uint16_t>((data - table.dtzMap) / 2 + 1);
+                data += 2 * size_t(readLittleEndian16(data)) + 2;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                d->mapIndex[i] = static_cast<uint16_t>(data - table.dtzMap + 1);
+                data += *data + 1;
+            }
+        }
+    }
+    return data + (reinterpret_cast<uintptr_t>(data) & 1);
+}
+
+static void initTable(syzygyTable &table, const uint8_t *data)
+{
+    data++; // flags byte: split sides and pawns, both already known from the name
+
+    int sides = (!table.isDTZ && table.key != table.key2) ? 2 : 1;
+    int maxFile = table.hasPawns ? 3 : 0;
+    bool pawnsOnBothSides = table.hasPawns && table.pawnCount[1];
+
+    for (int f = 0; f <= maxFile; f++)
+    {
+        for (int i = 0; i < sides; i++)
+        {
+            *table.get(i, f) = pairsData();
+        }
+
+        int order[2][2] = {{data[0] & 0xF, pawnsOnBothSides ? data[1] & 0xF : 0xF},
+                           {data[0] >> 4, pawnsOnBothSides ? data[1] >> 4 : 0xF}};
+        data += 1 + pawnsOnBothSides;
+
+        for (int k = 0; k < table.pieceCount; k++, data++)
+        {
+            for (int i = 0; i < sides; i++)
+            {
+                table.get(i, f)->pieces[k] = i ? *data >> 4 : *data & 0xF;
+            }
+        }
+        for (int i = 0; i < sides; i++)
+        {
+            setGroups(table, *table.get(i, f), order[i], f);
+        }
+    }
+
+    data += reinterpret_cast<uintptr_t>(data) & 1;
+
+    for (int f = 0; f <= maxFile; f++)
+    {
+        for (int i = 0; i < sides; i++)
+        {
+            data = setSizes(*table.get(i, f), data);
+        }
+    }
+
+    if (table.isDTZ)
+    {
+        data = setDtzMap(table, data, maxFile);
+    }
+
+    for (int f = 0; f <= maxFile; f++)
+    {
+        for (int i = 0; i < sides; i++)
+        {
+            pairsData *d = table.get(i, f);
+            d->sparseIndex = data;
+            data += d->sparseIndexSize * 6;
+        }
+    }
+    for (int f = 0; f <= maxFile; f++)
+    {
+        for (int i = 0; i < sides; i++)
+        {
+            pairsData *d = table.get(i, f);
+            d->blockLength = data;
+            data += d->blockLengthSize * 2;
+        }
+    }
+    for (int f = 0; f <= maxFile; f++)
+    {
+        for (int i = 0; i < sides; i++)
+        {
+            // compressed blocks start on a 64 byte boundary
+            data = reinterpret_cast<const uint8_t *>((reinterpret_cast<uintptr_t>(data) + 0x3F) & ~uintptr_t(0x3F));
+            pairsData *d = table.get(i, f);
+            d->data = data;
+            data += size_t(d->numBlocks) * d->blockSize;
+        }
+    }
+}
+
+// DTZ values are stored by frequency, the map turns them back into distances
+static int mapDtzScore(syzygyTable &table, int file, int value, int wdl)
+{
+    static const int wdlMap[] = {1, 3, 0, 2, 0};
+    pairsData *d = table.get(0, file);
+    if (d->flags & FLAG_MAPPED)
+    {
+        int offset = d->mapIndex[wdlMap[wdl + 2]] + value;
+        value = (d->flags & FLAG_WIDE) ? readLittleEndian16(table.dtzMap + 2 * size_t(offset)) : table.dtzMap[offset];
+    }
+
+    // some tables count moves instead of plies
+    if ((wdl == WDL_WIN && !(d->flags & FLAG_WIN_PLIES)) || (wdl == WDL_LOSS && !(d->flags & FLAG_LOSS_PLIES)) ||
+        wdl == WDL_CURSED_WIN || wdl == WDL_BLESSED_LOSS)
+    {
+        value *= 2;
+    }
+    return value + 1;
+}
+
+static int dtzBeforeZeroing(int wdl)
+{
+    switch (wdl)
+    {
+    case WDL_WIN:
+        return 1;
+    case WDL_CURSED_WIN:
+        return 101;
+    case WDL_BLESSED_LOSS:
+        return -101;
+    case WDL_LOSS:
+        return -1;
+    default:
+        return 0;
+    }
+}
+
+syzygyTablebases::syzygyTablebases()
+{
+    initIndexTables();
+}
+
+syzygyTablebases::~syzygyTablebases() = default;
+
+syzygyTablebases &syzygyTablebases::instance()
+{
+    static syzygyTablebases tablebases;
+    return tablebases;
+}
+
+int syzygyTablebases::init(const std::string &directory)
+{
+    tables.clear();
+    wdlByKey.clear();
+    dtzByKey.clear();
+    largestTable = 0;
+
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.path().extension() != ".rtbw")
+        {
+            continue;
+        }
+
+        // names look like KRPvKR: white pieces, 'v', black pieces
+        std::string name = entry.path().stem().string();
+        size_t separator = name.find('v');
+        if (separator == std::string::npos || name.size() - 1 > static_cast<size_t>(maxTablePieces))
+        {
+            continue;
+        }
+        int counts[2][6] = {};
+        bool valid = true;
+        for (size_t i = 0; i < name.size(); i++)
+        {
+            if (i == separator)
+            {
+                continue;
+            }
+            const char *letters = "KQRBNP";
+            const char *found = std::strchr(letters, name[i]);
+            if (!name[i] || !found)
+            {
+                valid = false;
+                break;
+            }
+            counts[i < separator ? 0 : 1][found - letters]++;
+        }
+        if (!valid || counts[0][0] != 1 || counts[1][0] != 1)
+        {
+            continue;
+        }
+
+        int swapped[2][6];
+        for (int t = 0; t < 6; t++)
+        {
+            swapped[0][t] = counts[1][t];
+            swapped[1][t] = counts[0][t];
+        }
+
+        int pawnIndex = static_cast<int>(pieceType::PAWN);
+        auto describe = [&](syzygyTable &table)
+        {
+            table.key = materialKey(counts);
+            table.key2 = materialKey(swapped);
+            table.pieceCount = static_cast<int>(name.size()) - 1;
+            table.hasPawns = counts[0][pawnIndex] || counts[1][pawnIndex];
+            for (int c = 0; c < 2; c++)
+            {
+                for (int t = 1; t < 6; t++)
+                {
+                    if (counts[c][t] == 1)
+                    {
+                        table.hasUniquePieces = true;
+                    }
+                }
+            }
+            // the side with fewer pawns leads, it compresses better
+            int whitePawns = counts[0][pawnIndex];
+            int blackPawns = counts[1][pawnIndex];
+            bool whiteLeads = !blackPawns || (whitePawns && blackPawns >= whitePawns);
+            table.pawnCount[0] = whiteLeads ? whitePawns : blackPawns;
+            table.pawnCount[1] = whiteLeads ? blackPawns : whitePawns;
+        };
+
+        auto wdl = std::make_unique<syzygyTable>();
+        wdl->path = entry.path().string();
+        describe(*wdl);
+        wdlByKey[wdl->key] = wdl.get();
+        wdlByKey[wdl->key2] = wdl.get();
+        largestTable = std::max(largestTable, wdl->pieceCount);
+        tables.push_back(std::move(wdl));
+
+        std::filesystem::path dtzPath = entry.path();
+        dtzPath.replace_extension(".rtbz");
+        if (std::filesystem::exists(dtzPath, error))
+        {
+            auto dtz = std::make_unique<syzygyTable>();
+            dtz->isDTZ = true;
+            dtz->path = dtzPath.string();
+            describe(*dtz);
+            dtzByKey[dtz->key] = dtz.get();
+            dtzByKey[dtz->key2] = dtz.get();
+            tables.push_back(std::move(dtz));
+        }
+    }
+    return static_cast<int>(std::count_if(tables.begin(), tables.end(), [](const std::unique_ptr<syzygyTable> &table)
+                                          { return !table->isDTZ; }));
+}
+
+// maps the file the first time any thread needs it
+bool syzygyTablebases::mapTable(syzygyTable &table)
+{
+    static std::mutex mappingMutex;
+    if (table.ready.load(std::memory_order_acquire))
+    {
+        return table.usable;
+    }
+
+    std::lock_guard<std::mutex> lock(mappingMutex);
+    if (table.ready.load(std::memory_order_relaxed))
+    {
+        return table.usable;
+    }
+
+    const uint8_t *magic = table.isDTZ ? dtzMagic : wdlMagic;
+    if (table.file.open(table.path))
+    {
+        if (table.file.size() % 64 == 16 && std::memcmp(table.file.data(), magic, 4) == 0)
+        {
+            initTable(table, table.file.data() + 4);
+            table.usable = true;
+        }
+        else
+        {
+            std::cerr << "Corrupted tablebase file: " << table.path << std::endl;
+            table.file.close();
+        }
+    }
+    else
+    {
+        std::cerr << "Could not map tablebase file: " << table.path << std::endl;
+    }
+    table.ready.store(true, std::memory_order_release);
+    return table.usable;
+}
+
+// pawnless positions are mirrored until the first piece is in the a1-d1-d4 triangle and the
+// first of the leading pieces off the diagonal is below it. the file is already mirrored
+static void mirrorPawnless(int *squares, int size, int leadLength)
+{
+    if (tbRank(squares[0]) > 3)
+    {
+        for (int i = 0; i < size; i++)
+        {
+            squares[i] ^= 56;
+        }
+    }
+    for (int i = 0; i < leadLength; i++)
+    {
+        if (!offDiagonal(squares[i]))
+        {
+            continue;
+        }
+        if (offDiagonal(squares[i]) > 0)
+        {
+            for (int j = i; j < size; j++)
+            {
+                squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            }
+        }
+        break;
+    }
+}
+
+// the leading three pieces of a table with a unique piece, after mirrorPawnless
+static uint64_t uniquePiecesIndex(const int *squares)
+{
+    int adjust1 = (squares[1] > squares[0]);
+    int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+    if (offDiagonal(squares[0]))
+    {
+        return (uint64_t(mapA1D1D4[squares[0]]) * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+    }
+    if (offDiagonal(squares[1]))
+    {
+        return (uint64_t(6 * 63) + tbRank(squares[0]) * 28 + mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+    }
+    if (offDiagonal(squares[2]))
+    {
+        return 6 * 63 * 62 + 4 * 28 * 62 + tbRank(squares[0]) * 7 * 28 + (tbRank(squares[1]) - adjust1) * 28 + mapB1H1H7[squares[2]];
+    }
+    return 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + tbRank(squares[0]) * 7 * 6 + (tbRank(squares[1]) - adjust1) * 6 + (tbRank(squares[2]) - adjust2);
+}
+
+int syzygyTablebases::probeTable(chessBoard &board, syzygyTable *table, int wdl, probeState &state)
+{
+    // board pieces in ascending square order
+    int boardSquares[maxTablePieces];
+    int boardCodes[maxTablePieces];
+    int count = 0;
+    for (int sq = 0; sq < 64; sq++)
+    {
+        Piece *piece = board.getPieceAt(7 - sq / 8, sq % 8);
+        if (!piece)
+        {
+            continue;
+        }
+        if (count == maxTablePieces)
+        {
+            state = PROBE_FAIL;
+            return 0;
+        }
+        boardSquares[count] = sq;
+        boardCodes[count] = tbPieceCode(piece->getType(), piece->getColor());
+        count++;
+    }
+
+    // files store the stronger side as white, and symmetric material only with white to move
+    bool blackToMove = board.getPlayerTurn() == Color::BLACK;
+    bool symmetricBlackToMove = table->key == table->key2 && blackToMove;
+    bool blackStronger = materialKey(board) != table->key;
+    bool flip = symmetricBlackToMove || blackStronger;
+    int flipColor = flip ? 8 : 0;
+    int flipSquares = flip ? 56 : 0;
+    int stm = (flip ? 1 : 0) ^ (blackToMove ? 1 : 0);
+
+    int squares[maxTablePieces];
+    int pieces[maxTablePieces];
+    int size = 0;
+    int leadPawnsCount = 0;
+    int file = 0;
+    bool isLeadPawn[maxTablePieces] = {};
+
+    // pawn tables are split by the file of the leading pawn
+    if (table->hasPawns)
+    {
+        int leadCode = table->get(0, 0)->pieces[0] ^ flipColor;
+        for (int i = 0; i < count; i++)
+        {
+            if (boardCodes[i] == leadCode)
+            {
+                squares[size++] = boardSquares[i] ^ flipSquares;
+                isLeadPawn[i] = true;
+            }
+        }
+        leadPawnsCount = size;
+        std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCount, pawnsCompare));
+        file = tbFile(squares[0]);
+        if (file > 3)
+        {
+            file = tbFile(squares[0] ^ 7);
+        }
+    }
+
+    // DTZ tables only hold one side to move
+    if (table->isDTZ)
+    {
+        int flags = table->get(stm, file)->flags;
+        if ((flags & FLAG_STM) != stm && !(table->key == table->key2 && !table->hasPawns))
+        {
+            state = PROBE_CHANGE_STM;
+            return 0;
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!isLeadPawn[i])
+        {
+            squares[size] = boardSquares[i] ^ flipSquares;
+            pieces[size++] = boardCodes[i] ^ flipColor;
+        }
+    }
+
+    pairsData *d = table->get(stm, file);
+
+    // same piece order as the file
+    for (int i = leadPawnsCount; i < size; i++)
+    {
+        for (int j = i; j < size; j++)
+        {
+            if (d->pieces[i] == pieces[j])
+            {
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    if (tbFile(squares[0]) > 3)
+    {
+        for (int i = 0; i < size; i++)
+        {
+            squares[i] ^= 7;
+        }
+    }
+
+    uint64_t idx;
+    if (table->hasPawns)
+    {
+        idx = leadPawnIndex[leadPawnsCount][squares[0]];
+        std::stable_sort(squares + 1, squares + leadPawnsCount, pawnsCompare);
+        for (int i = 1; i < leadPawnsCount; i++)
+        {
+            idx += binomial[i][mapPawns[squares[i]]];
+        }
+    }
+    else
+    {
+        mirrorPawnless(squares, size, d->groupLength[0]);
+        idx = table->hasUniquePieces ? uniquePiecesIndex(squares) : mapKK[mapA1D1D4[squares[0]]][squares[1]];
+    }
+
+    // remaining groups, each placed on the squares the earlier groups left free
+    idx *= d->groupIndex[0];
+    int *groupSquares = squares + d->groupLength[0];
+    bool remainingPawns = table->hasPawns && table->pawnCount[1];
+    int next = 0;
+    while (d->groupLength[++next])
+    {
+        std::stable_sort(groupSquares, groupSquares + d->groupLength[next]);
+        uint64_t n = 0;
+        for (int i = 0; i < d->groupLength[next]; i++)
+        {
+            int adjust = static_cast<int>(std::count_if(squares, groupSquares, [&](int s)
+                                                        { return groupSquares[i] > s; }));
+            n += binomial[i + 1][groupSquares[i] - adjust - 8 * remainingPawns];
+        }
+        remainingPawns = false;
+        idx += n * d->groupIndex[next];
+        groupSquares += d->groupLength[next];
+    }
+
+    int value = decompressPairs(*d, idx);
+    return table->isDTZ ? mapDtzScore(*table, file, value, wdl) : value - 2;
+}
+
+// captures (and pawn moves when checkZeroingMoves is set) are searched first because the
+// files store "don't care" values wherever such a move is best
+int syzygyTablebases::search(chessBoard &board, bool checkZeroingMoves, probeState &state)
+{
+    int bestValue = WDL_LOSS;
+    std::vector<chessMove> moves;
+    board.generateLegalMoves(moves);
+    size_t moveCount = 0;
+    moveUndo undo;
+
+    for (const chessMove &move : moves)
+    {
+        bool capture = board.isCapture(move);
+        bool pawnMove = board.getPieceAt(move.fromRow(), move.fromColumn())->getType() == pieceType::PAWN;
+        if (!capture && (!checkZeroingMoves || !pawnMove))
+        {
+            continue;
+        }
+        moveCount++;
+
+        board.makeMove(move, undo);
+        int value = -search(board, false, state);
+        board.unmakeMove(move, undo);
+
+        if (state == PROBE_FAIL)
+        {
+            return WDL_DRAW;
+        }
+        if (value > bestValue)
+        {
+            bestValue = value;
+            if (value >= WDL_WIN)
+            {
+                state = PROBE_ZEROING_BEST_MOVE;
+                return value;
+            }
+        }
+    }
+
+    // with every legal move already searched the stored value could be wrong (en-passant)
+    bool noMoreMoves = moveCount && moveCount == moves.size();
+    int value;
+    if (noMoreMoves)
+    {
+        value = bestValue;
+    }
+    else
+    {
+        if (board.pieceCount() == 2)
+        {
+            value = WDL_DRAW;
+        }
+        else
+        {
+            auto it = wdlByKey.find(materialKey(board));
+            if (it == wdlByKey.end() || !mapTable(*it->second))
+            {
+                state = PROBE_FAIL;
+                return WDL_DRAW;
+            }
+            value = probeTable(board, it->second, WDL_DRAW, state);
+            if (state == PROBE_FAIL)
+            {
+                return WDL_DRAW;
+            }
+        }
+    }
+
+    if (bestValue >= value)
+    {
+        state = (bestValue > WDL_DRAW || noMoreMoves) ? PROBE_ZEROING_BEST_MOVE : PROBE_OK;
+        return bestValue;
+    }
+    state = PROBE_OK;
+    return value;
+}
+
+int syzygyTablebases::probeDTZInternal(chessBoard &board, probeState &state)
+{
+    state = PROBE_OK;
+    int wdl = search(board, true, state);
+    if (state == PROBE_FAIL || wdl == WDL_DRAW)
+    {
+        return 0;
+    }
+    if (state == PROBE_ZEROING_BEST_MOVE)
+    {
+        return dtzBeforeZeroing(wdl);
+    }
+
+    auto it = dtzByKey.find(materialKey(board));
+    if (it == dtzByKey.end() || !mapTable(*it->second))
+    {
+        state = PROBE_FAIL;
+        return 0;
+    }
+    int dtz = probeTable(board, it->second, wdl, state);
+    if (state == PROBE_FAIL)
+    {
+        return 0;
+    }
+    if (state != PROBE_CHANGE_STM)
+    {
+        return (dtz + 100 * (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN)) * signOf(wdl);
+    }
+
+    // the file holds the other side to move: one ply search for the best reply
+    int minDTZ = 0xFFFF;
+    std::vector<chessMove> moves;
+    board.generateLegalMoves(moves);
+    moveUndo undo;
+    std::vector<chessMove> replies;
+    for (const chessMove &move : moves)
+    {
+        bool zeroing = board.isCapture(move) || board.getPieceAt(move.fromRow(), move.fromColumn())->getType() == pieceType::PAWN;
+        board.makeMove(move, undo);
+
+        dtz = zeroing ? -dtzBeforeZeroing(search(board, false, state)) : -probeDTZInternal(board, state);
+
+        // a mating move is always the fastest
+        if (dtz == 1 && board.isKingInCheck(board.getPlayerTurn()))
+        {
+            board.generateLegalMoves(replies);
+            if (replies.empty())
+            {
+                minDTZ = 1;
+            }
+        }
+        if (!zeroing)
+        {
+            dtz += signOf(dtz);
+        }
+        if (dtz < minDTZ && signOf(dtz) == signOf(wdl))
+        {
+            minDTZ = dtz;
+        }
+        board.unmakeMove(move, undo);
+
+        if (state == PROBE_FAIL)
+        {
+            return 0;
+        }
+    }
+    return minDTZ == 0xFFFF ? -1 : minDTZ;
+}
+
+bool syzygyTablebases::probeWDL(chessBoard &board, int &wdl)
+{
+    if (largestTable == 0 || board.pieceCount() > largestTable || board.hasCastlingRights())
+    {
+        return false;
+    }
+    probeState state = PROBE_OK;
+    int value = search(board, false, state);
+    if (state == PROBE_FAIL)
+    {
+        return false;
+    }
+    wdl = value;
+    return true;
+}
+
+bool syzygyTablebases::probeDTZ(chessBoard &board, int &dtz)
+{
+    if (largestTable == 0 || board.pieceCount() > largestTable || board.hasCastlingRights())
+    {
+        return false;
+    }
+    probeState state = PROBE_OK;
+    int value = probeDTZInternal(board, state);
+    if (state == PROBE_FAIL)
+    {
+        return false;
+    }
+    dtz = value;
+    return true;
+}
+
+bool syzygyTablebases::probeRoot(chessBoard &board, chessMove &bestMove, int &wdl, int &dtz)
+{
+    if (!probeWDL(board, wdl) || !probeDTZ(board, dtz))
+    {
+        return false;
+    }
+
+    std::vector<chessMove> moves;
+    board.generateLegalMoves(moves);
+    std::vector<chessMove> replies;
+    moveUndo undo;
+    int bestRank = -0x7FFFFFFF;
+    bool found = false;
+
+    for (const chessMove &move : moves)
+    {
+        bool zeroing = board.isCapture(move) || board.getPieceAt(move.fromRow(), move.fromColumn())->getType() == pieceType::PAWN;
+        board.makeMove(move, undo);
+
+        probeState state = PROBE_OK;
+        int moveDTZ;
+        board.generateLegalMoves(replies);
+        if (replies.empty() && board.isKingInCheck(board.getPlayerTurn()))
+        {
+            moveDTZ = 1;
+        }
+        else if (zeroing)
+        {
+            moveDTZ = dtzBeforeZeroing(-search(board, false, state));
+        }
+        else
+        {
+            moveDTZ = -probeDTZInternal(board, state);
+            moveDTZ += signOf(moveDTZ);
+        }
+        board.unmakeMove(move, undo);
+
+        if (state == PROBE_FAIL)
+        {
+            return false;
+        }
+
+        // wins sorted by the shortest distance, losses by the longest, draws in between
+        int rank = moveDTZ > 0 ? 100000 - moveDTZ : moveDTZ < 0 ? -100000 - moveDTZ : 0;
+        if (!found || rank > bestRank)
+        {
+            bestRank = rank;
+            bestMove = move;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// the eight board symmetries, bit 0 mirrors the files, bit 1 the ranks, bit 2 the diagonal
+static int symmetricSquare(int sq, int symmetry)
+{
+    int rank = tbRank(sq), file = tbFile(sq);
+    file = symmetry & 1 ? 7 - file : file;
+    rank = symmetry & 2 ? 7 - rank : rank;
+    return symmetry & 4 ? file * 8 + rank : rank * 8 + file;
+}
+
+// walks the placements of the leading pieces through the same mirroring and index as a
+// probe. every index must lie inside the table and be shared only by mirror images of one
+// position, and every index of the table must be reached
+static bool checkLeadGroup(const char *name, int pieces, uint64_t tableSize, const std::function<uint64_t(int *)> &index)
+{
+    std::vector<int64_t> owner(tableSize, -1);
+    uint64_t outside = 0, shared = 0;
+    int squares[3];
+    for (int placement = 0; placement < (1 << (6 * pieces)); placement++)
+    {
+        int original[3];
+        bool distinct = true;
+        for (int i = 0; i < pieces; i++)
+        {
+            original[i] = (placement >> (6 * i)) & 63;
+            for (int j = 0; j < i; j++)
+            {
+                distinct = distinct && original[i] != original[j];
+            }
+        }
+        if (!distinct)
+        {
+            continue;
+        }
+
+        // the smallest mirror image stands for the whole class
+        int64_t representative = -1;
+        for (int symmetry = 0; symmetry < 8; symmetry++)
+        {
+            int64_t image = 0;
+            for (int i = 0; i < pieces; i++)
+            {
+                image = image * 64 + symmetricSquare(original[i], symmetry);
+            }
+            representative = representative < 0 ? image : std::min(representative, image);
+        }
+
+        std::copy(original, original + pieces, squares);
+        if (tbFile(squares[0]) > 3)
+        {
+            for (int i = 0; i < pieces; i++)
+            {
+                squares[i] ^= 7;
+            }
+        }
+        mirrorPawnless(squares, pieces, pieces);
+        uint64_t idx = index(squares);
+        if (idx == UINT64_MAX)
+        {
+            continue;
+        }
+        if (idx >= tableSize)
+        {
+            outside++;
+        }
+        else if (owner[idx] < 0)
+        {
+            owner[idx] = representative;
+        }
+        else if (owner[idx] != representative)
+        {
+            shared++;
+        }
+    }
+
+    uint64_t unused = static_cast<uint64_t>(std::count(owner.begin(), owner.end(), -1));
+    if (outside || shared || unused)
+    {
+        std::cerr << name << ": " << outside << " placements outside the table, " << shared << " sharing an index, "
+                  << unused << " indices never reached" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool syzygyTablebases::checkIndexing() const
+{
+    bool unique = checkLeadGroup("unique pieces", 3, 31332, [](int *squares)
+                                 { return uniquePiecesIndex(squares); });
+    // the kings never stand next to each other, those placements have no index
+    bool kings = checkLeadGroup("two kings", 2, 462, [](int *squares)
+                                { return std::max(std::abs(tbRank(squares[0]) - tbRank(squares[1])), std::abs(tbFile(squares[0]) - tbFile(squares[1]))) <= 1
+                                             ? UINT64_MAX
+                                             : uint64_t(mapKK[mapA1D1D4[squares[0]]][squares[1]]); });
+    return unique && kings;
+}
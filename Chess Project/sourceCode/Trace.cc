@@ -0,0 +1,143 @@
+#include "../header_files/Trace.h"
+
+#ifdef CHESS_TRACE
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct traceEvent
+    {
+        const char *name;
+        uint64_t start;    // ns since traceEpoch
+        uint64_t duration; // ns
+    };
+
+    struct traceBuffer
+    {
+        std::mutex mutex;
+        std::vector<traceEvent> events; // grows up to traceBufferEvents, then used as a ring
+        size_t next = 0;
+        uint64_t overwritten = 0;
+        uint32_t threadId = 0;
+        std::string threadName;
+    };
+
+    const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<traceBuffer>> registry;
+    thread_local traceBuffer *localBuffer = nullptr;
+
+    uint64_t nowNanoseconds()
+    {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceEpoch).count());
+    }
+
+    // registered once per thread, the registry owns it from then on
+    traceBuffer &threadBuffer()
+    {
+        if (!localBuffer)
+        {
+            auto buffer = std::make_unique<traceBuffer>();
+            std::lock_guard<std::mutex> lock(registryMutex);
+            buffer->threadId = static_cast<uint32_t>(registry.size() + 1);
+            buffer->threadName = "thread " + std::to_string(buffer->threadId);
+            localBuffer = buffer.get();
+            registry.push_back(std::move(buffer));
+        }
+        return *localBuffer;
+    }
+
+    void writeEscaped(std::ostream &out, const std::string &text)
+    {
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out << '\\';
+            }
+            out << c;
+        }
+    }
+}
+
+traceZone::traceZone(const char *zoneName) : name(zoneName), start(nowNanoseconds())
+{
+}
+
+traceZone::~traceZone()
+{
+    traceEvent event{name, start, nowNanoseconds() - start};
+    traceBuffer &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() < traceBufferEvents)
+    {
+        buffer.events.push_back(event);
+        return;
+    }
+    buffer.events[buffer.next] = event;
+    buffer.next = (buffer.next + 1) % traceBufferEvents;
+    buffer.overwritten++;
+}
+
+void traceThreadName(const char *name)
+{
+    traceBuffer &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.threadName = name;
+}
+
+bool traceDump(const std::string &path)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "Could not open " << path << " for the trace" << std::endl;
+        return false;
+    }
+
+    // complete ("X") events with microsecond timestamps, one thread_name record per buffer
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    uint64_t overwritten = 0;
+    std::lock_guard<std::mutex> registryLock(registryMutex);
+    for (const auto &buffer : registry)
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        overwritten += buffer->overwritten;
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->threadId
+            << ", \"args\": {\"name\": \"";
+        writeEscaped(out, buffer->threadName);
+        out << "\"}}";
+        first = false;
+        for (const traceEvent &event : buffer->events)
+        {
+            out << ",\n{\"name\": \"";
+            writeEscaped(out, event.name);
+            out << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->threadId << ", \"ts\": " << event.start / 1000 << '.'
+                << (event.start % 1000) / 100 << ", \"dur\": " << event.duration / 1000 << '.' << (event.duration % 1000) / 100
+                << "}";
+        }
+    }
+    out << "\n]}\n";
+
+    if (!out)
+    {
+        std::cerr << "Could not write the trace to " << path << std::endl;
+        return false;
+    }
+    if (overwritten > 0)
+    {
+        std::cerr << "Trace buffers were full, the oldest " << overwritten << " zones are missing" << std::endl;
+    }
+    return true;
+}
+
+#endif
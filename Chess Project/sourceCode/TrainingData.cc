@@ -0,0 +1,436 @@
+#include "../header_files/TrainingData.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const char sampleMagic[4] = {'C', 'T', 'D', '1'};
+static const uint32_t blockCompressed = 1;
+
+bool packSample(const chessBoard &board, int score, chessMove move, packedSample &sample)
+{
+    sample = packedSample();
+    int count = 0;
+    for (int row = 0; row < 8; row++)
+    {
+        for (int column = 0; column < 8; column++)
+        {
+            Piece *piece = board.getPieceAt(row, column);
+            if (!piece)
+            {
+                continue;
+            }
+            if (count == 32)
+            {
+                return false;
+            }
+            int code = static_cast<int>(piece->getColor()) * 6 + static_cast<int>(piece->getType());
+            sample.occupancy |= 1ULL << (row * 8 + column);
+            sample.pieces[count / 2] |= static_cast<uint8_t>(code << ((count % 2) * 4));
+            count++;
+        }
+    }
+
+    sample.flags = board.getPlayerTurn() == Color::BLACK ? 1 : 0;
+    // same rule as toFEN: king and rook still on their home squares and never moved
+    const int rightRows[4] = {7, 7, 0, 0};
+    const int rightColumns[4] = {7, 0, 7, 0};
+    for (int right = 0; right < 4; right++)
+    {
+        int row = rightRows[right];
+        Color color = row == 7 ? Color::WHITE : Color::BLACK;
+        Piece *king = board.getPieceAt(row, 4);
+        Piece *rook = board.getPieceAt(row, rightColumns[right]);
+        if (king && king->getType() == pieceType::KING && king->getColor() == color && !king->getHasBeenMoved() &&
+            rook && rook->getType() == pieceType::ROOK && rook->getColor() == color && !rook->getHasBeenMoved())
+        {
+            sample.flags |= static_cast<uint8_t>(2 << right);
+        }
+    }
+    if (board.enPassantTargetRow != -1)
+    {
+        sample.enPassant = static_cast<uint8_t>(board.enPassantTargetRow * 8 + board.enPassantTargetColumn);
+    }
+    sample.halfmoveClock = static_cast<uint8_t>(std::min(board.halfmoveClock, 255));
+    sample.score = static_cast<int16_t>(std::max(-32767, std::min(score, 32767)));
+    sample.move = move.data;
+    return true;
+}
+
+std::string sampleToFEN(const packedSample &sample)
+{
+    static const char symbols[] = "KQRBNPkqrbnp";
+    std::string fen;
+    int index = 0;
+    for (int row = 0; row < 8; row++)
+    {
+        int empty = 0;
+        for (int column = 0; column < 8; column++)
+        {
+            if (!(sample.occupancy >> (row * 8 + column) & 1))
+            {
+                empty++;
+                continue;
+            }
+            if (empty)
+            {
+                fen += char('0' + empty);
+                empty = 0;
+            }
+            int code = (sample.pieces[index / 2] >> ((index % 2) * 4)) & 15;
+            fen += code < 12 ? symbols[code] : '?';
+            index++;
+        }
+        if (empty)
+        {
+            fen += char('0' + empty);
+        }
+        if (row < 7)
+        {
+            fen += '/';
+        }
+    }
+
+    fen += sample.flags & 1 ? " b " : " w ";
+    std::string castling;
+    const char rights[4] = {'K', 'Q', 'k', 'q'};
+    for (int right = 0; right < 4; right++)
+    {
+        if (sample.flags & (2 << right))
+        {
+            castling += rights[right];
+        }
+    }
+    fen += castling.empty() ? "-" : castling;
+    if (sample.enPassant < 64)
+    {
+        fen += ' ';
+        fen += char('a' + sample.enPassant % 8);
+        fen += char('0' + 8 - sample.enPassant / 8);
+    }
+    else
+    {
+        fen += " -";
+    }
+    fen += " " + std::to_string(sample.halfmoveClock) + " 1";
+    return fen;
+}
+
+static uint32_t read32(const uint8_t *p)
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static void writeLength(std::vector<uint8_t> &output, size_t length)
+{
+    while (length >= 255)
+    {
+        output.push_back(255);
+        length -= 255;
+    }
+    output.push_back(static_cast<uint8_t>(length));
+}
+
+// token byte: literal count in the high nibble, match length - 4 in the low nibble, 15 meaning
+// more length bytes follow; then the literals, then a 16 bit offset back to the match.
+// the last token carries only literals
+void compressBlock(const uint8_t *input, size_t size, std::vector<uint8_t> &output)
+{
+    const int hashBits = 14;
+    std::vector<uint32_t> table(size_t(1) << hashBits, UINT32_MAX);
+    output.clear();
+    output.reserve(size + size / 255 + 16);
+
+    size_t anchor = 0;
+    size_t i = 0;
+    while (size >= 12 && i + 12 <= size)
+    {
+        uint32_t sequence = read32(input + i);
+        uint32_t hash = (sequence * 2654435761U) >> (32 - hashBits);
+        uint32_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(i);
+        if (candidate == UINT32_MAX || i - candidate > 65535 || read32(input + candidate) != sequence)
+        {
+            i++;
+            continue;
+        }
+
+        size_t length = 4;
+        // the last bytes always stay literals so the decoder can stop on a literal run
+        while (i + length + 5 < size && input[candidate + length] == input[i + length])
+        {
+            length++;
+        }
+
+        size_t literals = i - anchor;
+        size_t extra = length - 4;
+        output.push_back(static_cast<uint8_t>((std::min<size_t>(literals, 15) << 4) | std::min<size_t>(extra, 15)));
+        if (literals >= 15)
+        {
+            writeLength(output, literals - 15);
+        }
+        output.insert(output.end(), input + anchor, input + i);
+        uint16_t offset = static_cast<uint16_t>(i - candidate);
+        output.push_back(static_cast<uint8_t>(offset & 255));
+        output.push_back(static_cast<uint8_t>(offset >> 8));
+        if (extra >= 15)
+        {
+            writeLength(output, extra - 15);
+        }
+        i += length;
+        anchor = i;
+    }
+
+    size_t literals = size - anchor;
+    output.push_back(static_cast<uint8_t>(std::min<size_t>(literals, 15) << 4));
+    if (literals >= 15)
+    {
+        writeLength(output, literals - 15);
+    }
+    output.insert(output.end(), input + anchor, input + size);
+}
+
+bool decompressBlock(const uint8_t *input, size_t size, uint8_t *output, size_t outputSize)
+{
+    size_t in = 0, out = 0;
+    while (in < size)
+    {
+        uint8_t token = input[in++];
+        size_t literals = token >> 4;
+        if (literals == 15)
+        {
+            uint8_t more;
+            do
+            {
+                if (in >= size)
+                {
+                    return false;
+                }
+                more = input[in++];
+                literals += more;
+            } while (more == 255);
+        }
+        if (literals > size - in || literals > outputSize - out)
+        {
+            return false;
+        }
+        std::memcpy(output + out, input + in, literals);
+        in += literals;
+        out += literals;
+        if (in == size)
+        {
+            break;
+        }
+
+        if (size - in < 2)
+        {
+            return false;
+        }
+        size_t offset = input[in] | (input[in + 1] << 8);
+        in += 2;
+        size_t length = (token & 15) + 4;
+        if ((token & 15) == 15)
+        {
+            uint8_t more;
+            do
+            {
+                if (in >= size)
+                {
+                    return false;
+                }
+                more = input[in++];
+                length += more;
+            } while (more == 255);
+        }
+        if (offset == 0 || offset > out || length > outputSize - out)
+        {
+            return false;
+        }
+        // byte by byte, matches may overlap their own output
+        for (size_t k = 0; k < length; k++, out++)
+        {
+            output[out] = output[out - offset];
+        }
+    }
+    return out == outputSize;
+}
+
+sampleWriter::~sampleWriter()
+{
+    close();
+}
+
+bool sampleWriter::open(const std::string &path, bool compressBlocks, size_t samplesPerBlock)
+{
+    close();
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cerr << "Could not write " << path << std::endl;
+        return false;
+    }
+    out.write(sampleMagic, sizeof(sampleMagic));
+    compress = compressBlocks;
+    blockSamples = std::max<size_t>(1, samplesPerBlock);
+    filling.clear();
+    filling.reserve(blockSamples);
+    closing = false;
+    failed = false;
+    samples = 0;
+    bytes = sizeof(sampleMagic);
+    writerThread = std::thread(&sampleWriter::writerLoop, this);
+    return true;
+}
+
+void sampleWriter::write(const packedSample *data, size_t count)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (size_t i = 0; i < count; i++)
+    {
+        filling.push_back(data[i]);
+        if (filling.size() < blockSamples)
+        {
+            continue;
+        }
+        hasSpace.wait(lock, [this]()
+                      { return pending.size() < maxPendingBlocks; });
+        pending.push_back(std::move(filling));
+        filling = std::vector<packedSample>();
+        filling.reserve(blockSamples);
+        hasWork.notify_one();
+    }
+}
+
+void sampleWriter::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        hasWork.wait(lock, [this]()
+                     { return closing || !pending.empty(); });
+        if (pending.empty())
+        {
+            return;
+        }
+        std::vector<packedSample> block = std::move(pending.front());
+        pending.pop_front();
+        hasSpace.notify_all();
+
+        // compress and write without holding the lock so producers keep filling
+        lock.unlock();
+        bool ok = writeBlock(block);
+        lock.lock();
+        failed = failed || !ok;
+    }
+}
+
+bool sampleWriter::writeBlock(const std::vector<packedSample> &block)
+{
+    const uint8_t *raw = reinterpret_cast<const uint8_t *>(block.data());
+    size_t rawSize = block.size() * sizeof(packedSample);
+    std::vector<uint8_t> packed;
+    uint32_t flags = 0;
+    if (compress)
+    {
+        compressBlock(raw, rawSize, packed);
+        // incompressible blocks are stored as they are
+        if (packed.size() < rawSize)
+        {
+            flags = blockCompressed;
+        }
+    }
+    const uint8_t *data = flags ? packed.data() : raw;
+    uint32_t header[3] = {static_cast<uint32_t>(block.size()), static_cast<uint32_t>(flags ? packed.size() : rawSize), flags};
+    out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(data), header[1]);
+    if (!out)
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    samples += block.size();
+    bytes += sizeof(header) + header[1];
+    return true;
+}
+
+bool sampleWriter::close()
+{
+    if (!writerThread.joinable())
+    {
+        return !failed;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!filling.empty())
+        {
+            hasSpace.wait(lock, [this]()
+                          { return pending.size() < maxPendingBlocks; });
+            pending.push_back(std::move(filling));
+            filling = std::vector<packedSample>();
+        }
+        closing = true;
+        hasWork.notify_one();
+    }
+    writerThread.join();
+    out.close();
+    if (failed)
+    {
+        std::cerr << "Writing training samples failed" << std::endl;
+    }
+    return !failed;
+}
+
+uint64_t sampleWriter::samplesWritten()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return samples;
+}
+
+uint64_t sampleWriter::bytesWritten()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes;
+}
+
+bool sampleReader::open(const std::string &path)
+{
+    in.open(path, std::ios::binary);
+    char magic[4];
+    if (!in || !in.read(magic, sizeof(magic)) || std::memcmp(magic, sampleMagic, sizeof(magic)) != 0)
+    {
+        std::cerr << "Not a training sample file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool sampleReader::readBlock(std::vector<packedSample> &block)
+{
+    uint32_t header[3];
+    if (!in.read(reinterpret_cast<char *>(header), sizeof(header)))
+    {
+        return false;
+    }
+    size_t rawSize = static_cast<size_t>(header[0]) * sizeof(packedSample);
+    block.resize(header[0]);
+    uint8_t *raw = reinterpret_cast<uint8_t *>(block.data());
+    if (!(header[2] & blockCompressed))
+    {
+        if (header[1] != rawSize || !in.read(reinterpret_cast<char *>(raw), rawSize))
+        {
+            std::cerr << "Damaged sample block" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    stored.resize(header[1]);
+    if (!in.read(reinterpret_cast<char *>(stored.data()), header[1]) ||
+        !decompressBlock(stored.data(), stored.size(), raw, rawSize))
+    {
+        std::cerr << "Damaged sample block" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,468 @@
+#include "../header_files/Uci.h"
+#include "../header_files/GameRules.h"
+#include "../header_files/Tablebase.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+static const char *benchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "6k1/5p2/6p1/8/7p/8/6PP/6K1 b - - 0 1",
+    "8/8/1p6/3b4/1P1k4/8/3K4/8 w - - 0 1",
+};
+
+static std::string scoreText(int score)
+{
+    if (std::abs(score) >= mateBound)
+    {
+        // plies to mate, reported as moves and negative when we are the one getting mated
+        int plies = mateScore - std::abs(score);
+        int moves = (plies + 1) / 2;
+        return "mate " + std::to_string(score > 0 ? moves : -moves);
+    }
+    return "cp " + std::to_string(score);
+}
+
+// one "info" line per reported line, numbered with multipv once there is more than one
+static std::string infoLine(const searchResult &result, size_t index)
+{
+    const searchLine &reported = result.lines[index];
+    std::string line = "info depth " + std::to_string(result.depth);
+    if (result.lines.size() > 1)
+    {
+        line += " multipv " + std::to_string(index + 1);
+    }
+    line += " score " + scoreText(reported.score) + " nodes " + std::to_string(result.nodes) + " nps " +
+            std::to_string(result.nodesPerSecond()) + " time " + std::to_string(static_cast<uint64_t>(result.seconds * 1000.0));
+    if (!reported.moves.empty())
+    {
+        line += " pv";
+        for (const chessMove &move : reported.moves)
+        {
+            line += " " + move.toString();
+        }
+    }
+    return line;
+}
+
+uciEngine::uciEngine(std::istream &in, std::ostream &out)
+    : input(in), output(out), board(std::make_unique<chessBoard>())
+{
+    history.reset(*board);
+    search.setIterationCallback([this](const searchResult &result)
+                                {
+        for (size_t i = 0; i < result.lines.size(); i++)
+        {
+            send(infoLine(result, i));
+        } });
+}
+
+uciEngine::~uciEngine()
+{
+    stopSearch();
+}
+
+void uciEngine::send(const std::string &line)
+{
+    std::lock_guard<std::mutex> lock(outputMutex);
+    output << line << std::endl;
+}
+
+void uciEngine::waitForSearch()
+{
+    if (searchThread.joinable())
+    {
+        searchThread.join();
+    }
+    if (ponderTimer.joinable())
+    {
+        ponderTimer.join();
+    }
+}
+
+void uciEngine::releaseBestMove()
+{
+    {
+        std::lock_guard<std::mutex> lock(holdMutex);
+        holdBestMove = false;
+        pondering = false;
+    }
+    holdChanged.notify_all();
+}
+
+void uciEngine::stopSearch()
+{
+    releaseBestMove();
+    // think() clears the stop flag when it starts, keep asking until it has finished
+    while (searching.load(std::memory_order_acquire))
+    {
+        search.stop();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    waitForSearch();
+}
+
+void uciEngine::run()
+{
+    std::string line;
+    while (std::getline(input, line))
+    {
+        if (!handleCommand(line))
+        {
+            break;
+        }
+    }
+    stopSearch();
+}
+
+bool uciEngine::handleCommand(const std::string &line)
+{
+    std::istringstream args(line);
+    std::string command;
+    if (!(args >> command))
+    {
+        return true;
+    }
+
+    if (command == "uci")
+    {
+        send("id name Chess Project");
+        send("id author Chess Project authors");
+        send("option name Hash type spin default 16 min 1 max 4096");
+        send("option name Threads type spin default 1 min 1 max 256");
+        send("option name MultiPV type spin default 1 min 1 max 64");
+        send("option name EvalFile type string default <empty>");
+        send("option name BitbasePath type string default <empty>");
+        send("option name SyzygyPath type string default <empty>");
+        send("uciok");
+    }
+    else if (command == "isready")
+    {
+        send("readyok");
+    }
+    else if (command == "setoption")
+    {
+        waitForSearch();
+        handleSetOption(args);
+    }
+    else if (command == "ucinewgame")
+    {
+        waitForSearch();
+        search.clear();
+    }
+    else if (command == "position")
+    {
+        waitForSearch();
+        handlePosition(args);
+    }
+    else if (command == "go")
+    {
+        waitForSearch();
+        handleGo(args);
+    }
+    else if (command == "stop")
+    {
+        stopSearch();
+    }
+    else if (command == "ponderhit")
+    {
+        handlePonderHit();
+    }
+    else if (command == "bench")
+    {
+        waitForSearch();
+        int depth = 6;
+        args >> depth;
+        std::lock_guard<std::mutex> lock(outputMutex);
+        bench(std::max(1, depth), output);
+    }
+    else if (command == "quit")
+    {
+        stopSearch();
+        return false;
+    }
+    else
+    {
+        send("info string unknown command " + command);
+    }
+    return true;
+}
+
+// position startpos|fen <fen> [moves <move>...], moves in coordinate notation
+void uciEngine::handlePosition(std::istringstream &args)
+{
+    std::string token;
+    args >> token;
+    std::string fen;
+    if (token == "startpos")
+    {
+        fen = startPosition;
+        args >> token;
+    }
+    else if (token == "fen")
+    {
+        while (args >> token && token != "moves")
+        {
+            fen += (fen.empty() ? "" : " ") + token;
+        }
+    }
+    else
+    {
+        send("info string expected startpos or fen");
+        return;
+    }
+
+    auto next = std::make_unique<chessBoard>();
+    if (!next->loadFEN(fen))
+    {
+        send("info string invalid fen " + fen);
+        return;
+    }
+    next->attachNetwork(network.get());
+    gameHistory nextHistory;
+    nextHistory.reset(*next);
+
+    if (token == "moves")
+    {
+        std::vector<chessMove> legal;
+        while (args >> token)
+        {
+            next->generateLegalMoves(legal);
+            auto found = std::find_if(legal.begin(), legal.end(), [&token](const chessMove &move)
+                                      { return move.toString() == token; });
+            if (found == legal.end())
+            {
+                send("info string illegal move " + token);
+                return;
+            }
+            moveUndo undo;
+            next->makeMove(*found, undo);
+            nextHistory.record(*next);
+        }
+    }
+    board = std::move(next);
+    history = std::move(nextHistory);
+}
+
+// the search works on its own copy of the position
+void uciEngine::handleGo(std::istringstream &args)
+{
+    searchLimits limits;
+    limits.multiPV = multiPV;
+    int timeLeft[2] = {0, 0};
+    int increment[2] = {0, 0};
+    int movesToGo = 0;
+    bool infinite = false, ponder = false;
+    std::string token;
+    while (args >> token)
+    {
+        if (token == "infinite")
+        {
+            infinite = true;
+        }
+        else if (token == "ponder")
+        {
+            ponder = true;
+        }
+        else if (token == "depth")
+        {
+            args >> limits.maxDepth;
+        }
+        else if (token == "movetime")
+        {
+            args >> limits.moveTimeMs;
+        }
+        else if (token == "nodes")
+        {
+            args >> limits.maxNodes;
+        }
+        else if (token == "wtime")
+        {
+            args >> timeLeft[0];
+        }
+        else if (token == "btime")
+        {
+            args >> timeLeft[1];
+        }
+        else if (token == "winc")
+        {
+            args >> increment[0];
+        }
+        else if (token == "binc")
+        {
+            args >> increment[1];
+        }
+        else if (token == "movestogo")
+        {
+            args >> movesToGo;
+        }
+    }
+
+    // with a clock: an even share of the remaining time plus most of the increment,
+    // never more than half of what is left and a little kept back for the GUI
+    int side = board->getPlayerTurn() == Color::WHITE ? 0 : 1;
+    if (limits.moveTimeMs == 0 && timeLeft[side] > 0 && !infinite)
+    {
+        int share = timeLeft[side] / (movesToGo > 0 ? movesToGo + 1 : 30) + increment[side] * 3 / 4;
+        limits.moveTimeMs = std::max(10, std::min(share, timeLeft[side] / 2) - 20);
+    }
+    // pondering runs on the opponent's time, the budget only starts with ponderhit
+    {
+        std::lock_guard<std::mutex> lock(holdMutex);
+        holdBestMove = infinite || ponder;
+        // go ponder infinite still needs stop
+        pondering = ponder && !infinite;
+        ponderTimeMs = limits.moveTimeMs;
+    }
+    if (infinite || ponder)
+    {
+        limits.moveTimeMs = 0;
+    }
+
+    searchBoard = std::make_unique<chessBoard>();
+    searchBoard->loadFEN(board->toFEN());
+    searchBoard->attachNetwork(network.get());
+    searching.store(true, std::memory_order_release);
+    searchThread = std::thread([this, limits, gameKeys = history.positionKeys()]()
+                               {
+        searchResult result = search.think(*searchBoard, limits, gameKeys);
+        {
+            // a held search that ends early, on its depth or a forced move, still waits
+            std::unique_lock<std::mutex> lock(holdMutex);
+            holdChanged.wait(lock, [this]()
+                             { return !holdBestMove; });
+        }
+        send(result.bestMove.isNull() ? "bestmove 0000" : "bestmove " + result.bestMove.toString());
+        searching.store(false, std::memory_order_release); });
+}
+
+// the opponent played the expected move: the pondering search becomes the real one and
+// gets the time go ponder asked for, counted from now
+void uciEngine::handlePonderHit()
+{
+    int budget = 0;
+    {
+        std::lock_guard<std::mutex> lock(holdMutex);
+        if (!pondering)
+        {
+            return;
+        }
+        budget = ponderTimeMs;
+        pondering = false;
+        holdBestMove = false;
+    }
+    holdChanged.notify_all();
+    if (budget == 0)
+    {
+        return;
+    }
+    if (ponderTimer.joinable())
+    {
+        ponderTimer.join();
+    }
+    ponderTimer = std::thread([this, budget]()
+                              {
+        auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(budget);
+        while (searching.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < end)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        while (searching.load(std::memory_order_acquire))
+        {
+            search.stop();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        } });
+}
+
+// setoption name <name> value <value>
+void uciEngine::handleSetOption(std::istringstream &args)
+{
+    std::string token, name, value;
+    args >> token;
+    while (args >> token && token != "value")
+    {
+        name += (name.empty() ? "" : " ") + token;
+    }
+    std::getline(args >> std::ws, value);
+
+    if (name == "Hash")
+    {
+        search.setHashSize(static_cast<size_t>(std::max(1, std::atoi(value.c_str()))));
+    }
+    else if (name == "Threads")
+    {
+        search.setThreads(std::max(1, std::atoi(value.c_str())));
+    }
+    else if (name == "MultiPV")
+    {
+        multiPV = std::max(1, std::min(64, std::atoi(value.c_str())));
+    }
+    else if (name == "EvalFile")
+    {
+        auto loaded = std::make_unique<nnueNetwork>();
+        if (value.empty() || value == "<empty>")
+        {
+            network.reset();
+        }
+        else if (loaded->load(value))
+        {
+            network = std::move(loaded);
+        }
+        else
+        {
+            send("info string could not load " + value);
+            return;
+        }
+        board->attachNetwork(network.get());
+    }
+    // the search probes whatever tables are loaded, see chessSearch::probeRootTables
+    else if (name == "BitbasePath")
+    {
+        if (!value.empty() && value != "<empty>" && !bitbaseRegistry::instance().loadDirectory(value))
+        {
+            send("info string could not load bitbases from " + value);
+        }
+    }
+    else if (name == "SyzygyPath")
+    {
+        int found = syzygyTablebases::instance().init(value.empty() || value == "<empty>" ? "" : value);
+        send("info string " + std::to_string(found) + " Syzygy tables found");
+    }
+    else
+    {
+        send("info string unknown option " + name);
+    }
+}
+
+uint64_t uciEngine::bench(int depth, std::ostream &out)
+{
+    chessSearch benchSearch(16, 1);
+    searchLimits limits;
+    limits.maxDepth = depth;
+
+    uint64_t nodes = 0;
+    double seconds = 0.0;
+    for (const char *fen : benchPositions)
+    {
+        chessBoard position;
+        position.loadFEN(fen);
+        benchSearch.clear();
+        searchResult result = benchSearch.think(position, limits);
+        nodes += result.nodes;
+        seconds += result.seconds;
+        out << fen << ": " << result.nodes << " nodes, bestmove " << result.bestMove.toString() << "\n";
+    }
+
+    out << "===========================\n";
+    out << "Total time (ms) : " << static_cast<uint64_t>(seconds * 1000.0) << "\n";
+    out << "Nodes searched  : " << nodes << "\n";
+    out << "Nodes/second    : " << (seconds > 0.0 ? static_cast<uint64_t>(nodes / seconds) : 0) << std::endl;
+    return nodes;
+}
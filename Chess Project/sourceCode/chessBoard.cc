@@ -5,10 +5,22 @@
 #include "../header_files/Bishop.h"
 #include "../header_files/Queen.h"
 #include "../header_files/King.h"
+#include "../header_files/Tablebase.h"
+#include "../header_files/Trace.h"
 
-#include <iostream>
+#include <cctype>
+#include <cstdlib>
 #include <vector>
-#include <limits>
+
+static const int kingOffsets[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+static const int knightOffsets[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+static const int straightDirections[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+static const int diagonalDirections[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+
+static bool isOnBoard(int row, int col)
+{
+    return row >= 0 && row < 8 && col >= 0 && col < 8;
+}
 
 chessBoard::chessBoard() : currentTurn(Color::WHITE)
 {
@@ -68,6 +80,11 @@ void chessBoard::initializeBoard()
     // at the left side of 5th column bishop is king
     board[0][4] = std::make_unique<king>(Color::BLACK);
     board[7][4] = std::make_unique<king>(Color::WHITE);
+
+    if (network)
+    {
+        refreshAccumulator();
+    }
 }
 
 
@@ -113,8 +130,36 @@ std::vector<position> chessBoard::getAttackableRoute(position attacker, position
     return route;
 }
 
+void (*chessBoard::messageHandler)(const std::string &message) = nullptr;
+pieceType (*chessBoard::promotionHandler)(Color color) = nullptr;
+
+void chessBoard::setMessageHandler(void (*handler)(const std::string &message))
+{
+    messageHandler = handler;
+}
+
+void chessBoard::setPromotionHandler(pieceType (*handler)(Color color))
+{
+    promotionHandler = handler;
+}
+
+bool chessBoard::movePiece(int startX, int startY, int endX, int endY, pieceType promotion)
+{
+    TRACE_ZONE("chessBoard::movePiece");
+    // remember what stood on the squares this move can touch, the accumulators are
+    // then updated with only the pieces that actually changed
+    squareChange changes[maxSquareChanges];
+    int changeCount = 0;
+    if (network && board[startX][startY])
+    {
+        changeCount = collectSquareChanges(startX, startY, endX, endY, board[startX][startY]->getType(), changes);
+    }
+    bool moved = applyPlayerMove(startX, startY, endX, endY, promotion);
+    applySquareChanges(changes, changeCount);
+    return moved;
+}
 
-bool chessBoard::movePiece(int startX, int startY, int endX, int endY)
+bool chessBoard::applyPlayerMove(int startX, int startY, int endX, int endY, pieceType promotion)
 {
 
     // check if it is checkmate
@@ -131,6 +176,19 @@ bool chessBoard::movePiece(int startX, int startY, int endX, int endY)
 
     Piece *pieceToMove = board[startX][startY].get();
 
+    // fifty move counter resets on pawn moves and captures (en-passant is a pawn move). the
+    // counters only change once the move is on the board, a castling that fails its
+    // revalidation leaves them as they were
+    bool resetsClock = pieceToMove->getType() == pieceType::PAWN || board[endX][endY];
+    auto advanceCounters = [&]()
+    {
+        halfmoveClock = resetsClock ? 0 : halfmoveClock + 1;
+        if (currentTurn == Color::BLACK)
+        {
+            fullmoveNumber++;
+        }
+    };
+
     // it handle king and queen side castling
     if (pieceToMove->getType() == pieceType::KING && abs(startY - endY) == 2 && startX == endX)
     {
@@ -155,10 +213,14 @@ bool chessBoard::movePiece(int startX, int startY, int endX, int endY)
         board[startX][rookEndY] = std::move(board[startX][rookStartY]);
         board[startX][rookEndY]->setHasBeenMoved(true);
 
-        std::cout << (endY > startY ? "King-side" : "Queen-side") << " castling!!!" << std::endl;
+        if (messageHandler)
+        {
+            messageHandler(endY > startY ? "King-side castling!!!" : "Queen-side castling!!!");
+            messageHandler("Move is valid.");
+        }
     enPassantTargetColumn = -1;
     enPassantTargetRow = -1;
-    std::cout << "Move is valid." << std::endl;
+    advanceCounters();
     currentTurn = opponentColor;
     return true;
     }
@@ -174,18 +236,22 @@ bool chessBoard::movePiece(int startX, int startY, int endX, int endY)
         board[capturedPawnRow][endY] = nullptr;
 
         board[endX][endY]->setHasBeenMoved(true);
-        std::cout << "Special Move: en-Passant\n";
+        if (messageHandler)
+        {
+            messageHandler("Special Move: en-Passant");
+            messageHandler("Move is valid.");
+        }
 
     enPassantTargetColumn = -1;
     enPassantTargetRow = -1;
-    std::cout << "Move is valid." << std::endl;
+    advanceCounters();
     currentTurn = opponentColor;
     return true;
     }
 
     // capture Declaration Message (Format: Q7dxB4)
 
-    if (board[endX][endY])
+    if (board[endX][endY] && messageHandler)
     {
         char attackingPiece = board[startX][startY]->getSymbol();
         char capturedPiece = board[endX][endY]->getSymbol();
@@ -193,7 +259,7 @@ bool chessBoard::movePiece(int startX, int startY, int endX, int endY)
         int startRank = 8 - startX;
         char endFile = 'a' + endY;
         int endRank = 8 - endX;
-        std::cout << attackingPiece << startRank << startFile << "x" << capturedPiece << endRank << endFile << "\n";
+        messageHandler(attackingPiece + std::to_string(startRank) + startFile + "x" + capturedPiece + std::to_string(endRank) + endFile);
     }
 
     // normal Move of Piece
@@ -215,22 +281,36 @@ bool chessBoard::movePiece(int startX, int startY, int endX, int endY)
     // pawn promotion
     if (board[endX][endY]->getType() == pieceType::PAWN && (endX == 0 || endX == 7))
     {
-        pawnPromotion(endX, endY);
+        if (promotion == pieceType::KING || promotion == pieceType::PAWN)
+        {
+            pawnPromotion(endX, endY);
+        }
+        else
+        {
+            board[endX][endY] = createPiece(promotion, board[endX][endY]->getColor());
+            board[endX][endY]->setHasBeenMoved(true);
+        }
     }
 
     // check game state like checks, checkmate
     if (isCheckmate(opponentColor))
     {
-        std::cout << "CHECKMATE\n"
-                  << (currentTurn == Color::WHITE ? "WHITE" : "BLACK") << " wins!" << std::endl;
+        if (messageHandler)
+        {
+            messageHandler(std::string("CHECKMATE\n") + (currentTurn == Color::WHITE ? "WHITE" : "BLACK") + " wins!");
+        }
         gameOver = true;
         checkMate = true;
     }
-    else if (isKingInCheck(opponentColor))
+    else if (isKingInCheck(opponentColor) && messageHandler)
+    {
+        messageHandler("CHECK");
+    }
+    if (messageHandler)
     {
-        std::cout << "CHECK\n";
+        messageHandler("Move is valid.");
     }
-    std::cout << "Move is valid." << std::endl;
+    advanceCounters();
     currentTurn = opponentColor;
     return true;
 }
@@ -269,11 +349,17 @@ position chessBoard::getKingPosition(Color kingColor) const
 // check it the enemy piece posses threat to attack the piece at (x,y)
 bool chessBoard::canEnemyPieceAttack(int targetX, int targetY, Color enemyColor) const
 {
+    TRACE_ZONE("chessBoard::canEnemyPieceAttack");
     for (int i = 0; i < 8; i++)
     {
         for (int j = 0; j < 8; j++)
         {
-            if (board[i][j] && board[i][j]->getColor() == enemyColor && board[i][j]->isValidMove(i, j, targetX, targetY, *this))
+            // a piece doesn't attack the square it stands on
+            if ((i == targetX && j == targetY) || !board[i][j] || board[i][j]->getColor() != enemyColor)
+            {
+                continue;
+            }
+            if (board[i][j]->isValidMove(i, j, targetX, targetY, *this))
             {
                 return true;
             }
@@ -286,7 +372,73 @@ bool chessBoard::canEnemyPieceAttack(int targetX, int targetY, Color enemyColor)
 bool chessBoard::isKingInCheck(Color kingColor) const
 {
     position kingPosition = getKingPosition(kingColor);
-    return canEnemyPieceAttack(kingPosition.row, kingPosition.column, (kingColor == Color::WHITE) ? Color::BLACK : Color::WHITE);
+    return isSquareAttacked(kingPosition.row, kingPosition.column, (kingColor == Color::WHITE) ? Color::BLACK : Color::WHITE);
+}
+
+// looks outwards from the square instead of asking every enemy piece, same answer as
+// canEnemyPieceAttack for occupied squares but only a handful of board reads
+bool chessBoard::isSquareAttacked(int row, int column, Color byColor) const
+{
+    // a white pawn captures towards row - 1, so it attacks from the row below
+    int pawnRow = (byColor == Color::WHITE) ? row + 1 : row - 1;
+    for (int dc = -1; dc <= 1; dc += 2)
+    {
+        if (isOnBoard(pawnRow, column + dc))
+        {
+            Piece *piece = board[pawnRow][column + dc].get();
+            if (piece && piece->getColor() == byColor && piece->getType() == pieceType::PAWN)
+            {
+                return true;
+            }
+        }
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+        int r = row + knightOffsets[i][0];
+        int c = column + knightOffsets[i][1];
+        if (isOnBoard(r, c))
+        {
+            Piece *piece = board[r][c].get();
+            if (piece && piece->getColor() == byColor && piece->getType() == pieceType::KNIGHT)
+            {
+                return true;
+            }
+        }
+        r = row + kingOffsets[i][0];
+        c = column + kingOffsets[i][1];
+        if (isOnBoard(r, c))
+        {
+            Piece *piece = board[r][c].get();
+            if (piece && piece->getColor() == byColor && piece->getType() == pieceType::KING)
+            {
+                return true;
+            }
+        }
+    }
+
+    for (int d = 0; d < 8; d++)
+    {
+        const int *direction = d < 4 ? straightDirections[d] : diagonalDirections[d - 4];
+        pieceType slider = d < 4 ? pieceType::ROOK : pieceType::BISHOP;
+        int r = row + direction[0];
+        int c = column + direction[1];
+        while (isOnBoard(r, c))
+        {
+            Piece *piece = board[r][c].get();
+            if (piece)
+            {
+                if (piece->getColor() == byColor && (piece->getType() == slider || piece->getType() == pieceType::QUEEN))
+                {
+                    return true;
+                }
+                break;
+            }
+            r += direction[0];
+            c += direction[1];
+        }
+    }
+    return false;
 }
 
 // simulates move and checks for king exposure
@@ -309,6 +461,8 @@ bool chessBoard::doesMovePutKingInCheck(int startX, int startY, int endX, int en
 
 bool chessBoard::isMoveValid(int startX, int startY, int endX, int endY, Color playerColor)
 {
+    TRACE_ZONE("chessBoard::isMoveValid");
+    isMoveValidCalls++;
     // first validate board bounds
     if (startX < 0 || startX >= 8 || startY < 0 || startY >= 8 || 
         endX < 0 || endX >= 8 || endY < 0 || endY >= 8) {
@@ -377,6 +531,7 @@ bool chessBoard::isMoveValid(int startX, int startY, int endX, int endY, Color p
 
 bool chessBoard::isCheckmate(Color color)
 {
+    TRACE_ZONE("chessBoard::isCheckmate");
     if (!isKingInCheck(color))
     {
         return false;
@@ -477,6 +632,7 @@ bool chessBoard::isCheckmate(Color color)
 
 bool chessBoard::hasAnyValidMove(Color color)
 {
+    TRACE_ZONE("chessBoard::hasAnyValidMove");
     // checking if king can move first
     position KingPosition = getKingPosition(color);
     for (int i = -1; i <= 1; i++)
@@ -534,6 +690,7 @@ bool chessBoard::hasAnyValidMove(Color color)
 // checking if game goes for stalemate i.e. draw
 bool chessBoard::isStalemate(Color color)
 {
+    TRACE_ZONE("chessBoard::isStalemate");
     // king shall not be in check
     if (isKingInCheck(color))
     {
@@ -564,6 +721,7 @@ bool chessBoard::isCastlingPathOpen(int row, int startY, int endY) const
 // checking validity of castling
 bool chessBoard::isCastlingValid(int kingXPos, int kingYPos, int rookXPos, int rookYPos, Color color)
 {
+    TRACE_ZONE("chessBoard::isCastlingValid");
 
     // king and rook must be in same row
     if (kingXPos != rookXPos)
@@ -655,85 +813,930 @@ void chessBoard::pawnPromotion(int x, int y)
     }
 
     Color color = board[x][y]->getColor();
-    char choice;
-    bool validChoice = false;
+    board[x][y] = createPiece(promotionHandler ? promotionHandler(color) : pieceType::QUEEN, color);
+    if (messageHandler)
+    {
+        messageHandler(std::string("Pawn promoted to ") + board[x][y]->getSymbol() + "!");
+    }
+}
 
-    // clearing any existing input
-    std::cin.clear();
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+bool chessBoard::tryCastling(Color color, bool kingSide)
+{
+    int row = (color == Color::WHITE) ? 7 : 0;
+    int kingY = 4;
+    int rookY = kingSide ? 7 : 0;
+    int targetKingY = kingSide ? 6 : 2;
 
-    std::cout << "\n PAWN PROMOTION FOR " << (color == Color::WHITE ? "WHITE" : "BLACK") << "!\n";
+    return movePiece(row, kingY, row, targetKingY);
+}
 
-    while (!validChoice)
+wdlResult chessBoard::probeEndgame()
+{
+    int wdl;
+    if (syzygyTablebases::instance().probeWDL(*this, wdl))
     {
-        std::cout << "Choose a piece to promote to (Q for Queen, R for Rook, B for Bishop, N for Knight): ";
-        std::cin >> choice;
-        choice = toupper(choice);
+        // cursed wins and blessed losses are draws under the fifty move rule
+        return wdl == WDL_WIN ? wdlResult::WIN : wdl == WDL_LOSS ? wdlResult::LOSS : wdlResult::DRAW;
+    }
+    return bitbaseRegistry::instance().probe(*this);
+}
 
-        switch (choice)
+std::unique_ptr<Piece> chessBoard::createPiece(pieceType type, Color color)
+{
+    switch (type)
+    {
+    case pieceType::KING:
+        return std::make_unique<king>(color);
+    case pieceType::QUEEN:
+        return std::make_unique<queen>(color);
+    case pieceType::ROOK:
+        return std::make_unique<rook>(color);
+    case pieceType::BISHOP:
+        return std::make_unique<bishop>(color);
+    case pieceType::KNIGHT:
+        return std::make_unique<knight>(color);
+    default:
+        return std::make_unique<pawn>(color);
+    }
+}
+
+// loads a position from Forsyth-Edwards notation, the board is left untouched on error
+bool chessBoard::loadFEN(const std::string &fen)
+{
+    // fields are separated by runs of whitespace, the last four may be missing
+    std::vector<std::string> fields;
+    for (size_t at = 0; at < fen.size();)
+    {
+        size_t end = at;
+        while (end < fen.size() && !isspace(static_cast<unsigned char>(fen[end])))
         {
-        case 'Q':
-            board[x][y] = std::make_unique<queen>(color);
-            validChoice = true;
-            break;
-        case 'R':
-            board[x][y] = std::make_unique<rook>(color);
-            validChoice = true;
-            break;
-        case 'B':
-            board[x][y] = std::make_unique<bishop>(color);
-            validChoice = true;
-            break;
-        case 'N':
-            board[x][y] = std::make_unique<knight>(color);
-            validChoice = true;
-            break;
+            end++;
+        }
+        if (end > at)
+        {
+            fields.push_back(fen.substr(at, end - at));
+        }
+        at = end + 1;
+    }
+    if (fields.size() < 2)
+    {
+        return false;
+    }
+    const std::string &placement = fields[0];
+    const std::string &side = fields[1];
+    std::string castling = fields.size() > 2 ? fields[2] : "-";
+    std::string enPassant = fields.size() > 3 ? fields[3] : "-";
+    int halfmove = fields.size() > 4 ? std::atoi(fields[4].c_str()) : 0;
+    int fullmove = fields.size() > 5 ? std::atoi(fields[5].c_str()) : 1;
+
+    std::array<std::array<std::unique_ptr<Piece>, 8>, 8> squares;
+    int row = 0, col = 0;
+    int kings[2] = {0, 0};
+    for (char ch : placement)
+    {
+        if (ch == '/')
+        {
+            if (col != 8)
+            {
+                return false;
+            }
+            row++;
+            col = 0;
+        }
+        else if (isdigit(static_cast<unsigned char>(ch)))
+        {
+            col += ch - '0';
+        }
+        else
+        {
+            pieceType type;
+            switch (tolower(static_cast<unsigned char>(ch)))
+            {
+            case 'k':
+                type = pieceType::KING;
+                break;
+            case 'q':
+                type = pieceType::QUEEN;
+                break;
+            case 'r':
+                type = pieceType::ROOK;
+                break;
+            case 'b':
+                type = pieceType::BISHOP;
+                break;
+            case 'n':
+                type = pieceType::KNIGHT;
+                break;
+            case 'p':
+                type = pieceType::PAWN;
+                break;
+            default:
+                return false;
+            }
+            if (row > 7 || col > 7)
+            {
+                return false;
+            }
+            Color color = isupper(static_cast<unsigned char>(ch)) ? Color::WHITE : Color::BLACK;
+            if (type == pieceType::KING)
+            {
+                kings[color == Color::WHITE ? 0 : 1]++;
+            }
+            squares[row][col] = createPiece(type, color);
+            // castling rights below decide which kings and rooks count as unmoved
+            bool onStartRow = type == pieceType::PAWN && row == (color == Color::WHITE ? 6 : 1);
+            squares[row][col]->setHasBeenMoved(!onStartRow);
+            col++;
+        }
+    }
+    if (row != 7 || col != 8 || kings[0] != 1 || kings[1] != 1 || (side != "w" && side != "b"))
+    {
+        return false;
+    }
 
-        default:
-            std::cout << "Invalid choice! Please enter Q, R, B, or N.\n";
-            std::cin.clear();
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    for (char right : castling)
+    {
+        int kingRow = isupper(static_cast<unsigned char>(right)) ? 7 : 0;
+        int rookColumn = tolower(static_cast<unsigned char>(right)) == 'k' ? 7 : tolower(static_cast<unsigned char>(right)) == 'q' ? 0 : -1;
+        Color color = kingRow == 7 ? Color::WHITE : Color::BLACK;
+        if (rookColumn == -1)
+        {
+            continue;
+        }
+        Piece *kingPiece = squares[kingRow][4].get();
+        Piece *rookPiece = squares[kingRow][rookColumn].get();
+        if (kingPiece && kingPiece->getType() == pieceType::KING && kingPiece->getColor() == color &&
+            rookPiece && rookPiece->getType() == pieceType::ROOK && rookPiece->getColor() == color)
+        {
+            kingPiece->setHasBeenMoved(false);
+            rookPiece->setHasBeenMoved(false);
         }
     }
 
-    std::cout << "Pawn promoted to " << board[x][y]->getSymbol() << "!\n";
+    board = std::move(squares);
+    currentTurn = side == "w" ? Color::WHITE : Color::BLACK;
+    enPassantTargetRow = -1;
+    enPassantTargetColumn = -1;
+    if (enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h' && enPassant[1] >= '1' && enPassant[1] <= '8')
+    {
+        enPassantTargetRow = 8 - (enPassant[1] - '0');
+        enPassantTargetColumn = enPassant[0] - 'a';
+    }
+    halfmoveClock = halfmove;
+    fullmoveNumber = fullmove;
+    gameOver = false;
+    checkMate = false;
+    if (network)
+    {
+        refreshAccumulator();
+    }
+    return true;
+}
+
+std::string chessBoard::toFEN() const
+{
+    std::string fen;
+    for (int i = 0; i < 8; i++)
+    {
+        int empty = 0;
+        for (int j = 0; j < 8; j++)
+        {
+            if (!board[i][j])
+            {
+                empty++;
+                continue;
+            }
+            if (empty)
+            {
+                fen += char('0' + empty);
+                empty = 0;
+            }
+            fen += board[i][j]->getSymbol();
+        }
+        if (empty)
+        {
+            fen += char('0' + empty);
+        }
+        if (i < 7)
+        {
+            fen += '/';
+        }
+    }
 
-    // clearing existing input
-    std::cin.clear();
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    fen += currentTurn == Color::WHITE ? " w " : " b ";
+
+    std::string castling;
+    const char rights[4] = {'K', 'Q', 'k', 'q'};
+    for (char right : rights)
+    {
+        int row = isupper(static_cast<unsigned char>(right)) ? 7 : 0;
+        int rookColumn = tolower(static_cast<unsigned char>(right)) == 'k' ? 7 : 0;
+        Piece *kingPiece = board[row][4].get();
+        Piece *rookPiece = board[row][rookColumn].get();
+        Color color = row == 7 ? Color::WHITE : Color::BLACK;
+        if (kingPiece && kingPiece->getType() == pieceType::KING && kingPiece->getColor() == color && !kingPiece->getHasBeenMoved() &&
+            rookPiece && rookPiece->getType() == pieceType::ROOK && rookPiece->getColor() == color && !rookPiece->getHasBeenMoved())
+        {
+            castling += right;
+        }
+    }
+    fen += castling.empty() ? "-" : castling;
+
+    if (enPassantTargetRow != -1)
+    {
+        fen += ' ';
+        fen += char('a' + enPassantTargetColumn);
+        fen += char('0' + 8 - enPassantTargetRow);
+    }
+    else
+    {
+        fen += " -";
+    }
+    fen += " " + std::to_string(halfmoveClock) + " " + std::to_string(fullmoveNumber);
+    return fen;
 }
 
-bool chessBoard::tryCastling(Color color, bool kingSide)
+bool chessBoard::hasCastlingRights() const
 {
-    int row = (color == Color::WHITE) ? 7 : 0;
-    int kingY = 4;
-    int rookY = kingSide ? 7 : 0;
-    int targetKingY = kingSide ? 6 : 2;
+    for (int row : {0, 7})
+    {
+        Piece *kingPiece = board[row][4].get();
+        if (!kingPiece || kingPiece->getType() != pieceType::KING || kingPiece->getHasBeenMoved())
+        {
+            continue;
+        }
+        for (int rookColumn : {0, 7})
+        {
+            Piece *rookPiece = board[row][rookColumn].get();
+            if (rookPiece && rookPiece->getType() == pieceType::ROOK && rookPiece->getColor() == kingPiece->getColor() && !rookPiece->getHasBeenMoved())
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
 
-    return movePiece(row, kingY, row, targetKingY);
+// random numbers for the position hash, fixed seed so keys are the same on every run
+struct zobristKeys
+{
+    uint64_t pieces[2][6][64];
+    uint64_t castling[4];
+    uint64_t enPassantFile[8];
+    uint64_t blackToMove;
+
+    zobristKeys()
+    {
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        auto next = [&state]()
+        {
+            // splitmix64
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        };
+        for (auto &color : pieces)
+        {
+            for (auto &type : color)
+            {
+                for (uint64_t &key : type)
+                {
+                    key = next();
+                }
+            }
+        }
+        for (uint64_t &key : castling)
+        {
+            key = next();
+        }
+        for (uint64_t &key : enPassantFile)
+        {
+            key = next();
+        }
+        blackToMove = next();
+    }
+};
+
+static const zobristKeys zobrist;
+
+uint64_t chessBoard::positionKey() const
+{
+    uint64_t key = currentTurn == Color::BLACK ? zobrist.blackToMove : 0;
+    for (int i = 0; i < 8; i++)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            const Piece *piece = board[i][j].get();
+            if (piece)
+            {
+                key ^= zobrist.pieces[piece->getColor() == Color::WHITE ? 0 : 1][static_cast<int>(piece->getType())][i * 8 + j];
+            }
+        }
+    }
+
+    // a right exists while the king and that rook are both unmoved on their home squares
+    for (int side = 0; side < 2; side++)
+    {
+        int row = side == 0 ? 7 : 0;
+        const Piece *kingPiece = board[row][4].get();
+        if (!kingPiece || kingPiece->getType() != pieceType::KING || kingPiece->getHasBeenMoved())
+        {
+            continue;
+        }
+        for (int rookSide = 0; rookSide < 2; rookSide++)
+        {
+            const Piece *rookPiece = board[row][rookSide == 0 ? 7 : 0].get();
+            if (rookPiece && rookPiece->getType() == pieceType::ROOK && rookPiece->getColor() == kingPiece->getColor() && !rookPiece->getHasBeenMoved())
+            {
+                key ^= zobrist.castling[side * 2 + rookSide];
+            }
+        }
+    }
+
+    if (enPassantTargetColumn != -1)
+    {
+        key ^= zobrist.enPassantFile[enPassantTargetColumn];
+    }
+    return key;
 }
 
-void chessBoard::displayBoard() const
+bool chessBoard::isInsufficientMaterial() const
 {
-    std::cout << " a b c d e f g h\n";
+    int minorPieces = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            if (!board[i][j] || board[i][j]->getType() == pieceType::KING)
+            {
+                continue;
+            }
+            pieceType type = board[i][j]->getType();
+            if (type != pieceType::BISHOP && type != pieceType::KNIGHT)
+            {
+                return false;
+            }
+            minorPieces++;
+        }
+    }
+    return minorPieces <= 1;
+}
+
+// feature piece code used by the network: colour * 6 + piece type, -1 for an empty square
+int chessBoard::featurePiece(int row, int column) const
+{
+    const Piece *piece = board[row][column].get();
+    if (!piece)
+    {
+        return -1;
+    }
+    return (piece->getColor() == Color::WHITE ? 0 : 6) + static_cast<int>(piece->getType());
+}
+
+// the squares a move may change: both ends, the en-passant victim and the castling rook
+int chessBoard::collectSquareChanges(int fromRow, int fromColumn, int toRow, int toColumn, pieceType mover, squareChange *changes) const
+{
+    int count = 0;
+    changes[count++] = {fromRow, fromColumn, 0};
+    changes[count++] = {toRow, toColumn, 0};
+    if (mover == pieceType::PAWN && fromColumn != toColumn)
+    {
+        changes[count++] = {fromRow, toColumn, 0};
+    }
+    else if (mover == pieceType::KING && std::abs(toColumn - fromColumn) == 2)
+    {
+        changes[count++] = {fromRow, toColumn > fromColumn ? 7 : 0, 0};
+        changes[count++] = {fromRow, toColumn > fromColumn ? toColumn - 1 : toColumn + 1, 0};
+    }
+    for (int i = 0; i < count; i++)
+    {
+        changes[i].before = featurePiece(changes[i].row, changes[i].column);
+    }
+    return count;
+}
+
+void chessBoard::applySquareChanges(const squareChange *changes, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        int after = featurePiece(changes[i].row, changes[i].column);
+        if (after == changes[i].before)
+        {
+            continue;
+        }
+        int square = changes[i].row * 8 + changes[i].column;
+        for (int perspective = 0; perspective < 2; perspective++)
+        {
+            if (changes[i].before != -1)
+            {
+                int feature = nnueNetwork::featureIndex(perspective, changes[i].before / 6, changes[i].before % 6, square);
+                network->removeFeature(*accumulator, perspective, feature);
+            }
+            if (after != -1)
+            {
+                network->addFeature(*accumulator, perspective, nnueNetwork::featureIndex(perspective, after / 6, after % 6, square));
+            }
+        }
+    }
+}
+
+void chessBoard::refreshAccumulator()
+{
+    network->resetAccumulator(*accumulator);
+    for (int row = 0; row < 8; row++)
+    {
+        for (int col = 0; col < 8; col++)
+        {
+            int code = featurePiece(row, col);
+            if (code == -1)
+            {
+                continue;
+            }
+            for (int perspective = 0; perspective < 2; perspective++)
+            {
+                network->addFeature(*accumulator, perspective, nnueNetwork::featureIndex(perspective, code / 6, code % 6, row * 8 + col));
+            }
+        }
+    }
+}
+
+void chessBoard::attachNetwork(const nnueNetwork *net)
+{
+    network = net && net->isLoaded() ? net : nullptr;
+    if (!network)
+    {
+        accumulator.reset();
+        return;
+    }
+    if (!accumulator)
+    {
+        accumulator = std::make_unique<nnueAccumulator>();
+    }
+    refreshAccumulator();
+}
+
+int chessBoard::evaluateNetwork() const
+{
+    return network->evaluate(*accumulator, currentTurn == Color::WHITE ? 0 : 1);
+}
+
+int chessBoard::pieceCount() const
+{
+    int count = 0;
     for (int i = 0; i < 8; i++)
     {
-        std::cout << 8 - i << " ";
         for (int j = 0; j < 8; j++)
         {
             if (board[i][j])
             {
-                std::cout << board[i][j]->getSymbol() << " ";
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+void chessBoard::addPawnMoves(int row, int col, Color color, std::vector<chessMove> &moves) const
+{
+    int direction = (color == Color::WHITE) ? -1 : 1;
+    int nextRow = row + direction;
+    if (!isOnBoard(nextRow, col))
+    {
+        return;
+    }
+    bool promotes = nextRow == 0 || nextRow == 7;
+    const pieceType promotions[4] = {pieceType::QUEEN, pieceType::ROOK, pieceType::BISHOP, pieceType::KNIGHT};
+
+    auto add = [&](int toCol)
+    {
+        if (promotes)
+        {
+            for (pieceType promotion : promotions)
+            {
+                moves.emplace_back(row, col, nextRow, toCol, promotion);
+            }
+        }
+        else
+        {
+            moves.emplace_back(row, col, nextRow, toCol);
+        }
+    };
+
+    if (!board[nextRow][col])
+    {
+        add(col);
+        bool onStartRow = (color == Color::WHITE) ? (row == 6) : (row == 1);
+        if (onStartRow && !board[nextRow + direction][col])
+        {
+            moves.emplace_back(row, col, nextRow + direction, col);
+        }
+    }
+
+    for (int dc = -1; dc <= 1; dc += 2)
+    {
+        int c = col + dc;
+        if (!isOnBoard(nextRow, c))
+        {
+            continue;
+        }
+        Piece *target = board[nextRow][c].get();
+        if (target)
+        {
+            if (target->getColor() != color && target->getType() != pieceType::KING)
+            {
+                add(c);
+            }
+        }
+        else if (nextRow == enPassantTargetRow && c == enPassantTargetColumn)
+        {
+            Piece *passed = board[row][c].get();
+            if (passed && passed->getType() == pieceType::PAWN && passed->getColor() != color)
+            {
+                moves.emplace_back(row, col, nextRow, c);
+            }
+        }
+    }
+}
+
+// same rules as isCastlingValid: unmoved king and rook, empty path, no check on the way
+void chessBoard::addCastlingMoves(Color color, std::vector<chessMove> &moves) const
+{
+    int row = (color == Color::WHITE) ? 7 : 0;
+    Color enemy = (color == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    Piece *kingPiece = board[row][4].get();
+    if (!kingPiece || kingPiece->getType() != pieceType::KING || kingPiece->getColor() != color || kingPiece->getHasBeenMoved())
+    {
+        return;
+    }
+    if (isSquareAttacked(row, 4, enemy))
+    {
+        return;
+    }
+
+    for (int rookColumn : {7, 0})
+    {
+        Piece *rookPiece = board[row][rookColumn].get();
+        if (!rookPiece || rookPiece->getType() != pieceType::ROOK || rookPiece->getColor() != color || rookPiece->getHasBeenMoved())
+        {
+            continue;
+        }
+        if (!isCastlingPathOpen(row, 4, rookColumn))
+        {
+            continue;
+        }
+        int step = (rookColumn == 7) ? 1 : -1;
+        if (isSquareAttacked(row, 4 + step, enemy) || isSquareAttacked(row, 4 + 2 * step, enemy))
+        {
+            continue;
+        }
+        moves.emplace_back(row, 4, row, 4 + 2 * step);
+    }
+}
+
+// every legal move for the side to move, promotions are listed once per piece
+void chessBoard::generateLegalMoves(std::vector<chessMove> &moves)
+{
+    generateLegalMovesCalls++;
+    moves.clear();
+    Color color = currentTurn;
+
+    for (int row = 0; row < 8; row++)
+    {
+        for (int col = 0; col < 8; col++)
+        {
+            Piece *piece = board[row][col].get();
+            if (!piece || piece->getColor() != color)
+            {
+                continue;
+            }
+
+            switch (piece->getType())
+            {
+            case pieceType::PAWN:
+                addPawnMoves(row, col, color, moves);
+                break;
+            case pieceType::KING:
+            case pieceType::KNIGHT:
+            {
+                const int(*offsets)[2] = piece->getType() == pieceType::KING ? kingOffsets : knightOffsets;
+                for (int i = 0; i < 8; i++)
+                {
+                    int r = row + offsets[i][0];
+                    int c = col + offsets[i][1];
+                    if (!isOnBoard(r, c))
+                    {
+                        continue;
+                    }
+                    Piece *target = board[r][c].get();
+                    if (!target || (target->getColor() != color && target->getType() != pieceType::KING))
+                    {
+                        moves.emplace_back(row, col, r, c);
+                    }
+                }
+                break;
+            }
+            default:
+            {
+                bool straight = piece->getType() != pieceType::BISHOP;
+                bool diagonal = piece->getType() != pieceType::ROOK;
+                for (int d = 0; d < 8; d++)
+                {
+                    if ((d < 4 && !straight) || (d >= 4 && !diagonal))
+                    {
+                        continue;
+                    }
+                    const int *direction = d < 4 ? straightDirections[d] : diagonalDirections[d - 4];
+                    int r = row + direction[0];
+                    int c = col + direction[1];
+                    while (isOnBoard(r, c))
+                    {
+                        Piece *target = board[r][c].get();
+                        if (target)
+                        {
+                            if (target->getColor() != color && target->getType() != pieceType::KING)
+                            {
+                                moves.emplace_back(row, col, r, c);
+                            }
+                            break;
+                        }
+                        moves.emplace_back(row, col, r, c);
+                        r += direction[0];
+                        c += direction[1];
+                    }
+                }
+                break;
             }
-            else
+            }
+        }
+    }
+    addCastlingMoves(color, moves);
+
+    // drop the moves that leave our own king attacked
+    moveUndo undo;
+    size_t legalCount = 0;
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        makeMove(moves[i], undo);
+        bool legal = !isKingInCheck(color);
+        unmakeMove(moves[i], undo);
+        if (legal)
+        {
+            moves[legalCount++] = moves[i];
+        }
+    }
+    moves.resize(legalCount);
+}
+
+bool chessBoard::isCapture(const chessMove &move) const
+{
+    if (board[move.toRow()][move.toColumn()])
+    {
+        return true;
+    }
+    Piece *mover = board[move.fromRow()][move.fromColumn()].get();
+    return mover && mover->getType() == pieceType::PAWN && move.fromColumn() != move.toColumn();
+}
+
+std::string chessBoard::toSAN(const chessMove &move)
+{
+    TRACE_ZONE("chessBoard::toSAN");
+    static const char pieceLetters[] = "KQRBNP";
+    int fromRow = move.fromRow(), fromCol = move.fromColumn();
+    int toRow = move.toRow(), toCol = move.toColumn();
+    Piece *mover = board[fromRow][fromCol].get();
+    if (!mover)
+    {
+        return move.toString();
+    }
+    pieceType type = mover->getType();
+    std::string target = {static_cast<char>('a' + toCol), static_cast<char>('8' - toRow)};
+
+    std::string san;
+    if (type == pieceType::KING && std::abs(toCol - fromCol) == 2)
+    {
+        san = toCol > fromCol ? "O-O" : "O-O-O";
+    }
+    else if (type == pieceType::PAWN)
+    {
+        if (isCapture(move))
+        {
+            san += static_cast<char>('a' + fromCol);
+            san += 'x';
+        }
+        san += target;
+        if (move.isPromotion())
+        {
+            san += '=';
+            san += pieceLetters[static_cast<int>(move.promotion())];
+        }
+    }
+    else
+    {
+        san += pieceLetters[static_cast<int>(type)];
+        // name the file, else the rank, else both when another piece of the same kind could go there too
+        std::vector<chessMove> moves;
+        generateLegalMoves(moves);
+        bool ambiguous = false, sameFile = false, sameRank = false;
+        for (const chessMove &other : moves)
+        {
+            if (other.toRow() != toRow || other.toColumn() != toCol || other == move)
             {
-                std::cout << ". ";
+                continue;
             }
+            if (board[other.fromRow()][other.fromColumn()]->getType() != type)
+            {
+                continue;
+            }
+            ambiguous = true;
+            sameFile = sameFile || other.fromColumn() == fromCol;
+            sameRank = sameRank || other.fromRow() == fromRow;
+        }
+        if (ambiguous && (!sameFile || sameRank))
+        {
+            san += static_cast<char>('a' + fromCol);
         }
-        std::cout << 8 - i << " ";
+        if (ambiguous && sameFile)
+        {
+            san += static_cast<char>('8' - fromRow);
+        }
+        if (isCapture(move))
+        {
+            san += 'x';
+        }
+        san += target;
+    }
+
+    moveUndo undo;
+    makeMove(move, undo);
+    if (isKingInCheck(currentTurn))
+    {
+        std::vector<chessMove> replies;
+        generateLegalMoves(replies);
+        san += replies.empty() ? '#' : '+';
     }
-    std::cout << " a b c d e f g h\n";
+    unmakeMove(move, undo);
+    return san;
+}
 
-    std::cout << "\n"
-              << (currentTurn == Color::WHITE ? "WHITE" : "BLACK") << " to move\n";
-}
\ No newline at end of file
+bool chessBoard::fromSAN(const std::string &text, chessMove &move)
+{
+    std::string wanted = text;
+    while (!wanted.empty() && (wanted.back() == '+' || wanted.back() == '#' || wanted.back() == '!' || wanted.back() == '?'))
+    {
+        wanted.pop_back();
+    }
+    // castling is sometimes written with zeros
+    if (wanted == "0-0" || wanted == "0-0-0")
+    {
+        wanted = wanted.size() == 3 ? "O-O" : "O-O-O";
+    }
+    // only moves to the named square are written out and compared
+    int toRow = -1, toCol = -1;
+    for (size_t i = 0; i + 1 < wanted.size(); i++)
+    {
+        if (wanted[i] >= 'a' && wanted[i] <= 'h' && wanted[i + 1] >= '1' && wanted[i + 1] <= '8')
+        {
+            toCol = wanted[i] - 'a';
+            toRow = '8' - wanted[i + 1];
+        }
+    }
+
+    std::vector<chessMove> moves;
+    generateLegalMoves(moves);
+    for (const chessMove &candidate : moves)
+    {
+        if (toRow >= 0 && (candidate.toRow() != toRow || candidate.toColumn() != toCol))
+        {
+            continue;
+        }
+        std::string san = toSAN(candidate);
+        if (!san.empty() && (san.back() == '+' || san.back() == '#'))
+        {
+            san.pop_back();
+        }
+        if (san == wanted)
+        {
+            move = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void chessBoard::makeMove(const chessMove &move, moveUndo &undo)
+{
+    int fromRow = move.fromRow(), fromCol = move.fromColumn();
+    int toRow = move.toRow(), toCol = move.toColumn();
+    Piece *mover = board[fromRow][fromCol].get();
+    Color color = mover->getColor();
+    bool pawnMove = mover->getType() == pieceType::PAWN;
+
+    squareChange changes[maxSquareChanges];
+    int changeCount = network ? collectSquareChanges(fromRow, fromCol, toRow, toCol, mover->getType(), changes) : 0;
+
+    undo.previousEnPassantRow = enPassantTargetRow;
+    undo.previousEnPassantColumn = enPassantTargetColumn;
+    undo.previousHalfmoveClock = halfmoveClock;
+    undo.moverHadMoved = mover->getHasBeenMoved();
+    undo.rookHadMoved = false;
+    undo.capturedRow = -1;
+
+    // en-passant takes the pawn beside us, every other capture takes the target square
+    if (pawnMove && fromCol != toCol && !board[toRow][toCol])
+    {
+        undo.capturedRow = fromRow;
+        undo.capturedColumn = toCol;
+        undo.captured = std::move(board[fromRow][toCol]);
+    }
+    else if (board[toRow][toCol])
+    {
+        undo.capturedRow = toRow;
+        undo.capturedColumn = toCol;
+        undo.captured = std::move(board[toRow][toCol]);
+    }
+
+    board[toRow][toCol] = std::move(board[fromRow][fromCol]);
+    mover->setHasBeenMoved(true);
+
+    if (mover->getType() == pieceType::KING && std::abs(toCol - fromCol) == 2)
+    {
+        int rookFrom = (toCol > fromCol) ? 7 : 0;
+        int rookTo = (toCol > fromCol) ? toCol - 1 : toCol + 1;
+        undo.rookHadMoved = board[fromRow][rookFrom]->getHasBeenMoved();
+        board[fromRow][rookTo] = std::move(board[fromRow][rookFrom]);
+        board[fromRow][rookTo]->setHasBeenMoved(true);
+    }
+
+    if (move.isPromotion())
+    {
+        undo.promotedPawn = std::move(board[toRow][toCol]);
+        board[toRow][toCol] = createPiece(move.promotion(), color);
+        board[toRow][toCol]->setHasBeenMoved(true);
+    }
+
+    if (pawnMove && std::abs(toRow - fromRow) == 2)
+    {
+        enPassantTargetRow = (fromRow + toRow) / 2;
+        enPassantTargetColumn = fromCol;
+    }
+    else
+    {
+        enPassantTargetRow = -1;
+        enPassantTargetColumn = -1;
+    }
+
+    halfmoveClock = (pawnMove || undo.capturedRow != -1) ? 0 : halfmoveClock + 1;
+    if (color == Color::BLACK)
+    {
+        fullmoveNumber++;
+    }
+    currentTurn = (color == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    applySquareChanges(changes, changeCount);
+}
+
+void chessBoard::unmakeMove(const chessMove &move, moveUndo &undo)
+{
+    int fromRow = move.fromRow(), fromCol = move.fromColumn();
+    int toRow = move.toRow(), toCol = move.toColumn();
+    Color color = (currentTurn == Color::WHITE) ? Color::BLACK : Color::WHITE;
+
+    squareChange changes[maxSquareChanges];
+    int changeCount = 0;
+    if (network)
+    {
+        pieceType moverType = move.isPromotion() ? pieceType::PAWN : board[toRow][toCol]->getType();
+        changeCount = collectSquareChanges(fromRow, fromCol, toRow, toCol, moverType, changes);
+    }
+
+    if (move.isPromotion())
+    {
+        board[toRow][toCol] = std::move(undo.promotedPawn);
+    }
+    board[fromRow][fromCol] = std::move(board[toRow][toCol]);
+    Piece *mover = board[fromRow][fromCol].get();
+    mover->setHasBeenMoved(undo.moverHadMoved);
+
+    if (mover->getType() == pieceType::KING && std::abs(toCol - fromCol) == 2)
+    {
+        int rookFrom = (toCol > fromCol) ? 7 : 0;
+        int rookTo = (toCol > fromCol) ? toCol - 1 : toCol + 1;
+        board[fromRow][rookFrom] = std::move(board[fromRow][rookTo]);
+        board[fromRow][rookFrom]->setHasBeenMoved(undo.rookHadMoved);
+    }
+
+    if (undo.capturedRow != -1)
+    {
+        board[undo.capturedRow][undo.capturedColumn] = std::move(undo.captured);
+    }
+
+    enPassantTargetRow = undo.previousEnPassantRow;
+    enPassantTargetColumn = undo.previousEnPassantColumn;
+    halfmoveClock = undo.previousHalfmoveClock;
+    if (color == Color::BLACK)
+    {
+        fullmoveNumber--;
+    }
+    currentTurn = color;
+    applySquareChanges(changes, changeCount);
+}
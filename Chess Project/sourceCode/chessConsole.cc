@@ -0,0 +1,91 @@
+#include "../header_files/chessBoard.h"
+#include "../header_files/Pieces.h"
+
+#include <cctype>
+#include <iostream>
+#include <limits>
+
+// the console side of chessBoard, kept apart so that the rules library needs neither
+// iostream nor a terminal. only the front ends that talk to a console link this
+
+static void printMessage(const std::string &message)
+{
+    std::cout << message << std::endl;
+}
+
+void chessBoard::useConsole()
+{
+    setMessageHandler(printMessage);
+    setPromotionHandler(promptPromotionPiece);
+}
+
+pieceType chessBoard::promptPromotionPiece(Color color)
+{
+    char choice;
+
+    // clearing any existing input
+    std::cin.clear();
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+    std::cout << "\n PAWN PROMOTION FOR " << (color == Color::WHITE ? "WHITE" : "BLACK") << "!\n";
+
+    while (true)
+    {
+        std::cout << "Choose a piece to promote to (Q for Queen, R for Rook, B for Bishop, N for Knight): ";
+        std::cin >> choice;
+        choice = toupper(choice);
+
+        pieceType type;
+        switch (choice)
+        {
+        case 'Q':
+            type = pieceType::QUEEN;
+            break;
+        case 'R':
+            type = pieceType::ROOK;
+            break;
+        case 'B':
+            type = pieceType::BISHOP;
+            break;
+        case 'N':
+            type = pieceType::KNIGHT;
+            break;
+
+        default:
+            std::cout << "Invalid choice! Please enter Q, R, B, or N.\n";
+            std::cin.clear();
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            continue;
+        }
+
+        // clearing existing input
+        std::cin.clear();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        return type;
+    }
+}
+
+void chessBoard::displayBoard() const
+{
+    std::cout << " a b c d e f g h\n";
+    for (int i = 0; i < 8; i++)
+    {
+        std::cout << 8 - i << " ";
+        for (int j = 0; j < 8; j++)
+        {
+            if (board[i][j])
+            {
+                std::cout << board[i][j]->getSymbol() << " ";
+            }
+            else
+            {
+                std::cout << ". ";
+            }
+        }
+        std::cout << 8 - i << " ";
+    }
+    std::cout << " a b c d e f g h\n";
+
+    std::cout << "\n"
+              << (currentTurn == Color::WHITE ? "WHITE" : "BLACK") << " to move\n";
+}
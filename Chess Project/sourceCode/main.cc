@@ -1,28 +1,78 @@
 #include "../header_files/chessBoard.h"
 #include "../header_files/Pieces.h"
+#include "../header_files/Tablebase.h"
+#include "../header_files/Search.h"
+#include "../header_files/MateSolver.h"
+#include "../header_files/PositionCache.h"
+#include "../header_files/Trace.h"
+#include "../header_files/AssetPack.h"
+#include "../header_files/BoardArt.h"
+#include "../header_files/SoundCues.h"
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
 #include <iostream>
 #include <memory>
 #include <algorithm>
 #include <vector>
-#include <utility>
+#include <array>
 #include <string>
 #include <cmath>
+#include <cstdio>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+// started during static initialization, the closest the game gets to its process start
+static sf::Clock startupClock;
 
 class Chess
 {
 private:
     sf::RenderWindow window;
     chessBoard board;
-    sf::Texture pieceTexture[12];
-    sf::Sprite pieceSprites[8][8];
-    sf::RectangleShape squares[8][8];
+    // the 12 piece images packed into one texture at load time, with a white block that
+    // the solid quads sample, so squares, hints and pieces are a single textured draw
+    boardArt art;
+    // the board as three layers of 64 quads in drawing order: squares, selection and hint
+    // overlays, pieces. refreshBoardVertices rewrites only the squares whose piece or
+    // overlay changed since the last frame it ran in
+    static const int boardLayerVertices = 64 * 6;
+    // after the layers, the pieces of a move in flight: the captured one, a castling rook
+    // and the mover, rewritten every frame they move
+    static const int animationQuads = 3;
+    sf::VertexArray boardVertices{sf::Triangles, 3 * boardLayerVertices + animationQuads * 6};
+    int shownPiece[64];
+    int shownOverlay[64];
+    bool boardDirty = true;
+    uint64_t hintSquares = 0; // legal destinations of the selected piece
+    sf::VertexArray coordinateVertices{sf::Triangles};
     sf::Font font;
     sf::Text turnText;
     sf::Text statusText;
-    // move history
-    std::vector<std::pair<std::string, std::string>> moveHistory;
+    // every ply played, with what makeMove needs to take it back again; the board shows
+    // the position after the first currentPly of them, the arrow keys and clicks on the
+    // history move through them one unmake or remake at a time
+    std::vector<chessMove> playedMoves;
+    std::vector<moveUndo> playedUndo;
+    size_t currentPly = 0;
+    // the SAN of every ply, formatted the first time its row is shown and empty until then.
+    // no SAN is longer than seven characters ("exd8=Q+")
+    std::vector<std::array<char, 8>> plySan;
+    // rows of the history panel as last drawn, for clicks. the panel follows the current
+    // ply until the wheel scrolls it
+    float historyRowsTop = 0.f;
+    size_t historyFirstRow = 0;
+    size_t historyVisibleRows = 0;
+    bool historyFollowsPly = true;
+    // the moves of the shown rows and the current ply mark, rebuilt only when the moves,
+    // the current ply or the shown rows change
+    sf::VertexArray historyVertices{sf::Triangles};
+    bool historyDirty = true;
+    size_t historyBuiltFirstRow = 0;
+    size_t historyBuiltRows = 0;
+    size_t historyBuiltPly = 0;
     float historyPanelWidth = 260.f;
     float boardLeftPadding = 25.f;
     const float squareSizeConst = 80.0f;
@@ -39,22 +89,23 @@ private:
     float restartHeight = 48.f;
     sf::RectangleShape banner;
     sf::Text bannerText;
-    // sounds
-    sf::SoundBuffer moveBuffer;
-    sf::Sound moveSound;
-    bool moveSoundLoaded = false;
-    sf::SoundBuffer captureBuffer;
-    sf::Sound captureSound;
-    bool captureSoundLoaded = false;
-    sf::SoundBuffer checkBuffer;
-    sf::Sound checkSound;
-    bool checkSoundLoaded = false;
-    sf::SoundBuffer checkmateBuffer;
-    sf::Sound checkmateSound;
-    bool checkmateSoundLoaded = false;
-
-    sf::SoundBuffer warmupBuffer;
-    sf::Sound warmupSound;
+    // move, capture, check and checkmate, played from their own thread
+    soundCues sounds;
+
+    // assets.pak (tools/assetPack.cc) when it is there, the loose files in pieces_img
+    // otherwise. both stay in memory, the font reads its glyphs from them while the game runs
+    assetPack assets;
+    std::vector<char> looseFont;
+    struct decodedSound
+    {
+        std::vector<sf::Int16> samples;
+        unsigned channels = 0;
+        unsigned sampleRate = 0;
+    };
+    // cold start: the empty window, the assets and the first frame of the board, all from startupClock
+    float windowShownMs = 0.f;
+    float assetsMs = 0.f;
+    float startupMs = 0.f;
 
     sf::RectangleShape overlayDim;
     sf::RectangleShape modalCore;
@@ -66,12 +117,125 @@ private:
     sf::Text modalTitle;
     sf::Text modalSubtitle;
 
+    // computer opponent, searches on its own thread
+    // the network evaluates for it when nnue.bin is present, declared first so it outlives the search
+    nnueNetwork network;
+    searchWorker engine;
+    bool vsComputer = false;
+    Color computerColor = Color::BLACK;
+    int computerMoveTimeMs = 1500;
+    sf::Text modeText;
+
+    // "find mate" (M key) proves or refutes a forced mate for the side to move
+    mateWorker mateFinder;
+    int mateMaxMoves = 8;
+    int mateTimeMs = 20000;
+
+    // analysis mode (A key): a multi-PV search of the current position that runs until the
+    // position changes, shown as an eval bar beside the board and as lines in the history panel
+    searchWorker analysis;
+    bool analyzing = false;
+    int analysisLineCount = 3;
+    bool analysisWhiteToMove = true;
+    int analysisDepth = 0;
+    std::vector<std::string> analysisLines;
+    std::string evalLabel;
+    float evalTarget = 0.5f; // white's share of the bar
+    float evalShown = 0.5f;
+    float evalPrevious = 0.5f; // evalShown one tick ago, the bar is drawn between the two
+
+    // performance overlay (F3): CPU and display() time of the last hudFrames frames, draw
+    // calls and vertices of the last frame, rules calls per frame and during the last move,
+    // and the time from a click to the first frame presented after it
+    static const int hudFrames = 120;
+    struct frameSample
+    {
+        float cpuMs = 0.f;
+        float presentMs = 0.f;
+    };
+    bool showHud = false;
+    frameSample frameSamples[hudFrames];
+    int frameSampleIndex = 0;
+    sf::Clock hudClock;
+    sf::Time frameStart;
+    size_t drawCalls = 0;
+    size_t drawnVertices = 0;
+    size_t lastDrawCalls = 0;
+    size_t lastDrawnVertices = 0;
+    uint64_t frameMoveValidStart = 0;
+    uint64_t frameLegalMovesStart = 0;
+    uint64_t lastFrameMoveValidCalls = 0;
+    uint64_t lastFrameLegalMovesCalls = 0;
+    uint64_t lastMoveValidCalls = 0;
+    uint64_t lastMoveLegalMovesCalls = 0;
+    bool clickPending = false;
+    sf::Time clickTime;
+    float clickLatencyMs = 0.f;
+    float clickLatencyMaxMs = 0.f;
+    sf::VertexArray hudVertices{sf::Triangles};
+
+    // redraw on demand: with nothing running the loop sleeps in waitEvent. a running worker
+    // is looked at every workerPollInterval and its progress redrawn every progressInterval
+    bool needsRedraw = true;
+    sf::Time lastFrameTime;
+    const sf::Time progressInterval = sf::milliseconds(100);
+    const sf::Time workerPollInterval = sf::milliseconds(10);
+
+    // frame pacing (V toggles vsync): without vsync frames go out on a grid of frameInterval,
+    // with it display() waits for the screen and vsyncFloor only guards against drivers that
+    // ignore the request. a frame wanted straight after the previous one is missed when it
+    // comes more than one and a half display periods later
+    bool vsyncEnabled = true;
+    const sf::Time frameInterval = sf::microseconds(6944);
+    const sf::Time vsyncFloor = sf::microseconds(4167);
+    sf::Time nextFrameTime;
+    sf::Time lastPresentTime;
+    sf::Time displayPeriod; // shortest gap between back to back frames, the refresh period with vsync
+    bool backToBack = false;
+    uint64_t pacedFrames = 0;
+    uint64_t missedFrames = 0;
+
+    // animation logic runs in fixed ticks, frames are drawn between the last two ticks by
+    // how far the clock has got into the next one. the clock only runs while something moves
+    const sf::Time tickInterval = sf::microseconds(8333);
+    static const int maxTicksPerFrame = 8;
+    bool ticking = false;
+    sf::Time lastTickTime;
+    sf::Time tickAccumulator;
+    float tickAlpha = 1.f;
+
+    // a move slides its piece, and a castling rook, while a captured piece fades out, or
+    // back in when the move is taken back. fixed size, nothing is allocated while it runs
+    struct pieceSlide
+    {
+        int piece = -1; // atlas index, -1 for none
+        int fromSquare = 0;
+        int toSquare = 0;
+    };
+    struct moveAnimation
+    {
+        pieceSlide slides[2]; // the mover and a castling rook
+        int captured = -1;
+        int capturedSquare = 0;
+        bool capturedAppears = false;
+        uint64_t hiddenSquares = 0; // left empty in the piece layer until the slides land
+        float progress = 1.f;
+        float previousProgress = 1.f;
+    };
+    moveAnimation animation;
+    const float slideSeconds = 0.16f;
+
+    enum positionFlags
+    {
+        STATUS_CHECK = 1,
+        STATUS_NO_MOVES = 2
+    };
+    positionCache statusCache{1};
+
     int selectedX = -1, selectedY = -1;
     bool gameOver = false;
     bool showBanner = false;
 
-    sf::Color lightSquareColor = sf::Color(238, 238, 210);
-    sf::Color darkSquareColor = sf::Color(118, 150, 86);
     sf::Color highlightColor = sf::Color(246, 246, 105, 180);
     sf::Color moveHintColor = sf::Color(106, 190, 109, 180);
 
@@ -79,254 +243,179 @@ private:
     float getBoardStartX() const { return boardLeftPadding; }
     float getBoardStartY() const { return (window.getSize().y - getSquareSize() * 8) / 2.f; }
 
-    std::string coordToNotation(int row, int col)
+    // window.draw plus the draw call and vertex counts of SFML's own geometry for the overlay:
+    // a shape is a fan of points + 2 vertices and its outline a strip drawn separately, text is
+    // 6 vertices per visible glyph and its outline a second draw
+    void countDraw(size_t calls, size_t vertices)
     {
-        char file = 'a' + col;
-        int rank = 8 - row;
-        return std::string(1, file) + std::to_string(rank);
+        drawCalls += calls;
+        drawnVertices += vertices;
     }
 
-    std::string pieceLetter(pieceType t)
+    void render(const sf::Sprite &sprite)
     {
-        switch (t)
-        {
-        case pieceType::KING:
-            return "K";
-        case pieceType::QUEEN:
-            return "Q";
-        case pieceType::ROOK:
-            return "R";
-        case pieceType::BISHOP:
-            return "B";
-        case pieceType::KNIGHT:
-            return "N";
-        default:
-            return ""; // pawn has no letter in SAN
-        }
+        window.draw(sprite);
+        countDraw(1, 4);
     }
 
-    bool isCastlingMove(int fromX, int fromY, int toX, int toY, const Piece *mover)
+    void render(const sf::Shape &shape)
     {
-        if (!mover || mover->getType() != pieceType::KING)
-            return false;
-        return (fromX == toX) && (std::abs(toY - fromY) == 2);
+        window.draw(shape);
+        size_t points = shape.getPointCount();
+        bool outlined = shape.getOutlineThickness() != 0.f;
+        countDraw(outlined ? 2 : 1, points + 2 + (outlined ? (points + 1) * 2 : 0));
     }
 
-    // determine if any other same type piece can also move to (toX,toY) from a different square
-    std::string disambiguator(pieceType t, Color color, int fromX, int fromY, int toX, int toY)
+    void render(const sf::Text &text)
     {
-        if (t == pieceType::PAWN)
-            return "";
-        bool sameFileExists = false;
-        bool sameRankExists = false;
-        for (int r = 0; r < 8; ++r)
-        {
-            for (int c = 0; c < 8; ++c)
-            {
-                if (r == fromX && c == fromY)
-                    continue;
-                Piece *p = board.getPieceAt(r, c);
-                if (!p)
-                    continue;
-                if (p->getColor() != color)
-                    continue;
-                if (p->getType() != t)
-                    continue;
-                if (board.isMoveValid(r, c, toX, toY, color))
-                {
-                    if (c == fromY)
-                        sameFileExists = true;
-                    if (r == fromX)
-                        sameRankExists = true;
-                }
-            }
-        }
-        std::string d;
-        if (sameFileExists && sameRankExists)
-        {
-            d = std::string(1, char('a' + fromY)) + std::to_string(8 - fromX);
-        }
-        else if (sameFileExists)
+        window.draw(text);
+        size_t glyphs = 0;
+        for (sf::Uint32 c : text.getString())
         {
-            d = std::to_string(8 - fromX); // rank
+            glyphs += c != ' ' && c != '\t' && c != '\n';
         }
-        else if (sameRankExists)
+        if (glyphs > 0)
         {
-            d = std::string(1, char('a' + fromY)); // file
-        }
-        else
-        {
-            bool another = false;
-            for (int r = 0; r < 8 && !another; ++r)
-            {
-                for (int c = 0; c < 8 && !another; ++c)
-                {
-                    if (r == fromX && c == fromY)
-                        continue;
-                    Piece *p = board.getPieceAt(r, c);
-                    if (p && p->getColor() == color && p->getType() == t && board.isMoveValid(r, c, toX, toY, color))
-                    {
-                        another = true;
-                    }
-                }
-            }
-            if (another)
-                d = std::string(1, char('a' + fromY));
+            bool outlined = text.getOutlineThickness() != 0.f;
+            countDraw(outlined ? 2 : 1, glyphs * (outlined ? 12 : 6));
         }
-        return d;
     }
 
-    std::string generateSAN(Color mover, int fromX, int fromY, int toX, int toY)
+    void render(const sf::VertexArray &vertices, const sf::RenderStates &states)
     {
-        Piece *moverPiece = board.getPieceAt(fromX, fromY);
-        if (!moverPiece)
-            return coordToNotation(fromX, fromY) + "-" + coordToNotation(toX, toY);
-        pieceType t = moverPiece->getType();
+        window.draw(vertices, states);
+        countDraw(1, vertices.getVertexCount());
+    }
 
-        // castling
-        if (isCastlingMove(fromX, fromY, toX, toY, moverPiece))
-        {
-            return (toY > fromY) ? "O-O" : "O-O-O";
-        }
+    static uint64_t callsSince(uint64_t now, uint64_t before)
+    {
+        // restartGame replaces the board and its counters with it
+        return now >= before ? now - before : now;
+    }
 
-        // capture detection
-        bool wasTargetOccupied = false;
-        Piece *target = board.getPieceAt(toX, toY);
-        if (target && target->getColor() != mover)
-            wasTargetOccupied = true;
-        bool isEnPassant = false;
-        if (t == pieceType::PAWN && !wasTargetOccupied)
-        {
-            if (board.enPassantTargetRow == toX && board.enPassantTargetColumn == toY)
-            {
-                isEnPassant = true;
-            }
-        }
-        bool isCapture = wasTargetOccupied || isEnPassant;
 
-        std::string san;
-        if (t == pieceType::PAWN)
-        {
-            if (isCapture)
-            {
-                san += std::string(1, char('a' + fromY));
-                san += 'x';
-            }
-            san += coordToNotation(toX, toY);
-        }
-        else
+    // the asset's bytes from the pack, or read from pieces_img into the buffer. called from
+    // the decode threads at once, the pack is only read
+    bool assetBytes(const std::string &name, std::vector<char> &buffer, const void *&data, size_t &size) const
+    {
+        const uint8_t *packed = nullptr;
+        if (assets.isOpen() && assets.find(name, packed, size))
         {
-            san += pieceLetter(t);
-            san += disambiguator(t, mover, fromX, fromY, toX, toY);
-            if (isCapture)
-                san += 'x';
-            san += coordToNotation(toX, toY);
+            data = packed;
+            return true;
         }
-
-        // promotion
-        if (t == pieceType::PAWN)
+        std::ifstream in("pieces_img/" + name, std::ios::binary);
+        if (!in)
         {
-            bool toLastRank = (mover == Color::WHITE && toX == 0) || (mover == Color::BLACK && toX == 7);
-            if (toLastRank)
-                san += "=Q";
+            return false;
         }
-
-        return san;
+        buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data = buffer.data();
+        size = buffer.size();
+        return true;
     }
 
-    void addSanToHistory(Color mover, const std::string &san)
+    bool decodeImage(const std::string &name, sf::Image &image) const
     {
-        if (mover == Color::WHITE)
-        {
-            moveHistory.emplace_back(san, "");
-        }
-        else
-        {
-            if (moveHistory.empty())
-                moveHistory.emplace_back("", san);
-            else
-                moveHistory.back().second = san;
-        }
+        std::vector<char> buffer;
+        const void *data = nullptr;
+        size_t size = 0;
+        return assetBytes(name, buffer, data, size) && image.loadFromMemory(data, size);
     }
 
-    void loadTextures()
+    // the .ogg when there is one, the .wav otherwise
+    bool decodeSound(const std::string &stem, decodedSound &sound) const
     {
-        const std::string pieceNames[12] = {"W_king", "W_queen", "W_rook", "W_bishop", "W_knight", "W_pawn",
-                                            "B_king", "B_queen", "B_rook", "B_bishop", "B_knight", "B_pawn"};
-
-        for (int i = 0; i < 12; i++)
+        for (const char *extension : {".ogg", ".wav"})
         {
-            std::string filePath = "pieces_img/" + pieceNames[i] + ".png";
-            if (!pieceTexture[i].loadFromFile(filePath))
+            std::vector<char> buffer;
+            const void *data = nullptr;
+            size_t size = 0;
+            sf::InputSoundFile file;
+            if (!assetBytes(stem + extension, buffer, data, size) || !file.openFromMemory(data, size))
             {
-                std::cerr << "Error loading texture: " << filePath << std::endl;
+                continue;
             }
+            sound.samples.resize(static_cast<size_t>(file.getSampleCount()));
+            sound.samples.resize(static_cast<size_t>(file.read(sound.samples.data(), sound.samples.size())));
+            sound.channels = file.getChannelCount();
+            sound.sampleRate = file.getSampleRate();
+            return true;
         }
+        return false;
     }
 
-    void loadSounds()
+    // the pieces and the sounds are decoded on a few threads, this one included, while the
+    // window is already up. the texture, the sound buffers and the font are then created
+    // here, on the thread that owns the GL and OpenAL contexts
+    void loadAssets()
     {
-        // movement sound
-        const char *candidates[] = {"pieces_img/move.ogg", "pieces_img/move.wav"};
-        moveSoundLoaded = false;
-        for (const char *path : candidates)
+        TRACE_ZONE("Chess::loadAssets");
+        sf::Time start = startupClock.getElapsedTime();
+        if (std::filesystem::exists("assets.pak"))
         {
-            if (moveBuffer.loadFromFile(path))
-            {
-                moveSound.setBuffer(moveBuffer);
-                moveSound.setVolume(75.f);
-                moveSoundLoaded = true;
-                break;
-            }
+            assets.open("assets.pak");
         }
 
-        // capture sound
-        const char *captureCandidates[] = {"pieces_img/capture.ogg", "pieces_img/capture.wav"};
-        captureSoundLoaded = false;
-        for (const char *path : captureCandidates)
+        const std::string pieceNames[12] = {"W_king", "W_queen", "W_rook", "W_bishop", "W_knight", "W_pawn",
+                                            "B_king", "B_queen", "B_rook", "B_bishop", "B_knight", "B_pawn"};
+        const std::string soundNames[4] = {"move", "capture", "check", "checkmate"};
+        sf::Image images[12];
+        bool imageLoaded[12] = {};
+        decodedSound decodedSounds[4];
+        const int jobCount = 16;
+        std::atomic<int> nextJob{0};
+        auto decode = [&]()
         {
-            if (captureBuffer.loadFromFile(path))
+            for (int job = nextJob++; job < jobCount; job = nextJob++)
             {
-                captureSound.setBuffer(captureBuffer);
-                captureSound.setVolume(80.f);
-                captureSoundLoaded = true;
-                break;
+                if (job < 12)
+                {
+                    imageLoaded[job] = decodeImage(pieceNames[job] + ".png", images[job]);
+                }
+                else
+                {
+                    decodeSound(soundNames[job - 12], decodedSounds[job - 12]);
+                }
             }
+        };
+        std::vector<std::thread> workers;
+        unsigned helpers = std::min(static_cast<unsigned>(jobCount - 1), std::max(1u, std::thread::hardware_concurrency()) - 1);
+        for (unsigned i = 0; i < helpers; i++)
+        {
+            workers.emplace_back(decode);
         }
-        // check sound
-        const char *checkCandidates[] = {"pieces_img/check.ogg", "pieces_img/check.wav"};
-        checkSoundLoaded = false;
-        for (const char *path : checkCandidates)
+        decode();
+        for (std::thread &worker : workers)
         {
-            if (checkBuffer.loadFromFile(path))
-            {
-                checkSound.setBuffer(checkBuffer);
-                checkSound.setVolume(85.f);
-                checkSoundLoaded = true;
-                break;
-            }
+            worker.join();
         }
 
-        // Checkmate sound
-        const char *checkmateCandidates[] = {"pieces_img/checkmate.ogg", "pieces_img/checkmate.wav"};
-        checkmateSoundLoaded = false;
-        for (const char *path : checkmateCandidates)
+        for (int i = 0; i < 12; i++)
         {
-            if (checkmateBuffer.loadFromFile(path))
+            if (!imageLoaded[i])
             {
-                checkmateSound.setBuffer(checkmateBuffer);
-                checkmateSound.setVolume(90.f);
-                checkmateSoundLoaded = true;
-                break;
+                std::cerr << "Error loading texture: " << pieceNames[i] << ".png" << std::endl;
             }
         }
-    }
+        art.compose(images);
+        art.upload();
+        const soundCue cues[4] = {soundCue::MOVE, soundCue::CAPTURE, soundCue::CHECK, soundCue::CHECKMATE};
+        const float volumes[4] = {75.f, 80.f, 85.f, 90.f};
+        for (int i = 0; i < 4; i++)
+        {
+            const decodedSound &decoded = decodedSounds[i];
+            sounds.load(cues[i], decoded.samples.data(), decoded.samples.size(), decoded.channels, decoded.sampleRate, volumes[i]);
+        }
+        sounds.start();
 
-    inline void playInstantly(sf::Sound &s)
-    {
-        s.stop();
-        s.setPlayingOffset(sf::Time::Zero);
-        s.play();
+        const void *fontData = nullptr;
+        size_t fontSize = 0;
+        if (!assetBytes("arial.ttf", looseFont, fontData, fontSize) || !font.loadFromMemory(fontData, fontSize))
+        {
+            std::cerr << "Error loading font" << std::endl;
+        }
+        assetsMs = (startupClock.getElapsedTime() - start).asMicroseconds() / 1000.f;
     }
 
     void setupRestartButtonVisuals()
@@ -404,28 +493,14 @@ private:
     void initializeBoard()
     {
         const float squareSize = getSquareSize();
-        const float startX = getBoardStartX();
         const float startY = getBoardStartY();
 
-        // creating squares
-        for (int i = 0; i < 8; i++)
-        {
-            for (int j = 0; j < 8; j++)
-            {
-                squares[i][j].setSize(sf::Vector2f(squareSize, squareSize));
-                squares[i][j].setPosition(startX + j * squareSize, startY + i * squareSize);
-                squares[i][j].setFillColor((i + j) % 2 == 0 ? darkSquareColor : lightSquareColor);
-            }
-        }
-
-        // initialize piece sprites
-        updatePieceSprites();
+        // nothing is shown yet, the first refresh writes every square
+        std::fill(std::begin(shownPiece), std::end(shownPiece), -2);
+        std::fill(std::begin(shownOverlay), std::end(shownOverlay), 0);
+        boardDirty = true;
 
-        // load font
-        if (!font.loadFromFile("pieces_img/arial.ttf"))
-        {
-            std::cerr << "Error loading font" << std::endl;
-        }
+        buildCoordinateVertices();
 
         // setup turn text
         turnText.setFont(font);
@@ -440,6 +515,13 @@ private:
         statusText.setFillColor(sf::Color::White);
         statusText.setPosition(25, 60); // Adjusted position
 
+        // mode line under the board
+        modeText.setFont(font);
+        modeText.setCharacterSize(20);
+        modeText.setFillColor(sf::Color(200, 200, 200));
+        modeText.setPosition(25, startY + 8 * squareSize + 26);
+        updateModeText();
+
         // restart button (pill)
         setupRestartButtonVisuals();
 
@@ -512,35 +594,259 @@ private:
         banner.setOutlineThickness(0.f);
     }
 
-    void updatePieceSprites()
+    // the board changed under the vertices, the next frame compares every square
+    void markBoardDirty()
+    {
+        boardDirty = true;
+    }
+
+    // a piece of the side to move, or -1 for none; the hints are worked out once here
+    // instead of on every frame
+    void selectSquare(int x, int y)
+    {
+        selectedX = x;
+        selectedY = y;
+        hintSquares = 0;
+        if (x != -1)
+        {
+            for (int square = 0; square < 64; square++)
+            {
+                if (board.isMoveValid(x, y, square / 8, square % 8, board.getPlayerTurn()))
+                {
+                    hintSquares |= uint64_t(1) << square;
+                }
+            }
+        }
+        boardDirty = true;
+    }
+
+    void appendQuad(sf::VertexArray &vertices, float x, float y, float width, float height, sf::Color color, sf::FloatRect texture)
+    {
+        size_t first = vertices.getVertexCount();
+        vertices.resize(first + 6);
+        boardArt::writeQuad(&vertices[first], x, y, width, height, color, texture);
+    }
+
+    // glyph quads placed the way sf::Text places them, textured from font.getTexture(size)
+    void appendText(sf::VertexArray &vertices, const std::string &text, float x, float y, unsigned size, sf::Color color)
+    {
+        for (char c : text)
+        {
+            const sf::Glyph &glyph = font.getGlyph(static_cast<unsigned char>(c), size, false);
+            if (c != ' ')
+            {
+                sf::FloatRect texture(static_cast<float>(glyph.textureRect.left), static_cast<float>(glyph.textureRect.top),
+                                      static_cast<float>(glyph.textureRect.width), static_cast<float>(glyph.textureRect.height));
+                appendQuad(vertices, x + glyph.bounds.left, y + size + glyph.bounds.top, glyph.bounds.width, glyph.bounds.height, color, texture);
+            }
+            x += glyph.advance;
+        }
+    }
+
+    void buildCoordinateVertices()
+    {
+        const float squareSize = getSquareSize();
+        const float boardStartX = getBoardStartX();
+        const float boardStartY = getBoardStartY();
+        coordinateVertices.clear();
+        for (int j = 0; j < 8; j++)
+        {
+            appendText(coordinateVertices, std::string(1, 'a' + j), boardStartX + j * squareSize + squareSize - 20,
+                       boardStartY + 8 * squareSize, 16, sf::Color::White);
+        }
+        for (int i = 0; i < 8; i++)
+        {
+            appendText(coordinateVertices, std::to_string(8 - i), boardStartX - 20, boardStartY + i * squareSize + 5, 16,
+                       sf::Color::White);
+        }
+    }
+
+    void refreshBoardVertices()
     {
+        if (!boardDirty)
+        {
+            return;
+        }
+        TRACE_ZONE("Chess::refreshBoardVertices");
+        boardDirty = false;
+
         const float squareSize = getSquareSize();
         const float startX = getBoardStartX();
         const float startY = getBoardStartY();
-
-        for (int i = 0; i < 8; i++)
+        const sf::FloatRect solid = art.solid();
+        for (int square = 0; square < 64; square++)
         {
-            for (int j = 0; j < 8; j++)
+            int row = square / 8;
+            int column = square % 8;
+            int pieceIndex = (animation.hiddenSquares >> square) & 1 ? -1 : pieceIndexAt(square);
+            int overlay = row == selectedX && column == selectedY ? 1 : (hintSquares >> square) & 1 ? 2 : 0;
+            if (pieceIndex == shownPiece[square] && overlay == shownOverlay[square])
             {
-                Piece *piece = board.getPieceAt(i, j);
-                if (piece)
-                {
-                    int textureIndex = static_cast<int>(piece->getType()) + (piece->getColor() == Color::WHITE ? 0 : 6);
+                continue;
+            }
 
-                    pieceSprites[i][j].setTexture(pieceTexture[textureIndex]);
-                    pieceSprites[i][j].setPosition(startX + j * squareSize, startY + i * squareSize);
+            float x = startX + column * squareSize;
+            float y = startY + row * squareSize;
+            if (shownPiece[square] == -2)
+            {
+                boardArt::writeQuad(&boardVertices[square * 6], x, y, squareSize, squareSize,
+                                    (row + column) % 2 == 0 ? art.darkSquare : art.lightSquare, solid);
+            }
 
-                    // scale to fit the square
-                    sf::FloatRect bounds = pieceSprites[i][j].getLocalBounds();
-                    float scale = squareSize / std::max(bounds.width, bounds.height);
-                    pieceSprites[i][j].setScale(scale, scale);
+            // empty layers are quads of no size, they draw nothing
+            sf::Color overlayColor = overlay == 1 ? highlightColor : moveHintColor;
+            float overlaySize = overlay ? squareSize : 0.f;
+            boardArt::writeQuad(&boardVertices[boardLayerVertices + square * 6], x, y, overlaySize, overlaySize, overlayColor, solid);
 
-                    // center in square
-                    pieceSprites[i][j].setPosition(startX + j * squareSize + (squareSize - bounds.width * scale) / 2,
-                                                   startY + i * squareSize + (squareSize - bounds.height * scale) / 2);
-                }
+            art.writePieceQuad(&boardVertices[2 * boardLayerVertices + square * 6], pieceIndex, x, y, squareSize, sf::Color::White);
+
+            shownPiece[square] = pieceIndex;
+            shownOverlay[square] = overlay;
+        }
+    }
+
+    int pieceIndexAt(int square) const
+    {
+        return boardArt::pieceIndexAt(board, square);
+    }
+
+    bool animationRunning() const
+    {
+        return animation.previousProgress < 1.f;
+    }
+
+    // reads the position before the move, where all of its pieces are still on the board:
+    // before it is played going forward, after it is taken back going backward
+    void startMoveAnimation(const chessMove &move, bool forward)
+    {
+        int fromSquare = move.fromRow() * 8 + move.fromColumn();
+        int toSquare = move.toRow() * 8 + move.toColumn();
+        int mover = pieceIndexAt(fromSquare);
+        animation = moveAnimation();
+        if (mover < 0)
+        {
+            markBoardDirty();
+            return;
+        }
+        animation.progress = 0.f;
+        animation.previousProgress = 0.f;
+
+        // en passant takes the pawn beside the mover
+        animation.capturedSquare = toSquare;
+        if (pieceIndexAt(toSquare) < 0 && mover % 6 == static_cast<int>(pieceType::PAWN) && move.fromColumn() != move.toColumn())
+        {
+            animation.capturedSquare = move.fromRow() * 8 + move.toColumn();
+        }
+        animation.captured = pieceIndexAt(animation.capturedSquare);
+        animation.capturedAppears = !forward;
+
+        animation.slides[0] = forward ? pieceSlide{mover, fromSquare, toSquare} : pieceSlide{mover, toSquare, fromSquare};
+        if (mover % 6 == static_cast<int>(pieceType::KING) && std::abs(move.toColumn() - move.fromColumn()) == 2)
+        {
+            bool kingside = move.toColumn() > move.fromColumn();
+            int rookFrom = move.fromRow() * 8 + (kingside ? 7 : 0);
+            int rookTo = move.fromRow() * 8 + (kingside ? 5 : 3);
+            animation.slides[1] = forward ? pieceSlide{pieceIndexAt(rookFrom), rookFrom, rookTo}
+                                          : pieceSlide{pieceIndexAt(rookFrom), rookTo, rookFrom};
+        }
+        for (const pieceSlide &slide : animation.slides)
+        {
+            if (slide.piece >= 0)
+            {
+                animation.hiddenSquares |= uint64_t(1) << slide.toSquare;
             }
         }
+        if (!forward && animation.captured >= 0)
+        {
+            animation.hiddenSquares |= uint64_t(1) << animation.capturedSquare;
+        }
+        // the tick clock starts over, an idle spell before the move is not caught up on
+        ticking = false;
+        markBoardDirty();
+    }
+
+    void stopMoveAnimation()
+    {
+        animation = moveAnimation();
+        markBoardDirty();
+    }
+
+    // the moving pieces between the last two ticks, eased in and out
+    void writeAnimationVertices()
+    {
+        sf::Vertex *quads = &boardVertices[3 * boardLayerVertices];
+        float t = animation.previousProgress + (animation.progress - animation.previousProgress) * tickAlpha;
+        t = t * t * (3.f - 2.f * t);
+        const float squareSize = getSquareSize();
+        const float startX = getBoardStartX();
+        const float startY = getBoardStartY();
+
+        int captured = animationRunning() ? animation.captured : -1;
+        sf::Uint8 fade = static_cast<sf::Uint8>(255.f * (animation.capturedAppears ? t : 1.f - t));
+        art.writePieceQuad(&quads[0], captured, startX + (animation.capturedSquare % 8) * squareSize,
+                           startY + (animation.capturedSquare / 8) * squareSize, squareSize, sf::Color(255, 255, 255, fade));
+        for (int i = 0; i < 2; i++)
+        {
+            const pieceSlide &slide = animation.slides[i];
+            float fromX = startX + (slide.fromSquare % 8) * squareSize, fromY = startY + (slide.fromSquare / 8) * squareSize;
+            float toX = startX + (slide.toSquare % 8) * squareSize, toY = startY + (slide.toSquare / 8) * squareSize;
+            // the mover goes last so that it passes over everything else
+            art.writePieceQuad(&quads[(2 - i) * 6], animationRunning() ? slide.piece : -1, fromX + (toX - fromX) * t,
+                               fromY + (toY - fromY) * t, squareSize, sf::Color::White);
+        }
+    }
+
+    // one fixed step of everything that moves on its own
+    void tick()
+    {
+        float seconds = tickInterval.asSeconds();
+        animation.previousProgress = animation.progress;
+        animation.progress = std::min(1.f, animation.progress + seconds / slideSeconds);
+        if (!animationRunning() && animation.hiddenSquares)
+        {
+            // landed, the piece layer takes over
+            animation.hiddenSquares = 0;
+            markBoardDirty();
+        }
+
+        evalPrevious = evalShown;
+        evalShown += (evalTarget - evalShown) * std::min(1.f, seconds * 8.f);
+        if (std::abs(evalTarget - evalShown) < 0.002f)
+        {
+            evalShown = evalTarget;
+        }
+    }
+
+    // runs the ticks that are due and sets how far the next frame is into the next tick.
+    // a stall longer than maxTicksPerFrame ticks is dropped rather than replayed
+    void advanceTicks(sf::Time now)
+    {
+        if (!animationRunning() && !evalMoving())
+        {
+            ticking = false;
+            tickAlpha = 1.f;
+            return;
+        }
+        if (!ticking)
+        {
+            ticking = true;
+            lastTickTime = now;
+            tickAccumulator = sf::Time::Zero;
+        }
+        tickAccumulator += now - lastTickTime;
+        lastTickTime = now;
+        int ticks = 0;
+        while (tickAccumulator >= tickInterval && ticks < maxTicksPerFrame)
+        {
+            tick();
+            tickAccumulator -= tickInterval;
+            ticks++;
+        }
+        if (ticks == maxTicksPerFrame)
+        {
+            tickAccumulator = sf::Time::Zero;
+        }
+        tickAlpha = tickAccumulator.asSeconds() / tickInterval.asSeconds();
     }
 
     void updateTurnText()
@@ -550,7 +856,8 @@ private:
 
     void handleSquareClick(int x, int y)
     {
-        if (gameOver)
+        TRACE_ZONE("Chess::handleSquareClick");
+        if (gameOver || isComputerTurn())
         {
             return;
         }
@@ -566,8 +873,7 @@ private:
         // check if click is outside the box
         if (boardX < 0 || boardX >= 8 || boardY < 0 || boardY >= 8)
         {
-            selectedX = -1;
-            selectedY = -1;
+            selectSquare(-1, -1);
             return;
         }
 
@@ -577,199 +883,782 @@ private:
             Piece *piece = board.getPieceAt(boardX, boardY);
             if (piece && piece->getColor() == board.getPlayerTurn())
             {
-                selectedX = boardX;
-                selectedY = boardY;
+                selectSquare(boardX, boardY);
             }
         }
 
         // if a piece is already selected try to move it
         else
         {
-
-            Piece *moverPiece = board.getPieceAt(selectedX, selectedY);
-            Color moverColor = moverPiece ? moverPiece->getColor() : board.getPlayerTurn();
-            if (board.isMoveValid(selectedX, selectedY, boardX, boardY, moverColor))
-            {
-
-                std::string san = generateSAN(moverColor, selectedX, selectedY, boardX, boardY);
-                // determine capture before the move (includes en passant)
-                Piece *targetBefore = board.getPieceAt(boardX, boardY);
-                bool wasDirectCapture = targetBefore && targetBefore->getColor() != moverColor;
-                bool wasEnPassant = false;
-                if (moverPiece && moverPiece->getType() == pieceType::PAWN && !wasDirectCapture)
-                {
-                    if (board.enPassantTargetRow == boardX && board.enPassantTargetColumn == boardY)
-                    {
-                        wasEnPassant = true;
-                    }
-                }
-                if (board.movePiece(selectedX, selectedY, boardX, boardY))
-                {
-                    bool didCapture = wasDirectCapture || wasEnPassant;
-                    if (didCapture)
-                    {
-                        if (captureSoundLoaded)
-                            playInstantly(captureSound);
-                        else if (moveSoundLoaded)
-                            playInstantly(moveSound);
-                    }
-                    else
-                    {
-                        if (moveSoundLoaded)
-                            playInstantly(moveSound);
-                    }
-
-                    if (board.isCheckmate(board.getPlayerTurn()))
-                        san += '#';
-                    else if (board.isKingInCheck(board.getPlayerTurn()))
-                        san += '+';
-                    if (!san.empty())
-                    {
-                        if (san.back() == '#')
-                        {
-                            if (checkmateSoundLoaded)
-                                playInstantly(checkmateSound);
-                            else if (checkSoundLoaded)
-                                playInstantly(checkSound);
-                        }
-                        else if (san.back() == '+')
-                        {
-                            if (checkSoundLoaded)
-                                playInstantly(checkSound);
-                        }
-                    }
-                    addSanToHistory(moverColor, san);
-                    updatePieceSprites();
-                    updateTurnText();
-
-                    // check for game over
-                    if (board.isCheckmate(Color::WHITE) || board.isCheckmate(Color::BLACK))
-                    {
-                        gameOver = true;
-                        showBanner = true;
-                        std::string winner = (board.getPlayerTurn() == Color::WHITE ? "Black" : "White");
-                        setupGameOverModal("Checkmate!", winner + " wins", sf::Color(231, 76, 60));
-                    }
-                    else if (board.isStalemate(board.getPlayerTurn()))
-                    {
-                        gameOver = true;
-                        showBanner = true;
-                        setupGameOverModal("Stalemate", "Game drawn", sf::Color(241, 196, 15));
-                    }
-                }
-            }
-            selectedX = -1;
-            selectedY = -1;
+            applyMove(selectedX, selectedY, boardX, boardY, pieceType::KING);
+            selectSquare(-1, -1);
         }
     }
 
-    void restartGame()
+    // plays a move for whoever is on turn: sounds, history, sprites and game over checks
+    bool applyMove(int fromX, int fromY, int toX, int toY, pieceType promotion)
     {
-        board = chessBoard();
-        selectedX = -1;
-        selectedY = -1;
-        gameOver = false;
-        showBanner = false;
-        moveHistory.clear();
-        updatePieceSprites();
-        updateTurnText();
-    }
+        TRACE_ZONE("Chess::applyMove");
+        uint64_t moveValidBefore = board.isMoveValidCalls;
+        uint64_t legalMovesBefore = board.generateLegalMovesCalls;
+        Piece *moverPiece = board.getPieceAt(fromX, fromY);
+        Color moverColor = moverPiece ? moverPiece->getColor() : board.getPlayerTurn();
+        if (!board.isMoveValid(fromX, fromY, toX, toY, moverColor))
+        {
+            return false;
+        }
 
-    void draw()
-    {
-        window.clear(sf::Color(50, 50, 50));
+        // a running mate search would answer for the position we are leaving
+        mateFinder.cancel();
 
-        // draw board squares
-        for (int i = 0; i < 8; i++)
+        // determine capture before the move (includes en passant)
+        Piece *targetBefore = board.getPieceAt(toX, toY);
+        bool wasDirectCapture = targetBefore && targetBefore->getColor() != moverColor;
+        bool wasEnPassant = false;
+        if (moverPiece && moverPiece->getType() == pieceType::PAWN && !wasDirectCapture)
         {
-            for (int j = 0; j < 8; j++)
+            if (board.enPassantTargetRow == toX && board.enPassantTargetColumn == toY)
             {
-                window.draw(squares[i][j]);
+                wasEnPassant = true;
             }
         }
-
-        // highlight selected squares
-        if (selectedX != -1 && selectedY != -1)
+        // played with makeMove so that the history can take it back and replay it later
+        bool promoting = moverPiece && moverPiece->getType() == pieceType::PAWN && (toX == 0 || toX == 7);
+        if (promoting && promotion == pieceType::KING)
         {
-            sf::RectangleShape highlight = squares[selectedX][selectedY];
-            highlight.setFillColor(highlightColor);
-            window.draw(highlight);
-
-            // show possible moves
-            for (int i = 0; i < 8; i++)
-            {
-                for (int j = 0; j < 8; j++)
-                {
-                    if (board.isMoveValid(selectedX, selectedY, i, j, board.getPlayerTurn()))
-                    {
-                        sf::RectangleShape moveHint = squares[i][j];
-                        moveHint.setFillColor(moveHintColor);
-                        window.draw(moveHint);
-                    }
-                }
-            }
+            promotion = chessBoard::promptPromotionPiece(moverColor);
+        }
+        truncateHistory();
+        playedMoves.emplace_back(fromX, fromY, toX, toY, promoting ? promotion : pieceType::KING);
+        playedUndo.emplace_back();
+        plySan.emplace_back();
+        startMoveAnimation(playedMoves.back(), true);
+        board.makeMove(playedMoves.back(), playedUndo.back());
+        currentPly++;
+
+        bool didCapture = wasDirectCapture || wasEnPassant;
+        sounds.play(didCapture && sounds.isLoaded(soundCue::CAPTURE) ? soundCue::CAPTURE : soundCue::MOVE);
+
+        int status = positionStatus();
+        if (status == (STATUS_CHECK | STATUS_NO_MOVES))
+        {
+            sounds.play(sounds.isLoaded(soundCue::CHECKMATE) ? soundCue::CHECKMATE : soundCue::CHECK);
+        }
+        else if (status & STATUS_CHECK)
+        {
+            sounds.play(soundCue::CHECK);
+        }
+        historyDirty = true;
+        historyFollowsPly = true;
+        markBoardDirty();
+        updateTurnText();
+        statusText.setString(endgameStatus());
+        if (analyzing)
+        {
+            startAnalysis();
         }
 
-        // draw pieces
-        for (int i = 0; i < 8; i++)
+        // check for game over
+        if (status == (STATUS_CHECK | STATUS_NO_MOVES))
         {
-            for (int j = 0; j < 8; j++)
-            {
-                if (board.getPieceAt(i, j))
-                {
-                    window.draw(pieceSprites[i][j]);
-                }
-            }
+            gameOver = true;
+            showBanner = true;
+            std::string winner = (board.getPlayerTurn() == Color::WHITE ? "Black" : "White");
+            setupGameOverModal("Checkmate!", winner + " wins", sf::Color(231, 76, 60));
+        }
+        else if (status == STATUS_NO_MOVES)
+        {
+            gameOver = true;
+            showBanner = true;
+            setupGameOverModal("Stalemate", "Game drawn", sf::Color(241, 196, 15));
         }
+        lastMoveValidCalls = callsSince(board.isMoveValidCalls, moveValidBefore);
+        lastMoveLegalMovesCalls = callsSince(board.generateLegalMovesCalls, legalMovesBefore);
+        return true;
+    }
 
-        // draw coordinates
-        sf::Text coordinateText;
-        coordinateText.setFont(font);
-        coordinateText.setCharacterSize(16);
-        coordinateText.setFillColor(sf::Color::White);
+    bool isViewingLatest() const
+    {
+        return currentPly == playedMoves.size();
+    }
 
-        const float squareSize = getSquareSize();
-        const float boardStartX = getBoardStartX();
-        const float boardStartY = getBoardStartY();
+    // a move played from an earlier position replaces everything that came after it
+    void truncateHistory()
+    {
+        playedMoves.resize(currentPly);
+        playedUndo.resize(currentPly);
+        plySan.resize(currentPly);
+        historyDirty = true;
+    }
 
-        // draw file letter
-        for (int j = 0; j < 8; j++)
+    // one unmake or remake per ply, nothing else is updated
+    void walkToPly(size_t ply)
+    {
+        while (currentPly > ply)
         {
-            coordinateText.setString(std::string(1, 'a' + j));
-            coordinateText.setPosition(boardStartX + j * squareSize + squareSize - 20, boardStartY + 8 * squareSize);
-            window.draw(coordinateText);
+            currentPly--;
+            board.unmakeMove(playedMoves[currentPly], playedUndo[currentPly]);
         }
-
-        // draw rank number
-        for (int i = 0; i < 8; i++)
+        while (currentPly < ply)
         {
-            coordinateText.setString(std::to_string(8 - i));
-            coordinateText.setPosition(boardStartX - 20, boardStartY + i * squareSize + 5);
-            window.draw(coordinateText);
+            board.makeMove(playedMoves[currentPly], playedUndo[currentPly]);
+            currentPly++;
         }
-        // draw ui elements
-        window.draw(turnText);
-        window.draw(statusText);
-        // draw restart pill button
-        window.draw(restartShadowLeft);
-        window.draw(restartShadowRight);
-        window.draw(restartShadowCore);
-        window.draw(restartLeftCap);
-        window.draw(restartRightCap);
-        window.draw(restartCore);
-        window.draw(restartButtonText);
+    }
 
-        // history panel
-        float panelX = window.getSize().x - historyPanelWidth - 20.f;
-        float panelY = 100.f;
-        float reserved = restartHeight + 30.f;
-        sf::RectangleShape panelBg;
-        panelBg.setPosition(panelX, panelY);
-        panelBg.setSize(sf::Vector2f(historyPanelWidth, window.getSize().y - panelY - reserved));
-        panelBg.setFillColor(sf::Color(20, 20, 20, 200));
-        panelBg.setOutlineColor(sf::Color(255, 255, 255, 40));
+    // fills in the SAN of the plies in [firstPly, endPly) that have none yet. the board
+    // walks to the first of them, formats forward and walks back, so the cost is the
+    // distance to the shown position plus the new plies, however long the game is
+    void formatSan(size_t firstPly, size_t endPly)
+    {
+        endPly = std::min(endPly, playedMoves.size());
+        while (firstPly < endPly && plySan[firstPly][0] != '\0')
+        {
+            firstPly++;
+        }
+        while (endPly > firstPly && plySan[endPly - 1][0] != '\0')
+        {
+            endPly--;
+        }
+        if (firstPly == endPly)
+        {
+            return;
+        }
+        TRACE_ZONE("Chess::formatSan");
+        size_t shownPly = currentPly;
+        walkToPly(firstPly);
+        for (size_t ply = firstPly; ply < endPly; ply++)
+        {
+            if (plySan[ply][0] == '\0')
+            {
+                std::string san = board.toSAN(playedMoves[ply]);
+                san.copy(plySan[ply].data(), plySan[ply].size() - 1);
+            }
+            walkToPly(ply + 1);
+        }
+        walkToPly(shownPly);
+    }
+
+    // shows the position after the given number of plies, one unmake or remake per ply
+    void jumpToPly(size_t ply)
+    {
+        ply = std::min(ply, playedMoves.size());
+        if (ply == currentPly)
+        {
+            return;
+        }
+        // whatever was searching looked at the position we are leaving
+        engine.cancel();
+        mateFinder.cancel();
+        // a single step slides like a move, longer jumps land at once
+        if (ply == currentPly + 1)
+        {
+            startMoveAnimation(playedMoves[currentPly], true);
+            walkToPly(ply);
+        }
+        else if (ply + 1 == currentPly)
+        {
+            walkToPly(ply);
+            startMoveAnimation(playedMoves[ply], false);
+        }
+        else
+        {
+            walkToPly(ply);
+            stopMoveAnimation();
+        }
+        historyFollowsPly = true;
+
+        selectSquare(-1, -1);
+        gameOver = (positionStatus() & STATUS_NO_MOVES) != 0;
+        showBanner = false;
+        markBoardDirty();
+        updateTurnText();
+        statusText.setString(endgameStatus());
+        if (analyzing)
+        {
+            startAnalysis();
+        }
+    }
+
+    size_t historyRowCount() const
+    {
+        return (playedMoves.size() + 1) / 2;
+    }
+
+    size_t historyLastFirstRow() const
+    {
+        return historyRowCount() > historyVisibleRows ? historyRowCount() - historyVisibleRows : 0;
+    }
+
+    // the wheel over the panel scrolls it a row per notch, the next move or jump brings
+    // the current ply back into view
+    void scrollHistory(float x, float delta)
+    {
+        float panelX = window.getSize().x - historyPanelWidth - 20.f;
+        if (x < panelX || x > panelX + historyPanelWidth || delta == 0.f)
+        {
+            return;
+        }
+        size_t rows = static_cast<size_t>(std::max(1.f, std::round(std::abs(delta))));
+        if (delta > 0.f)
+        {
+            historyFirstRow = historyFirstRow > rows ? historyFirstRow - rows : 0;
+        }
+        else
+        {
+            historyFirstRow = std::min(historyFirstRow + rows, historyLastFirstRow());
+        }
+        historyFollowsPly = false;
+    }
+
+    // the rows in view as glyph quads on the size 20 font page, with the current ply marked.
+    // a long game costs no more than a short one: only the shown rows are formatted and
+    // built, and only when the moves, the current ply or the scroll position changed
+    void refreshHistoryVertices(float whiteX, float blackX)
+    {
+        if (historyFollowsPly)
+        {
+            size_t currentRow = currentPly > 0 ? (currentPly - 1) / 2 : 0;
+            historyFirstRow = currentRow >= historyVisibleRows && historyVisibleRows > 0 ? currentRow - historyVisibleRows + 1 : 0;
+        }
+        else
+        {
+            // fewer rows fit while the analysis lines are shown
+            historyFirstRow = std::min(historyFirstRow, historyLastFirstRow());
+        }
+        size_t endRow = std::min(historyRowCount(), historyFirstRow + historyVisibleRows);
+        if (!historyDirty && historyBuiltFirstRow == historyFirstRow && historyBuiltRows == historyVisibleRows &&
+            historyBuiltPly == currentPly)
+        {
+            return;
+        }
+        historyDirty = false;
+        historyBuiltFirstRow = historyFirstRow;
+        historyBuiltRows = historyVisibleRows;
+        historyBuiltPly = currentPly;
+
+        formatSan(historyFirstRow * 2, endRow * 2);
+        historyVertices.clear();
+        // the font page keeps a white square at (0, 0) for underlines, the mark samples it
+        const sf::FloatRect solid(1.f, 1.f, 0.f, 0.f);
+        float rowY = historyRowsTop;
+        for (size_t row = historyFirstRow; row < endRow; row++)
+        {
+            for (size_t side = 0; side < 2; side++)
+            {
+                size_t ply = row * 2 + side;
+                if (ply >= playedMoves.size())
+                {
+                    break;
+                }
+                float x = side == 0 ? whiteX : blackX;
+                if (ply + 1 == currentPly)
+                {
+                    appendQuad(historyVertices, x - 6.f, rowY, historyPanelWidth * 0.5f - 12.f, 24.f, sf::Color(255, 255, 255, 45), solid);
+                }
+                // the moves after the shown position are dimmed
+                appendText(historyVertices, plySan[ply].data(), x, rowY, 20,
+                           ply < currentPly ? sf::Color(240, 240, 240) : sf::Color(130, 130, 130));
+            }
+            rowY += 24.f;
+        }
+    }
+
+    // the ply whose move was clicked in the history panel, the position after it is shown
+    bool historyPlyAt(float x, float y, size_t &ply) const
+    {
+        float panelX = window.getSize().x - historyPanelWidth - 20.f;
+        if (x < panelX || x > panelX + historyPanelWidth || y < historyRowsTop)
+        {
+            return false;
+        }
+        size_t row = static_cast<size_t>((y - historyRowsTop) / 24.f);
+        if (row >= historyVisibleRows)
+        {
+            return false;
+        }
+        row += historyFirstRow;
+        ply = row * 2 + (x < panelX + historyPanelWidth * 0.5f ? 1 : 2);
+        return ply <= playedMoves.size();
+    }
+
+    // check and mate/stalemate flags for the side to move, cached per position
+    // so that positions reached again (repetitions, restarted games) cost one probe
+    int positionStatus()
+    {
+        uint64_t key = board.positionKey();
+        uint64_t payload;
+        int priority;
+        if (statusCache.probe(key, payload, priority))
+        {
+            return static_cast<int>(payload);
+        }
+
+        std::vector<chessMove> moves;
+        board.generateLegalMoves(moves);
+        int status = (board.isKingInCheck(board.getPlayerTurn()) ? STATUS_CHECK : 0) | (moves.empty() ? STATUS_NO_MOVES : 0);
+        statusCache.store(key, static_cast<uint64_t>(status), 0);
+        return status;
+    }
+
+    // only at the end of the game, going through the history never starts it
+    bool isComputerTurn() const
+    {
+        return vsComputer && board.getPlayerTurn() == computerColor && isViewingLatest();
+    }
+
+    void updateModeText()
+    {
+        modeText.setString(vsComputer ? "Mode: vs Computer (C to toggle, M find mate, A analyze)"
+                                      : "Mode: Human vs Human (C to toggle, M find mate, A analyze)");
+    }
+
+    void toggleComputer()
+    {
+        vsComputer = !vsComputer;
+        if (!vsComputer)
+        {
+            engine.cancel();
+            statusText.setString(endgameStatus());
+        }
+        updateModeText();
+    }
+
+    // called every pass of the loop: starts the engine on its turn, shows progress and plays its move
+    void updateComputerPlayer()
+    {
+        TRACE_ZONE("Chess::updateComputerPlayer");
+        if (!vsComputer || gameOver)
+        {
+            return;
+        }
+
+        searchResult result;
+        if (engine.takeResult(result))
+        {
+            const chessMove &move = result.bestMove;
+            needsRedraw = true;
+            if (applyMove(move.fromRow(), move.fromColumn(), move.toRow(), move.toColumn(), move.promotion()))
+            {
+                std::string status = "Computer: depth " + std::to_string(result.depth) + ", " +
+                                     std::to_string(result.nodesPerSecond() / 1000) + " kN/s";
+                std::string endgame = endgameStatus();
+                statusText.setString(endgame.empty() ? status : status + "  |  " + endgame);
+            }
+            return;
+        }
+
+        if (engine.isBusy())
+        {
+            double seconds = engine.getElapsedSeconds();
+            uint64_t nodesPerSecond = seconds > 0.0 ? static_cast<uint64_t>(engine.getNodes() / seconds) : 0;
+            statusText.setString("Computer thinking: depth " + std::to_string(engine.getCompletedDepth()) + ", " +
+                                 std::to_string(nodesPerSecond / 1000) + " kN/s");
+        }
+        else if (isComputerTurn())
+        {
+            searchLimits limits;
+            limits.moveTimeMs = computerMoveTimeMs;
+            engine.start(board.toFEN(), limits);
+        }
+    }
+
+    void findMate()
+    {
+        if (gameOver || mateFinder.isBusy() || engine.isBusy())
+        {
+            return;
+        }
+        mateLimits limits;
+        limits.maxMoves = mateMaxMoves;
+        limits.timeMs = mateTimeMs;
+        if (mateFinder.start(board.toFEN(), limits))
+        {
+            statusText.setString("Searching for mate...");
+        }
+    }
+
+    // called every pass of the loop: shows the solver's progress and its answer
+    void updateMateFinder()
+    {
+        mateResult result;
+        if (mateFinder.takeResult(result))
+        {
+            needsRedraw = true;
+            std::string side = board.getPlayerTurn() == Color::WHITE ? "White" : "Black";
+            std::string status;
+            if (result.status == mateStatus::PROVEN)
+            {
+                status = side + " mates in " + std::to_string(result.mateIn) + ":";
+                for (const chessMove &move : result.line)
+                {
+                    status += " " + move.toString();
+                }
+            }
+            else if (result.status == mateStatus::DISPROVEN)
+            {
+                status = "No mate for " + side + " in " + std::to_string(mateMaxMoves) + " moves or fewer";
+            }
+            else
+            {
+                status = "No mate found within the time limit (tried mate in " + std::to_string(result.mateIn) + ")";
+            }
+            statusText.setString(status);
+        }
+        else if (mateFinder.isBusy())
+        {
+            statusText.setString("Searching for mate: " + std::to_string(mateFinder.getNodes() / 1000) + "k nodes, " +
+                                 std::to_string(static_cast<int>(mateFinder.getElapsedSeconds())) + " s");
+        }
+    }
+
+    void toggleAnalysis()
+    {
+        analyzing = !analyzing;
+        if (analyzing)
+        {
+            startAnalysis();
+        }
+        else
+        {
+            analysis.cancel();
+            analysisLines.clear();
+        }
+    }
+
+    // drops whatever the old position had and searches the new one until it changes again
+    void startAnalysis()
+    {
+        analysis.cancel();
+        analysisLines.clear();
+        analysisDepth = 0;
+        if (gameOver)
+        {
+            return;
+        }
+        searchLimits limits;
+        limits.maxDepth = maxSearchPly - 1;
+        limits.multiPV = analysisLineCount;
+        analysisWhiteToMove = board.getPlayerTurn() == Color::WHITE;
+        analysis.start(board.toFEN(), limits);
+    }
+
+    static std::string scoreLabel(int whiteScore)
+    {
+        if (std::abs(whiteScore) >= mateBound)
+        {
+            int moves = (mateScore - std::abs(whiteScore) + 1) / 2;
+            return std::string(whiteScore > 0 ? "M" : "-M") + std::to_string(moves);
+        }
+        char text[16];
+        std::snprintf(text, sizeof(text), "%+.2f", whiteScore / 100.0);
+        return text;
+    }
+
+    // a line in SAN with move numbers, e.g. "12... Nf6 13. e5 Nd5"
+    std::string lineToSAN(const std::string &fen, const std::vector<chessMove> &moves, size_t maxPlies)
+    {
+        chessBoard scratch;
+        if (!scratch.loadFEN(fen))
+        {
+            return "";
+        }
+        std::string text;
+        for (size_t i = 0; i < moves.size() && i < maxPlies; i++)
+        {
+            if (scratch.getPlayerTurn() == Color::WHITE)
+            {
+                text += std::to_string(scratch.fullmoveNumber) + ". ";
+            }
+            else if (i == 0)
+            {
+                text += std::to_string(scratch.fullmoveNumber) + "... ";
+            }
+            text += scratch.toSAN(moves[i]) + " ";
+            moveUndo undo;
+            scratch.makeMove(moves[i], undo);
+        }
+        return text;
+    }
+
+    // called every pass of the loop: turns each finished depth into the bar target and the SAN lines,
+    // the search itself never touches the render thread
+    void updateAnalysis()
+    {
+        TRACE_ZONE("Chess::updateAnalysis");
+        searchResult result;
+        if (!analyzing || !analysis.takeIteration(result))
+        {
+            return;
+        }
+        needsRedraw = true;
+        std::string fen = board.toFEN();
+        analysisDepth = result.depth;
+        analysisLines.clear();
+        for (const searchLine &line : result.lines)
+        {
+            int whiteScore = analysisWhiteToMove ? line.score : -line.score;
+            analysisLines.push_back(scoreLabel(whiteScore) + "  " + lineToSAN(fen, line.moves, 5));
+        }
+        if (!result.lines.empty())
+        {
+            int whiteScore = analysisWhiteToMove ? result.lines[0].score : -result.lines[0].score;
+            evalLabel = scoreLabel(whiteScore);
+            evalTarget = std::abs(whiteScore) >= mateBound ? (whiteScore > 0 ? 1.f : 0.f)
+                                                           : 1.f / (1.f + std::exp(-whiteScore / 250.f));
+        }
+    }
+
+    bool evalMoving() const
+    {
+        return analyzing && (evalShown != evalTarget || evalPrevious != evalShown);
+    }
+
+    // white fills the bar from the bottom, eased towards the latest score by tick()
+    void drawEvalBar()
+    {
+        float shown = evalPrevious + (evalShown - evalPrevious) * tickAlpha;
+
+        const float squareSize = getSquareSize();
+        float x = getBoardStartX() + 8 * squareSize + 14.f;
+        float y = getBoardStartY();
+        float height = 8 * squareSize;
+        sf::RectangleShape back(sf::Vector2f(22.f, height));
+        back.setPosition(x, y);
+        back.setFillColor(sf::Color(40, 40, 40));
+        back.setOutlineColor(sf::Color(255, 255, 255, 40));
+        back.setOutlineThickness(1.f);
+        render(back);
+        sf::RectangleShape white(sf::Vector2f(22.f, height * shown));
+        white.setPosition(x, y + height * (1.f - shown));
+        white.setFillColor(sf::Color(235, 235, 235));
+        render(white);
+
+        sf::Text label(evalLabel, font, 12);
+        label.setFillColor(shown >= 0.5f ? sf::Color(40, 40, 40) : sf::Color(235, 235, 235));
+        sf::FloatRect bounds = label.getLocalBounds();
+        label.setPosition(x + 11.f - bounds.width / 2.f - bounds.left, shown >= 0.5f ? y + height - 18.f : y + 4.f);
+        render(label);
+    }
+
+    // the exact result once few enough pieces are left for the tablebases
+    std::string endgameStatus()
+    {
+        std::string side = board.getPlayerTurn() == Color::WHITE ? "White" : "Black";
+        std::string other = board.getPlayerTurn() == Color::WHITE ? "Black" : "White";
+        int wdl = 0;
+        int dtz = 0;
+        if (syzygyTablebases::instance().probeWDL(board, wdl))
+        {
+            std::string status;
+            if (wdl == WDL_WIN || wdl == WDL_LOSS)
+            {
+                status = "Tablebase: " + (wdl == WDL_WIN ? side : other) + " wins";
+                if (syzygyTablebases::instance().probeDTZ(board, dtz))
+                {
+                    status += " (DTZ " + std::to_string(std::abs(dtz)) + ")";
+                }
+            }
+            else
+            {
+                status = "Tablebase: draw";
+            }
+            return status;
+        }
+
+        switch (board.probeEndgame())
+        {
+        case wdlResult::WIN:
+            return "Bitbase: " + side + " wins";
+        case wdlResult::LOSS:
+            return "Bitbase: " + other + " wins";
+        case wdlResult::DRAW:
+            return "Bitbase: draw";
+        default:
+            return "";
+        }
+    }
+
+    void restartGame()
+    {
+        engine.newGame();
+        mateFinder.cancel();
+        board = chessBoard();
+        selectSquare(-1, -1);
+        gameOver = false;
+        showBanner = false;
+        playedMoves.clear();
+        playedUndo.clear();
+        plySan.clear();
+        historyDirty = true;
+        historyFollowsPly = true;
+        currentPly = 0;
+        stopMoveAnimation();
+        markBoardDirty();
+        updateTurnText();
+        statusText.setString("");
+        if (analyzing)
+        {
+            startAnalysis();
+        }
+    }
+
+    // shows the last finished frame, it is not counted in its own numbers
+    void drawHud()
+    {
+        const unsigned textSize = 13;
+        const float width = 2.f * hudFrames + 16.f;
+        const float graphHeight = 60.f;
+        const float graphMs = 33.3f;
+        const float x = getBoardStartX() + 8.f;
+        const float y = getBoardStartY() + 8.f;
+
+        float totalMs = 0.f, maxMs = 0.f, cpuMs = 0.f, presentMs = 0.f;
+        for (const frameSample &sample : frameSamples)
+        {
+            totalMs += sample.cpuMs + sample.presentMs;
+            maxMs = std::max(maxMs, sample.cpuMs + sample.presentMs);
+            cpuMs += sample.cpuMs;
+            presentMs += sample.presentMs;
+        }
+
+        const int lineCount = 7;
+        char lines[lineCount][128];
+        std::snprintf(lines[0], sizeof(lines[0]), "frame %.1f ms  max %.1f  cpu %.1f  present %.1f", totalMs / hudFrames, maxMs,
+                      cpuMs / hudFrames, presentMs / hudFrames);
+        std::snprintf(lines[1], sizeof(lines[1]), "draw calls %llu  vertices %llu", static_cast<unsigned long long>(lastDrawCalls),
+                      static_cast<unsigned long long>(lastDrawnVertices));
+        std::snprintf(lines[2], sizeof(lines[2]), "isMoveValid %llu/frame %llu/move  generateLegalMoves %llu/frame %llu/move",
+                      static_cast<unsigned long long>(lastFrameMoveValidCalls), static_cast<unsigned long long>(lastMoveValidCalls),
+                      static_cast<unsigned long long>(lastFrameLegalMovesCalls), static_cast<unsigned long long>(lastMoveLegalMovesCalls));
+        std::snprintf(lines[3], sizeof(lines[3]), "click to display %.1f ms  max %.1f", clickLatencyMs, clickLatencyMaxMs);
+        std::snprintf(lines[4], sizeof(lines[4]), "startup %.0f ms  window %.0f  assets %.0f (%s)", startupMs, windowShownMs, assetsMs,
+                      assets.isOpen() ? "pack" : "loose files");
+        float periodMs = (vsyncEnabled ? displayPeriod : frameInterval).asMicroseconds() / 1000.f;
+        std::snprintf(lines[5], sizeof(lines[5]), "vsync %s  period %.1f ms  animated frames %llu  missed %llu", vsyncEnabled ? "on" : "off",
+                      periodMs, static_cast<unsigned long long>(pacedFrames), static_cast<unsigned long long>(missedFrames));
+        std::snprintf(lines[6], sizeof(lines[6]), "sound trigger to play %.2f ms  max %.2f  played %llu  stolen %llu  dropped %llu",
+                      sounds.averageLatencyMs(), sounds.maxLatencyMs(), static_cast<unsigned long long>(sounds.getPlayedCount()),
+                      static_cast<unsigned long long>(sounds.getStolenCount()), static_cast<unsigned long long>(sounds.getDroppedCount()));
+
+        float lineHeight = textSize + 5.f;
+        float textWidth = 0.f;
+        for (const char *line : lines)
+        {
+            float lineWidth = 0.f;
+            for (const char *c = line; *c; c++)
+            {
+                lineWidth += font.getGlyph(static_cast<unsigned char>(*c), textSize, false).advance;
+            }
+            textWidth = std::max(textWidth, lineWidth);
+        }
+
+        hudVertices.clear();
+        // the font texture keeps a white square at (0, 0) for underlines, solid quads sample it
+        // so that the panel, the graph and the glyphs all go out in one draw call
+        const sf::FloatRect solid(1.f, 1.f, 0.f, 0.f);
+        appendQuad(hudVertices, x, y, std::max(width, textWidth + 16.f), graphHeight + lineCount * lineHeight + 24.f, sf::Color(0, 0, 0, 190), solid);
+
+        // oldest frame on the left, CPU time stacked under present time, a line at 60 fps
+        float graphTop = y + 8.f;
+        for (int i = 0; i < hudFrames; i++)
+        {
+            const frameSample &sample = frameSamples[(frameSampleIndex + i) % hudFrames];
+            float cpuHeight = std::min(sample.cpuMs / graphMs, 1.f) * graphHeight;
+            float presentHeight = std::min((sample.cpuMs + sample.presentMs) / graphMs, 1.f) * graphHeight - cpuHeight;
+            float barX = x + 8.f + 2.f * i;
+            appendQuad(hudVertices, barX, graphTop + graphHeight - cpuHeight, 2.f, cpuHeight, sf::Color(241, 156, 60), solid);
+            appendQuad(hudVertices, barX, graphTop + graphHeight - cpuHeight - presentHeight, 2.f, presentHeight, sf::Color(90, 150, 230), solid);
+        }
+        appendQuad(hudVertices, x + 8.f, graphTop + graphHeight * (1.f - 16.7f / graphMs), 2.f * hudFrames, 1.f, sf::Color(255, 255, 255, 120), solid);
+
+        for (int i = 0; i < lineCount; i++)
+        {
+            appendText(hudVertices, lines[i], x + 8.f, graphTop + graphHeight + 8.f + i * lineHeight, textSize, sf::Color(235, 235, 235));
+        }
+        // glyphs first: loading one can grow the texture
+        window.draw(hudVertices, sf::RenderStates(&font.getTexture(textSize)));
+    }
+
+    // closes the frame's numbers once display() has returned
+    void finishFrame(sf::Time presentStart)
+    {
+        sf::Time now = hudClock.getElapsedTime();
+        frameSample &sample = frameSamples[frameSampleIndex];
+        sample.cpuMs = (presentStart - frameStart).asMicroseconds() / 1000.f;
+        sample.presentMs = (now - presentStart).asMicroseconds() / 1000.f;
+        frameSampleIndex = (frameSampleIndex + 1) % hudFrames;
+
+        lastDrawCalls = drawCalls;
+        lastDrawnVertices = drawnVertices;
+        drawCalls = 0;
+        drawnVertices = 0;
+        lastFrameMoveValidCalls = callsSince(board.isMoveValidCalls, frameMoveValidStart);
+        lastFrameLegalMovesCalls = callsSince(board.generateLegalMovesCalls, frameLegalMovesStart);
+        frameMoveValidStart = board.isMoveValidCalls;
+        frameLegalMovesStart = board.generateLegalMovesCalls;
+
+        if (clickPending)
+        {
+            clickLatencyMs = (now - clickTime).asMicroseconds() / 1000.f;
+            clickLatencyMaxMs = std::max(clickLatencyMaxMs, clickLatencyMs);
+            clickPending = false;
+        }
+
+        // only frames the loop wanted back to back say anything about pacing. with vsync the
+        // display period is learnt from the shortest gap, without it the grid sets it
+        if (backToBack)
+        {
+            sf::Time gap = now - lastPresentTime;
+            if (vsyncEnabled && (displayPeriod == sf::Time::Zero || gap < displayPeriod))
+            {
+                displayPeriod = gap;
+            }
+            sf::Time period = vsyncEnabled ? displayPeriod : frameInterval;
+            pacedFrames++;
+            if (gap.asMicroseconds() * 2 > period.asMicroseconds() * 3)
+            {
+                missedFrames += static_cast<uint64_t>(gap.asSeconds() / period.asSeconds() + 0.5f) - 1;
+            }
+        }
+        lastPresentTime = now;
+    }
+
+    void draw()
+    {
+        TRACE_ZONE("Chess::draw");
+        window.clear(sf::Color(50, 50, 50));
+
+        // squares, hints and pieces, then the coordinates
+        refreshBoardVertices();
+        writeAnimationVertices();
+        render(boardVertices, sf::RenderStates(&art.atlas));
+        render(coordinateVertices, sf::RenderStates(&font.getTexture(16)));
+
+        // draw ui elements
+        render(turnText);
+        render(statusText);
+        render(modeText);
+        // draw restart pill button
+        render(restartShadowLeft);
+        render(restartShadowRight);
+        render(restartShadowCore);
+        render(restartLeftCap);
+        render(restartRightCap);
+        render(restartCore);
+        render(restartButtonText);
+
+        // history panel
+        float panelX = window.getSize().x - historyPanelWidth - 20.f;
+        float panelY = 100.f;
+        float reserved = restartHeight + 30.f;
+        sf::RectangleShape panelBg;
+        panelBg.setPosition(panelX, panelY);
+        panelBg.setSize(sf::Vector2f(historyPanelWidth, window.getSize().y - panelY - reserved));
+        panelBg.setFillColor(sf::Color(20, 20, 20, 200));
+        panelBg.setOutlineColor(sf::Color(255, 255, 255, 40));
         panelBg.setOutlineThickness(1.f);
-        window.draw(panelBg);
+        render(panelBg);
 
         // Column headers
         sf::Text headWhite, headBlack;
@@ -785,105 +1674,300 @@ private:
         headBlack.setString("Black");
         headWhite.setPosition(whiteX, panelY + 12.f);
         headBlack.setPosition(blackX, panelY + 12.f);
-        window.draw(headWhite);
-        window.draw(headBlack);
-
-        // Draw move history
-        float rowY = panelY + 40.f;
-        sf::Text whiteText, blackText;
-        whiteText.setFont(font);
-        blackText.setFont(font);
-        whiteText.setCharacterSize(20);
-        blackText.setCharacterSize(20);
-        whiteText.setFillColor(sf::Color(240, 240, 240));
-        blackText.setFillColor(sf::Color(240, 240, 240));
-        // positions already set above
-        for (const auto &p : moveHistory)
-        {
-            if (rowY > panelBg.getPosition().y + panelBg.getSize().y - 24.f)
-                break;
-            whiteText.setString(p.first);
-            blackText.setString(p.second);
-            whiteText.setPosition(whiteX, rowY);
-            blackText.setPosition(blackX, rowY);
-            window.draw(whiteText);
-            window.draw(blackText);
-            rowY += 24.f;
+        render(headWhite);
+        render(headBlack);
+
+        // analysis lines take the bottom of the panel
+        float historyBottom = panelBg.getPosition().y + panelBg.getSize().y;
+        if (analyzing)
+        {
+            drawEvalBar();
+            float analysisY = historyBottom - 34.f - 22.f * analysisLineCount;
+            historyBottom = analysisY;
+            sf::RectangleShape divider(sf::Vector2f(historyPanelWidth, 1.f));
+            divider.setPosition(panelX, analysisY);
+            divider.setFillColor(sf::Color(255, 255, 255, 40));
+            render(divider);
+
+            sf::Text heading("Analysis, depth " + std::to_string(analysisDepth), font, 16);
+            heading.setFillColor(sf::Color(200, 200, 200));
+            heading.setPosition(panelX + 16.f, analysisY + 6.f);
+            render(heading);
+            sf::Text lineText;
+            lineText.setFont(font);
+            lineText.setCharacterSize(14);
+            lineText.setFillColor(sf::Color(240, 240, 240));
+            for (size_t i = 0; i < analysisLines.size(); i++)
+            {
+                lineText.setString(analysisLines[i]);
+                lineText.setPosition(panelX + 10.f, analysisY + 30.f + 22.f * i);
+                render(lineText);
+            }
         }
 
+        // move history, only the rows in view
+        historyRowsTop = panelY + 40.f;
+        historyVisibleRows = historyRowsTop <= historyBottom - 24.f ? static_cast<size_t>((historyBottom - 24.f - historyRowsTop) / 24.f) + 1 : 0;
+        refreshHistoryVertices(whiteX, blackX);
+        render(historyVertices, sf::RenderStates(&font.getTexture(20)));
+
         // draw restart pill button under panel
-        window.draw(restartShadowLeft);
-        window.draw(restartShadowRight);
-        window.draw(restartShadowCore);
-        window.draw(restartLeftCap);
-        window.draw(restartRightCap);
-        window.draw(restartCore);
-        window.draw(restartButtonText);
+        render(restartShadowLeft);
+        render(restartShadowRight);
+        render(restartShadowCore);
+        render(restartLeftCap);
+        render(restartRightCap);
+        render(restartCore);
+        render(restartButtonText);
 
         // if game is over draw modal overlay
         if (showBanner)
         {
-            window.draw(overlayDim);
-            window.draw(modalShadowLeft);
-            window.draw(modalShadowRight);
-            window.draw(modalShadowCore);
-            window.draw(modalLeftCap);
-            window.draw(modalRightCap);
-            window.draw(modalCore);
+            render(overlayDim);
+            render(modalShadowLeft);
+            render(modalShadowRight);
+            render(modalShadowCore);
+            render(modalLeftCap);
+            render(modalRightCap);
+            render(modalCore);
             sf::Text titleShadow = modalTitle;
             titleShadow.setFillColor(sf::Color(0, 0, 0, 150));
             titleShadow.move(2.f, 2.f);
-            window.draw(titleShadow);
-            window.draw(modalTitle);
-            window.draw(modalSubtitle);
-            window.draw(banner);
+            render(titleShadow);
+            render(modalTitle);
+            render(modalSubtitle);
+            render(banner);
+        }
+        if (showHud)
+        {
+            drawHud();
         }
+        sf::Time presentStart = hudClock.getElapsedTime();
         window.display();
+        finishFrame(presentStart);
     }
 
 public:
     Chess() : window(sf::VideoMode(1080, 800), "Chess Game")
     {
-        loadTextures();
-        loadSounds();
+        window.setVerticalSyncEnabled(vsyncEnabled);
+        // something on screen before the first asset is read
+        window.clear(sf::Color(50, 50, 50));
+        window.display();
+        windowShownMs = startupClock.getElapsedTime().asMicroseconds() / 1000.f;
+        loadAssets();
         initializeBoard();
+
+        // one core stays free for drawing, the rest run Lazy SMP helpers
+        engine.setThreads(std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+        mateFinder.setThreads(std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+        analysis.setThreads(std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+
+        // both are optional, positions without a table are simply not annotated
+        syzygyTablebases::instance().init("syzygy");
+        bitbaseRegistry::instance().loadDirectory("bitbases");
+        if (network.load("nnue.bin"))
+        {
+            engine.setNetwork(&network);
+            analysis.setNetwork(&network);
+        }
     }
 
-    void run()
+    // the restart hover colour is all a mouse move can change, releases and typed
+    // characters change nothing, everything else is redrawn
+    void handleEvent(const sf::Event &event)
     {
-        while (window.isOpen())
+        TRACE_ZONE("Chess::handleEvent");
+        if (event.type == sf::Event::MouseMoved)
         {
-            sf::Event event;
-            while (window.pollEvent(event))
+            bool wasHovered = restartHovered;
+            updateRestartButtonHover(static_cast<float>(event.mouseMove.x), static_cast<float>(event.mouseMove.y));
+            needsRedraw = needsRedraw || restartHovered != wasHovered;
+            return;
+        }
+        if (event.type == sf::Event::KeyReleased || event.type == sf::Event::MouseButtonReleased ||
+            event.type == sf::Event::TextEntered)
+        {
+            return;
+        }
+        needsRedraw = true;
+
+        size_t clickedPly = 0;
+        if (event.type == sf::Event::Closed)
+        {
+            window.close();
+        }
+        else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3)
+        {
+            showHud = !showHud;
+        }
+        else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::V)
+        {
+            setVsync(!vsyncEnabled);
+        }
+        else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F12)
+        {
+            TRACE_DUMP("chess-trace.json");
+        }
+        else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::C)
+        {
+            toggleComputer();
+        }
+        else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::M)
+        {
+            findMate();
+        }
+        else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::A)
+        {
+            toggleAnalysis();
+        }
+        else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Left)
+        {
+            jumpToPly(currentPly > 0 ? currentPly - 1 : 0);
+        }
+        else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Right)
+        {
+            jumpToPly(currentPly + 1);
+        }
+        else if (event.type == sf::Event::KeyPressed && (event.key.code == sf::Keyboard::Up || event.key.code == sf::Keyboard::Home))
+        {
+            jumpToPly(0);
+        }
+        else if (event.type == sf::Event::KeyPressed && (event.key.code == sf::Keyboard::Down || event.key.code == sf::Keyboard::End))
+        {
+            jumpToPly(playedMoves.size());
+        }
+        else if (event.type == sf::Event::MouseWheelScrolled && event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel)
+        {
+            scrollHistory(static_cast<float>(event.mouseWheelScroll.x), event.mouseWheelScroll.delta);
+        }
+        else if (event.type == sf::Event::MouseButtonPressed)
+        {
+            // SFML events carry no timestamp, the latency starts when the click is polled
+            if (!clickPending)
+            {
+                clickPending = true;
+                clickTime = hudClock.getElapsedTime();
+            }
+            if (event.mouseButton.button == sf::Mouse::Left)
             {
-                if (event.type == sf::Event::Closed)
+                // check if restart pill is clicked
+                updateRestartButtonHover(static_cast<float>(event.mouseButton.x), static_cast<float>(event.mouseButton.y));
+                if (restartHovered)
                 {
-                    window.close();
+                    restartGame();
+                    setupRestartButtonVisuals(); 
                 }
-                else if (event.type == sf::Event::MouseMoved)
+                else if (modeText.getGlobalBounds().contains(static_cast<float>(event.mouseButton.x), static_cast<float>(event.mouseButton.y)))
                 {
-                    updateRestartButtonHover(static_cast<float>(event.mouseMove.x), static_cast<float>(event.mouseMove.y));
+                    toggleComputer();
                 }
-                else if (event.type == sf::Event::MouseButtonPressed)
+                else if (historyPlyAt(static_cast<float>(event.mouseButton.x), static_cast<float>(event.mouseButton.y), clickedPly))
+                {
+                    jumpToPly(clickedPly);
+                }
+                else
+                {
+                    handleSquareClick(event.mouseButton.x, event.mouseButton.y);
+                }
+            }
+        }
+    }
+
+    bool workersBusy() const
+    {
+        return engine.isBusy() || mateFinder.isBusy() || analysis.isBusy();
+    }
+
+    // blocks until there is something to do: with nothing running that is the next event,
+    // otherwise the next frame or the next look at the workers. true when it got an event
+    bool waitForWork(bool working, sf::Event &event)
+    {
+        if (!needsRedraw && !working)
+        {
+            return window.waitEvent(event);
+        }
+        sf::Time wait = workerPollInterval;
+        if (needsRedraw)
+        {
+            wait = std::min(wait, nextFrameTime - hudClock.getElapsedTime());
+        }
+        if (wait > sf::Time::Zero)
+        {
+            sf::sleep(wait);
+        }
+        return false;
+    }
+
+    // frames go out on a fixed grid so that pacing doesn't drift by the loop's own overhead,
+    // a frame that starts after its slot has passed starts a new grid
+    void scheduleNextFrame(sf::Time frameTime)
+    {
+        sf::Time interval = vsyncEnabled ? vsyncFloor : frameInterval;
+        nextFrameTime = frameTime < nextFrameTime + interval ? nextFrameTime + interval : frameTime + interval;
+    }
+
+    void setVsync(bool enabled)
+    {
+        vsyncEnabled = enabled;
+        window.setVerticalSyncEnabled(enabled);
+        displayPeriod = sf::Time::Zero;
+        pacedFrames = 0;
+        missedFrames = 0;
+    }
+
+    // F3 toggles the performance overlay and V vertical sync. with CHESS_TRACE defined F12
+    // writes chess-trace.json, closing the window writes it again
+    void run()
+    {
+        TRACE_THREAD("gui");
+        bool working = false;
+        while (window.isOpen())
+        {
+            sf::Event event;
+            bool waited = waitForWork(working, event);
+            TRACE_ZONE("Chess::frame");
+            frameStart = hudClock.getElapsedTime();
+            if (waited)
+            {
+                handleEvent(event);
+            }
+            while (window.pollEvent(event))
+            {
+                handleEvent(event);
+            }
+
+            // sampled before the results are collected: a worker posts its result before it
+            // stops being busy, so one finishing in between is collected next time round
+            working = workersBusy();
+            updateComputerPlayer();
+            updateMateFinder();
+            updateAnalysis();
+            working = working || workersBusy();
+
+            sf::Time now = hudClock.getElapsedTime();
+            if (working && now - lastFrameTime >= progressInterval)
+            {
+                needsRedraw = true;
+            }
+            if (needsRedraw && now >= nextFrameTime)
+            {
+                lastFrameTime = now;
+                scheduleNextFrame(now);
+                advanceTicks(now);
+                draw();
+                if (startupMs == 0.f)
                 {
-                    if (event.mouseButton.button == sf::Mouse::Left)
-                    {
-                        // check if restart pill is clicked
-                        updateRestartButtonHover(static_cast<float>(event.mouseButton.x), static_cast<float>(event.mouseButton.y));
-                        if (restartHovered)
-                        {
-                            restartGame();
-                            setupRestartButtonVisuals(); 
-                        }
-                        else
-                        {
-                            handleSquareClick(event.mouseButton.x, event.mouseButton.y);
-                        }
-                    }
+                    startupMs = startupClock.getElapsedTime().asMicroseconds() / 1000.f;
+                    std::cout << "Startup: window " << windowShownMs << " ms, assets " << assetsMs << " ms from "
+                              << (assets.isOpen() ? "assets.pak" : "pieces_img") << ", first frame " << startupMs << " ms" << std::endl;
                 }
+                // slides and the eval bar ask for the next frame straight away
+                needsRedraw = animationRunning() || evalMoving();
+                backToBack = needsRedraw;
             }
-            draw();
         }
+        TRACE_DUMP("chess-trace.json");
     }
 };
 
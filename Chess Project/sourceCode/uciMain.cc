@@ -0,0 +1,21 @@
+#include "../header_files/Uci.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// headless engine: speaks UCI on stdin/stdout, or runs "chess-uci bench [depth]" and exits
+int main(int argc, char *argv[])
+{
+    std::ios::sync_with_stdio(false);
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        uciEngine::bench(argc > 2 ? std::max(1, std::atoi(argv[2])) : 6, std::cout);
+        return 0;
+    }
+
+    uciEngine engine(std::cin, std::cout);
+    engine.run();
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "../header_files/GameRules.h"
+#include "../header_files/Search.h"
+#include "../header_files/chessBoard.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// the rules the tools, the server and the engine share to end a game. prints every check
+// that fails and exits with 1, run by ctest
+static int failures = 0;
+
+static void check(bool passed, const std::string &what)
+{
+    if (!passed)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        failures++;
+    }
+}
+
+static adjudication adjudicateFEN(const std::string &fen)
+{
+    chessBoard board;
+    board.loadFEN(fen);
+    gameHistory history;
+    history.reset(board);
+    std::vector<chessMove> legal;
+    return history.adjudicate(board, legal);
+}
+
+static void testEndings()
+{
+    check(adjudicateFEN(startPosition) == adjudication::ONGOING, "the start position goes on");
+    check(adjudicateFEN("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1") == adjudication::STALEMATE, "stalemate");
+    check(adjudicateFEN("7k/6Q1/6K1/8/8/8/8/8 b - - 0 1") == adjudication::CHECKMATE, "checkmate");
+    check(adjudicateFEN("4k3/8/8/8/8/8/8/4K2R w - - 100 80") == adjudication::FIFTY_MOVES, "fifty moves");
+    check(adjudicateFEN("4k3/8/8/8/8/8/8/4KB2 w - - 0 1") == adjudication::MATERIAL, "insufficient material");
+
+    // knights out and back twice: the start position is on the board for the third time
+    chessBoard board;
+    board.loadFEN(startPosition);
+    gameHistory history;
+    history.reset(board);
+    std::vector<chessMove> legal;
+    const char *shuffle[] = {"g1f3", "g8f6", "f3g1", "f6g8", "g1f3", "g8f6", "f3g1", "f6g8"};
+    for (int ply = 0; ply < 8; ply++)
+    {
+        check(history.adjudicate(board, legal) == adjudication::ONGOING, std::string("no repetition before ") + shuffle[ply]);
+        chessMove move;
+        for (const chessMove &candidate : legal)
+        {
+            if (candidate.toString() == shuffle[ply])
+            {
+                move = candidate;
+            }
+        }
+        moveUndo undo;
+        board.makeMove(move, undo);
+        history.record(board);
+    }
+    check(history.adjudicate(board, legal) == adjudication::REPETITION, "threefold repetition");
+    check(history.positionKeys().size() == 9, "every position since the last pawn move is kept");
+}
+
+// the search scores for the side to move, a lost white shows up as -, +, -, + ...
+static void testResignation()
+{
+    resignationRule rule(2000, 6);
+    int result = 0;
+    for (int ply = 0; ply < 6; ply++)
+    {
+        Color side = ply % 2 == 0 ? Color::WHITE : Color::BLACK;
+        result = rule.record(side, side == Color::WHITE ? -2500 : 2500);
+        check(ply == 5 ? result == -1 : result == 0, "white resigns on the sixth ply, ply " + std::to_string(ply + 1));
+    }
+
+    // one search that sees it differently starts the count again
+    rule.reset();
+    int scores[] = {-2500, 2500, -2500, 2500, -100, 2500, -2500, 2500, -2500, 2500};
+    for (int ply = 0; ply < 10; ply++)
+    {
+        result = rule.record(ply % 2 == 0 ? Color::WHITE : Color::BLACK, scores[ply]);
+        check(result == 0, "no resignation after the streak broke, ply " + std::to_string(ply + 1));
+    }
+    result = rule.record(Color::WHITE, -2500);
+    check(result == -1, "white resigns once the new streak is long enough");
+}
+
+// white has a bare king against two rooks, a queen and eight pawns. the game loop of
+// dataGen and tournament ends it by resignation before it is played out
+static void testLostGame()
+{
+    chessBoard board;
+    board.loadFEN("rq2k2r/pppppppp/8/8/8/8/8/4K3 w kq - 0 1");
+    chessSearch search(1);
+    searchLimits limits;
+    limits.maxNodes = 3000;
+    gameHistory history;
+    history.reset(board);
+    resignationRule resignation(2000, 6);
+    std::vector<chessMove> legal;
+    int whiteResult = 0;
+    int plies = 0;
+    for (; plies < 200 && history.adjudicate(board, legal) == adjudication::ONGOING; plies++)
+    {
+        searchResult result = search.think(board, limits, history.positionKeys());
+        whiteResult = resignation.record(board.getPlayerTurn(), result.score);
+        if (whiteResult != 0)
+        {
+            break;
+        }
+        moveUndo undo;
+        board.makeMove(result.bestMove.isNull() ? legal[0] : result.bestMove, undo);
+        history.record(board);
+    }
+    check(whiteResult == -1, "the lost game ends with white resigning");
+    check(plies + 1 == 6, "after six plies, not " + std::to_string(plies + 1));
+}
+
+int main()
+{
+    testEndings();
+    testResignation();
+    testLostGame();
+    if (failures == 0)
+    {
+        std::cout << "All game rule checks passed\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
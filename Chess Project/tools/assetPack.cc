@@ -0,0 +1,64 @@
+#include "../header_files/AssetPack.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// packs the GUI's assets into one file that the game maps at startup
+// usage: assetPack [-o assets.pak] [file ...]
+// with no files it packs what the game loads from pieces_img
+int main(int argc, char *argv[])
+{
+    std::string output = "assets.pak";
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else
+        {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty())
+    {
+        const char *names[] = {"W_king.png", "W_queen.png", "W_rook.png", "W_bishop.png", "W_knight.png", "W_pawn.png",
+                               "B_king.png", "B_queen.png", "B_rook.png", "B_bishop.png", "B_knight.png", "B_pawn.png",
+                               "move.wav", "capture.wav", "check.wav", "checkmate.wav", "arial.ttf"};
+        for (const char *name : names)
+        {
+            files.push_back(std::string("pieces_img/") + name);
+        }
+    }
+
+    if (!assetPack::write(output, files))
+    {
+        return 1;
+    }
+
+    // read it back the way the game does
+    assetPack pack;
+    if (!pack.open(output))
+    {
+        return 1;
+    }
+    size_t total = 0;
+    for (const std::string &file : files)
+    {
+        std::string name = file.substr(file.find_last_of("/\\") + 1);
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+        if (!pack.find(name, data, size))
+        {
+            std::cerr << "Missing from the pack: " << name << std::endl;
+            return 1;
+        }
+        total += size;
+    }
+    std::cout << "Packed " << pack.getEntryCount() << " files, " << total / 1024 << " KiB, into " << output << "\n";
+    return 0;
+}
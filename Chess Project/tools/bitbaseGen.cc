@@ -0,0 +1,101 @@
+#include "../header_files/Bitbase.h"
+#include "../header_files/chessBoard.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// generates endgame bitbases, writes them to disk and benchmarks generation and probing
+// usage: bitbaseGen [-o directory] [-t threads] [material ...]
+int main(int argc, char *argv[])
+{
+    std::string directory = "bitbases";
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> materials;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+        {
+            directory = argv[++i];
+        }
+        else if (arg == "-t" && i + 1 < argc)
+        {
+            threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        }
+        else
+        {
+            materials.push_back(arg);
+        }
+    }
+    if (materials.empty())
+    {
+        materials = {"KPK", "KRK", "KQK", "KBNK"};
+    }
+
+    bitbaseRegistry &registry = bitbaseRegistry::instance();
+    std::cout << "Generating with " << threads << " thread(s)\n";
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string &material : materials)
+    {
+        if (!registry.generate(material, threads))
+        {
+            return 1;
+        }
+    }
+    double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // smaller tables reached by captures and promotions are generated too
+    for (const std::string &name : registry.loadedMaterials())
+    {
+        const endgameBitbase *table = registry.find(name);
+        uint64_t wins, draws, losses;
+        table->countResults(wins, draws, losses);
+        double seconds = table->getGenerationSeconds();
+        std::cout << name << ": " << table->getEntryCount() << " entries, "
+                  << wins << " won, " << draws << " drawn, " << losses << " lost, "
+                  << seconds << " s (" << static_cast<uint64_t>(table->getEntryCount() / std::max(seconds, 1e-9)) << " entries/s)\n";
+    }
+    std::cout << "Total generation time: " << totalSeconds << " s\n";
+
+    std::filesystem::create_directories(directory);
+    if (!registry.saveAll(directory))
+    {
+        return 1;
+    }
+    std::cout << "Saved to " << directory << "\n";
+
+    // probe random legal-looking positions through the memory mapped files
+    for (const std::string &material : materials)
+    {
+        std::string name = bitbaseRegistry::normalizeMaterial(material);
+        endgameBitbase mapped(name);
+        if (!mapped.load((std::filesystem::path(directory) / (name + ".cbb")).string()))
+        {
+            return 1;
+        }
+
+        std::mt19937_64 rng(2024);
+        const int probes = 2000000;
+        uint64_t found = 0;
+        endgamePosition pos;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < probes; i++)
+        {
+            mapped.positionAt(rng() % mapped.getEntryCount(), pos);
+            if (mapped.probeCanonical(pos) != wdlResult::UNKNOWN)
+            {
+                found++;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << name << " probe: " << static_cast<uint64_t>(probes / seconds) << " probes/s (" << found << " legal)\n";
+    }
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include "../header_files/PositionCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// payload every writer stores for a key, so readers can tell a torn entry from a good one
+static uint64_t expectedPayload(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    return key & positionCache::payloadMask;
+}
+
+static uint64_t nextRandom(uint64_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+struct benchCounters
+{
+    uint64_t operations = 0;
+    uint64_t hits = 0;
+    uint64_t corrupted = 0;
+};
+
+// every thread draws keys from the same key space so threads keep hitting the same buckets
+static benchCounters runWorker(positionCache &cache, int seed, uint64_t operations, int writePercent, uint64_t keySpace, bool usePrefetch)
+{
+    benchCounters counters;
+    uint64_t state = 0x9E3779B97F4A7C15ULL * (seed + 1);
+    uint64_t nextKey = (nextRandom(state) % keySpace) * 0xD6E8FEB86659FD93ULL | 1;
+
+    for (uint64_t i = 0; i < operations; i++)
+    {
+        uint64_t key = nextKey;
+        nextKey = (nextRandom(state) % keySpace) * 0xD6E8FEB86659FD93ULL | 1;
+        if (usePrefetch)
+        {
+            cache.prefetch(nextKey);
+        }
+
+        if (static_cast<int>(nextRandom(state) % 100) < writePercent)
+        {
+            cache.store(key, expectedPayload(key), static_cast<int>(key & 31));
+        }
+        else
+        {
+            uint64_t payload;
+            int priority;
+            if (cache.probe(key, payload, priority))
+            {
+                counters.hits++;
+                if (payload != expectedPayload(key))
+                {
+                    counters.corrupted++;
+                }
+            }
+        }
+    }
+    counters.operations = operations;
+    return counters;
+}
+
+// probe/store throughput of positionCache with many threads on one table
+// usage: cacheBench [-m megabytes] [-t 1,2,4,8,16] [-n operations per thread] [-w write percent] [--huge]
+int main(int argc, char *argv[])
+{
+    size_t megabytes = 256;
+    std::vector<int> threadCounts = {1, 2, 4, 8, 16};
+    uint64_t operations = 4000000;
+    int writePercent = 30;
+    bool useHugePages = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-m" && i + 1 < argc)
+        {
+            megabytes = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "-n" && i + 1 < argc)
+        {
+            operations = static_cast<uint64_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "-w" && i + 1 < argc)
+        {
+            writePercent = std::min(100, std::max(0, std::atoi(argv[++i])));
+        }
+        else if (arg == "-t" && i + 1 < argc)
+        {
+            threadCounts.clear();
+            std::stringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ','))
+            {
+                threadCounts.push_back(std::max(1, std::atoi(item.c_str())));
+            }
+        }
+        else if (arg == "--huge")
+        {
+            useHugePages = true;
+        }
+        else
+        {
+            std::cerr << "usage: cacheBench [-m megabytes] [-t 1,2,4,8,16] [-n operations] [-w write percent] [--huge]" << std::endl;
+            return 1;
+        }
+    }
+
+    positionCache cache(megabytes, useHugePages);
+    if (!cache.sizeInBytes())
+    {
+        std::cerr << "Could not allocate " << megabytes << " MB" << std::endl;
+        return 1;
+    }
+    // as many keys as entries, uneven bucket filling keeps the replacement busy
+    uint64_t keySpace = cache.bucketCount() * positionCache::entriesPerBucket;
+
+    std::cout << cache.sizeInBytes() / (1024 * 1024) << " MB, " << cache.bucketCount() << " buckets, huge pages "
+              << (cache.usesHugePages() ? "on" : "off") << ", " << writePercent << "% stores, "
+              << std::thread::hardware_concurrency() << " hardware threads\n";
+    std::cout << std::left << std::setw(9) << "threads" << std::setw(10) << "prefetch" << std::setw(12) << "Mops/s"
+              << std::setw(16) << "Mops/s/thread" << std::setw(10) << "hit %" << "corrupted\n";
+
+    for (int threadCount : threadCounts)
+    {
+        for (bool usePrefetch : {false, true})
+        {
+            cache.clear();
+            std::vector<benchCounters> results(threadCount);
+            std::vector<std::thread> workers;
+            auto start = std::chrono::steady_clock::now();
+            for (int t = 0; t < threadCount; t++)
+            {
+                workers.emplace_back([&, t]()
+                                     { results[t] = runWorker(cache, t, operations, writePercent, keySpace, usePrefetch); });
+            }
+            for (std::thread &worker : workers)
+            {
+                worker.join();
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            benchCounters total;
+            uint64_t probes = 0;
+            for (const benchCounters &counters : results)
+            {
+                total.operations += counters.operations;
+                total.hits += counters.hits;
+                total.corrupted += counters.corrupted;
+            }
+            probes = total.operations - total.operations * writePercent / 100;
+            double rate = total.operations / std::max(seconds, 1e-9) / 1e6;
+            std::cout << std::setw(9) << threadCount << std::setw(10) << (usePrefetch ? "yes" : "no")
+                      << std::setw(12) << std::fixed << std::setprecision(2) << rate
+                      << std::setw(16) << rate / threadCount
+                      << std::setw(10) << std::setprecision(1) << (probes ? 100.0 * total.hits / probes : 0.0)
+                      << total.corrupted << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include "../header_files/GameRules.h"
+#include "../header_files/Nnue.h"
+#include "../header_files/Search.h"
+#include "../header_files/TrainingData.h"
+#include "../header_files/chessBoard.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// a side this far behind for resignPlies plies in a row has lost, no need to play it out
+static const int resignScore = 2000;
+static const int resignPlies = 6;
+static const int maxGamePlies = 400;
+
+struct generatorSettings
+{
+    searchLimits limits;
+    size_t hashMegabytes = 16;
+    int randomPlies = 8;
+    uint64_t targetSamples = 1000000;
+    uint64_t seed = 1;
+    const nnueNetwork *network = nullptr;
+};
+
+// plays one self-play game and appends its quiet positions, labelled with the search score and
+// the final result, to samples. returns the result from white's point of view
+static int playGame(chessSearch &search, const generatorSettings &settings, uint64_t &random, std::vector<packedSample> &samples)
+{
+    chessBoard board;
+    do
+    {
+        board.loadFEN(startPosition);
+    } while (!playRandomOpening(board, settings.randomPlies, random));
+    board.attachNetwork(settings.network);
+    search.clear();
+
+    size_t firstSample = samples.size();
+    gameHistory history;
+    history.reset(board);
+    std::vector<chessMove> legal;
+    int whiteResult = 0;
+    resignationRule resignation(resignScore, resignPlies);
+
+    for (int ply = 0; ply < maxGamePlies; ply++)
+    {
+        adjudication ending = history.adjudicate(board, legal);
+        bool whiteToMove = board.getPlayerTurn() == Color::WHITE;
+        if (ending != adjudication::ONGOING)
+        {
+            if (ending == adjudication::CHECKMATE)
+            {
+                whiteResult = whiteToMove ? -1 : 1;
+            }
+            break;
+        }
+
+        searchResult result = search.think(board, settings.limits, history.positionKeys());
+        chessMove move = result.bestMove.isNull() ? legal[0] : result.bestMove;
+
+        // the score of a quiet position is what the evaluator has to learn, positions in check
+        // or where the best move wins material would only teach it to guess tactics
+        bool quiet = !board.isKingInCheck(board.getPlayerTurn()) && !board.isCapture(move) && !move.isPromotion() &&
+                     std::abs(result.score) < mateBound;
+        packedSample sample;
+        if (quiet && packSample(board, result.score, move, sample))
+        {
+            samples.push_back(sample);
+        }
+
+        whiteResult = resignation.record(board.getPlayerTurn(), result.score);
+        if (whiteResult != 0)
+        {
+            break;
+        }
+
+        moveUndo undo;
+        board.makeMove(move, undo);
+        history.record(board);
+    }
+
+    for (size_t i = firstSample; i < samples.size(); i++)
+    {
+        samples[i].result = static_cast<int8_t>(samples[i].flags & 1 ? -whiteResult : whiteResult);
+    }
+    return whiteResult;
+}
+
+static int dumpSamples(const std::string &path, uint64_t limit)
+{
+    sampleReader reader;
+    if (!reader.open(path))
+    {
+        return 1;
+    }
+    std::vector<packedSample> block;
+    uint64_t shown = 0;
+    while (shown < limit && reader.readBlock(block))
+    {
+        for (size_t i = 0; i < block.size() && shown < limit; i++, shown++)
+        {
+            chessMove move;
+            move.data = block[i].move;
+            std::cout << sampleToFEN(block[i]) << " | " << block[i].score << " | " << static_cast<int>(block[i].result)
+                      << " | " << move.toString() << "\n";
+        }
+    }
+    return 0;
+}
+
+static void usage()
+{
+    std::cerr << "usage: dataGen -o file [-samples N] [-threads N] [-nodes N | -depth D] [-hash MB]\n"
+                 "               [-random-plies N] [-nnue file] [-seed N] [-compress]\n"
+                 "       dataGen -dump file [count]"
+              << std::endl;
+}
+
+// self-play training data: every thread plays its own games with a fixed node or depth limit
+// and hands finished games to the writer, which packs 32 byte samples into blocks on disk
+// without stopping the searches. prints samples per hour every few seconds
+int main(int argc, char *argv[])
+{
+    generatorSettings settings;
+    settings.limits.maxNodes = 5000;
+    std::string outputPath, networkPath;
+    int threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    bool compress = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-dump" && hasValue)
+        {
+            std::string path = argv[++i];
+            return dumpSamples(path, i + 1 < argc ? std::strtoull(argv[i + 1], nullptr, 10) : UINT64_MAX);
+        }
+        else if (arg == "-o" && hasValue)
+        {
+            outputPath = argv[++i];
+        }
+        else if (arg == "-samples" && hasValue)
+        {
+            settings.targetSamples = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-threads" && hasValue)
+        {
+            threadCount = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-nodes" && hasValue)
+        {
+            settings.limits.maxNodes = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-depth" && hasValue)
+        {
+            settings.limits.maxDepth = std::max(1, std::atoi(argv[++i]));
+            settings.limits.maxNodes = 0;
+        }
+        else if (arg == "-hash" && hasValue)
+        {
+            settings.hashMegabytes = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "-random-plies" && hasValue)
+        {
+            settings.randomPlies = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "-nnue" && hasValue)
+        {
+            networkPath = argv[++i];
+        }
+        else if (arg == "-seed" && hasValue)
+        {
+            settings.seed = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg == "-compress")
+        {
+            compress = true;
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if (outputPath.empty())
+    {
+        usage();
+        return 1;
+    }
+
+    nnueNetwork network;
+    if (!networkPath.empty())
+    {
+        if (!network.load(networkPath))
+        {
+            std::cerr << "Could not load network " << networkPath << std::endl;
+            return 1;
+        }
+        settings.network = &network;
+    }
+
+    sampleWriter writer;
+    if (!writer.open(outputPath, compress))
+    {
+        return 1;
+    }
+
+    std::atomic<uint64_t> produced{0};
+    std::atomic<uint64_t> gamesPlayed{0};
+    std::atomic<int> running{threadCount};
+    auto worker = [&](int index)
+    {
+        chessSearch search(settings.hashMegabytes, 1);
+        uint64_t random = settings.seed * 0x9E3779B97F4A7C15ULL + static_cast<uint64_t>(index) * 0xD1B54A32D192ED03ULL;
+        if (random == 0)
+        {
+            random = 1;
+        }
+        std::vector<packedSample> samples;
+        while (produced.load(std::memory_order_relaxed) < settings.targetSamples)
+        {
+            samples.clear();
+            playGame(search, settings, random, samples);
+            produced.fetch_add(samples.size(), std::memory_order_relaxed);
+            gamesPlayed.fetch_add(1, std::memory_order_relaxed);
+            writer.write(samples.data(), samples.size());
+        }
+        running.fetch_sub(1);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; i++)
+    {
+        threads.emplace_back(worker, i);
+    }
+
+    auto report = [&]()
+    {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t samples = produced.load();
+        std::cout << samples << " samples, " << gamesPlayed.load() << " games, " << std::fixed << std::setprecision(0)
+                  << (seconds > 0.0 ? samples * 3600.0 / seconds : 0.0) << " samples/hour" << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    };
+    auto lastReport = start;
+    while (running.load() > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (std::chrono::steady_clock::now() - lastReport >= std::chrono::seconds(10))
+        {
+            lastReport = std::chrono::steady_clock::now();
+            report();
+        }
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    bool ok = writer.close();
+    report();
+    uint64_t written = writer.samplesWritten();
+    std::cout << "Wrote " << written << " samples, " << writer.bytesWritten() << " bytes ("
+              << std::setprecision(3) << (written ? static_cast<double>(writer.bytesWritten()) / written : 0.0)
+              << " bytes/sample) to " << outputPath << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,400 @@
+#include "../header_files/BoardArt.h"
+#include "../header_files/chessBoard.h"
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// renders board diagrams to PNG files without opening a window, one per FEN line (EPD
+// works too, only the position is read) or one per game of a .pgn file, its final position.
+// usage: diagramRender [-o directory] [-size pixels] [-render threads] [-encode threads]
+//                      [-pieces directory] file ...
+//
+// every render thread has its own offscreen target, and with it its own GL context, and
+// its own copy of the atlas. finished boards are read back and queued for the encode
+// threads, so PNG compression overlaps the rendering. on a Linux box without a GPU run it
+// under Xvfb (xvfb-run -a diagramRender ...) and Mesa renders in software
+
+// read back boards waiting for an encode thread. bounded so that renderers can't run
+// ahead of the encoders by more than a few images
+class imageQueue
+{
+private:
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<std::pair<size_t, std::unique_ptr<sf::Image>>> images;
+    size_t capacity;
+    bool closed = false;
+
+public:
+    explicit imageQueue(size_t maxImages) : capacity(maxImages) {}
+
+    void push(size_t index, std::unique_ptr<sf::Image> image)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]()
+                     { return images.size() < capacity; });
+        images.emplace_back(index, std::move(image));
+        notEmpty.notify_one();
+    }
+
+    // false once the queue is closed and empty
+    bool pop(size_t &index, std::unique_ptr<sf::Image> &image)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]()
+                      { return !images.empty() || closed; });
+        if (images.empty())
+        {
+            return false;
+        }
+        index = images.front().first;
+        image = std::move(images.front().second);
+        images.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+};
+
+static void readFenLines(std::istream &in, std::vector<std::string> &fens)
+{
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (line.find_first_not_of(" \t") != std::string::npos && line[0] != '#')
+        {
+            fens.push_back(line);
+        }
+    }
+}
+
+// the final position of every game, from its [FEN] tag or the initial position. comments,
+// variations, move numbers and NAGs are skipped. a game with a move that isn't legal is
+// reported and left out
+static void readPgnGames(std::istream &in, std::vector<std::string> &fens)
+{
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    chessBoard board;
+    bool inGame = false, broken = false;
+    size_t gameNumber = 0;
+    std::string startFen;
+    auto finishGame = [&]()
+    {
+        if (inGame && !broken)
+        {
+            fens.push_back(board.toFEN());
+        }
+        inGame = false;
+        broken = false;
+        startFen.clear();
+    };
+    auto startGame = [&]()
+    {
+        gameNumber++;
+        inGame = true;
+        if (startFen.empty() || !board.loadFEN(startFen))
+        {
+            board = chessBoard();
+        }
+    };
+
+    size_t at = 0;
+    while (at < text.size())
+    {
+        char c = text[at];
+        if (std::isspace(static_cast<unsigned char>(c)))
+        {
+            at++;
+        }
+        else if (c == '[')
+        {
+            // a tag after moves starts the next game
+            if (inGame)
+            {
+                finishGame();
+            }
+            size_t end = text.find(']', at);
+            std::string tag = text.substr(at + 1, end == std::string::npos ? std::string::npos : end - at - 1);
+            size_t quote = tag.find('"');
+            if (tag.compare(0, 4, "FEN ") == 0 && quote != std::string::npos)
+            {
+                startFen = tag.substr(quote + 1, tag.rfind('"') - quote - 1);
+            }
+            at = end == std::string::npos ? text.size() : end + 1;
+        }
+        else if (c == '{' || c == ';')
+        {
+            size_t end = text.find(c == '{' ? '}' : '\n', at);
+            at = end == std::string::npos ? text.size() : end + 1;
+        }
+        else if (c == '(')
+        {
+            int depth = 0;
+            for (; at < text.size(); at++)
+            {
+                depth += text[at] == '(' ? 1 : text[at] == ')' ? -1 : 0;
+                if (depth == 0)
+                {
+                    break;
+                }
+            }
+            at++;
+        }
+        else
+        {
+            size_t end = at;
+            while (end < text.size() && !std::isspace(static_cast<unsigned char>(text[end])) && text[end] != '{' &&
+                   text[end] != '(' && text[end] != ';')
+            {
+                end++;
+            }
+            std::string token = text.substr(at, end - at);
+            at = end;
+            if (!inGame)
+            {
+                startGame();
+            }
+            if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*")
+            {
+                finishGame();
+                continue;
+            }
+            // "12." and "12...", or a move written straight after its number
+            size_t digits = 0;
+            while (digits < token.size() && std::isdigit(static_cast<unsigned char>(token[digits])))
+            {
+                digits++;
+            }
+            if (digits > 0 && digits < token.size() && token[digits] == '.')
+            {
+                size_t move = token.find_first_not_of('.', digits);
+                token = move == std::string::npos ? std::string() : token.substr(move);
+            }
+            if (token.empty() || token[0] == '$' || digits == token.size() || broken)
+            {
+                continue;
+            }
+            chessMove move;
+            if (!board.fromSAN(token, move))
+            {
+                std::cerr << "Game " << gameNumber << ": illegal or unreadable move " << token << ", skipped" << std::endl;
+                broken = true;
+                continue;
+            }
+            moveUndo undo;
+            board.makeMove(move, undo);
+        }
+    }
+    finishGame();
+}
+
+int main(int argc, char *argv[])
+{
+    std::string directory = "diagrams";
+    std::string pieceDirectory = "pieces_img";
+    unsigned squareSize = 48;
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    // PNG compression costs more than drawing a board, most threads encode
+    unsigned renderThreads = std::max(1u, hardware / 4);
+    unsigned encodeThreads = std::max(1u, hardware - renderThreads);
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-o" && hasValue)
+        {
+            directory = argv[++i];
+        }
+        else if (arg == "-size" && hasValue)
+        {
+            squareSize = static_cast<unsigned>(std::max(8, std::atoi(argv[++i])));
+        }
+        else if (arg == "-render" && hasValue)
+        {
+            renderThreads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "-encode" && hasValue)
+        {
+            encodeThreads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "-pieces" && hasValue)
+        {
+            pieceDirectory = argv[++i];
+        }
+        else
+        {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty())
+    {
+        std::cerr << "usage: diagramRender [-o directory] [-size pixels] [-render threads] [-encode threads]\n"
+                     "                     [-pieces directory] file ..." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> fens;
+    for (const std::string &input : inputs)
+    {
+        std::ifstream in(input, std::ios::binary);
+        if (!in)
+        {
+            std::cerr << "Could not read " << input << std::endl;
+            return 1;
+        }
+        if (std::filesystem::path(input).extension() == ".pgn")
+        {
+            readPgnGames(in, fens);
+        }
+        else
+        {
+            readFenLines(in, fens);
+        }
+    }
+    if (fens.empty())
+    {
+        std::cerr << "No positions to render" << std::endl;
+        return 1;
+    }
+
+    // the atlas is composed once, every render thread uploads its own texture from it
+    const std::string pieceNames[12] = {"W_king", "W_queen", "W_rook", "W_bishop", "W_knight", "W_pawn",
+                                        "B_king", "B_queen", "B_rook", "B_bishop", "B_knight", "B_pawn"};
+    sf::Image images[12];
+    for (int i = 0; i < 12; i++)
+    {
+        std::string path = pieceDirectory + "/" + pieceNames[i] + ".png";
+        if (!images[i].loadFromFile(path))
+        {
+            std::cerr << "Error loading texture: " << path << std::endl;
+            return 1;
+        }
+    }
+    boardArt art;
+    art.compose(images);
+
+    std::filesystem::create_directories(directory);
+    int digits = std::max(5, static_cast<int>(std::to_string(fens.size()).size()));
+
+    imageQueue queue(4 * encodeThreads);
+    std::atomic<size_t> nextPosition{0};
+    std::atomic<size_t> written{0};
+    std::atomic<size_t> failures{0};
+    std::atomic<int64_t> renderMicroseconds{0};
+    std::atomic<int64_t> encodeMicroseconds{0};
+    auto start = std::chrono::steady_clock::now();
+
+    auto render = [&]()
+    {
+        sf::RenderTexture target;
+        boardArt threadArt = art;
+        if (!target.create(8 * squareSize, 8 * squareSize) || !target.setActive(true) || !threadArt.upload())
+        {
+            std::cerr << "Could not create an offscreen target" << std::endl;
+            failures++;
+            return;
+        }
+        sf::VertexArray vertices(sf::Triangles, 128 * 6);
+        chessBoard board;
+        for (size_t i = nextPosition++; i < fens.size(); i = nextPosition++)
+        {
+            auto renderStart = std::chrono::steady_clock::now();
+            if (!board.loadFEN(fens[i]))
+            {
+                std::cerr << "Invalid FEN: " << fens[i] << std::endl;
+                failures++;
+                continue;
+            }
+            threadArt.writePosition(&vertices[0], board, 0.f, 0.f, static_cast<float>(squareSize));
+            target.clear();
+            target.draw(vertices, sf::RenderStates(&threadArt.atlas));
+            target.display();
+            // constructed in place, sf::Image has no move constructor
+            std::unique_ptr<sf::Image> image(new sf::Image(target.getTexture().copyToImage()));
+            renderMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - renderStart).count();
+            queue.push(i, std::move(image));
+        }
+    };
+
+    auto encode = [&]()
+    {
+        size_t index;
+        std::unique_ptr<sf::Image> image;
+        while (queue.pop(index, image))
+        {
+            auto encodeStart = std::chrono::steady_clock::now();
+            char name[32];
+            std::snprintf(name, sizeof(name), "diagram-%0*llu.png", digits, static_cast<unsigned long long>(index + 1));
+            if (image->saveToFile((std::filesystem::path(directory) / name).string()))
+            {
+                written++;
+            }
+            else
+            {
+                failures++;
+            }
+            encodeMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - encodeStart).count();
+        }
+    };
+
+    std::vector<std::thread> renderers, encoders;
+    for (unsigned i = 0; i < encodeThreads; i++)
+    {
+        encoders.emplace_back(encode);
+    }
+    for (unsigned i = 0; i < renderThreads; i++)
+    {
+        renderers.emplace_back(render);
+    }
+    for (std::thread &thread : renderers)
+    {
+        thread.join();
+    }
+    queue.close();
+    for (std::thread &thread : encoders)
+    {
+        thread.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t count = written.load();
+    std::printf("Rendered %llu of %llu diagrams to %s in %.2f s, %.0f diagrams/s with %u render and %u encode threads\n",
+                static_cast<unsigned long long>(count), static_cast<unsigned long long>(fens.size()), directory.c_str(), seconds,
+                count / std::max(seconds, 1e-9), renderThreads, encodeThreads);
+    if (count > 0)
+    {
+        std::printf("Per diagram: render and read back %.2f ms, encode %.2f ms (thread time)\n",
+                    renderMicroseconds.load() / 1000.0 / count, encodeMicroseconds.load() / 1000.0 / count);
+    }
+    return failures.load() == 0 ? 0 : 1;
+}
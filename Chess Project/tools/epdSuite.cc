@@ -0,0 +1,361 @@
+#include "../header_files/Search.h"
+#include "../header_files/chessBoard.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct epdPosition
+{
+    std::string id;
+    std::string fen;
+    std::vector<std::string> bestMoves;
+    std::vector<std::string> avoidMoves;
+};
+
+struct epdOutcome
+{
+    std::string found;
+    bool solved = false;
+    double timeToSolution = 0.0; // seconds until the search settled on a right move for good
+    uint64_t nodesToSolution = 0;
+    int depthToSolution = 0;
+    int depth = 0;
+    int score = 0;
+    uint64_t nodes = 0;
+    double seconds = 0.0;
+};
+
+// SAN as written in test suites, without check marks, annotations or zeros for castling
+static std::string normalizeSAN(std::string san)
+{
+    std::replace(san.begin(), san.end(), '0', 'O');
+    san.erase(std::remove_if(san.begin(), san.end(), [](char c)
+                             { return c == '+' || c == '#' || c == '!' || c == '?'; }),
+              san.end());
+    return san;
+}
+
+// "<4 FEN fields> bm Nf3 Qd5; am Qxb7; id \"name\";"
+static bool parseEpd(const std::string &line, epdPosition &position)
+{
+    std::istringstream fields(line);
+    std::string field;
+    for (int i = 0; i < 4 && fields >> field; i++)
+    {
+        position.fen += (i ? " " : "") + field;
+    }
+    if (std::count(position.fen.begin(), position.fen.end(), ' ') != 3)
+    {
+        return false;
+    }
+    position.fen += " 0 1";
+
+    std::string rest;
+    std::getline(fields, rest);
+    std::istringstream opcodes(rest);
+    std::string opcode;
+    while (std::getline(opcodes, opcode, ';'))
+    {
+        std::istringstream operands(opcode);
+        std::string name, operand;
+        if (!(operands >> name))
+        {
+            continue;
+        }
+        if (name == "id")
+        {
+            std::getline(operands >> std::ws, position.id);
+            position.id.erase(std::remove(position.id.begin(), position.id.end(), '"'), position.id.end());
+            continue;
+        }
+        while (operands >> operand)
+        {
+            if (name == "bm")
+            {
+                position.bestMoves.push_back(normalizeSAN(operand));
+            }
+            else if (name == "am")
+            {
+                position.avoidMoves.push_back(normalizeSAN(operand));
+            }
+        }
+    }
+    return !position.bestMoves.empty() || !position.avoidMoves.empty();
+}
+
+static bool isRightMove(const epdPosition &position, const std::string &san)
+{
+    std::string move = normalizeSAN(san);
+    if (!position.bestMoves.empty() &&
+        std::find(position.bestMoves.begin(), position.bestMoves.end(), move) == position.bestMoves.end())
+    {
+        return false;
+    }
+    return std::find(position.avoidMoves.begin(), position.avoidMoves.end(), move) == position.avoidMoves.end();
+}
+
+static std::string jsonString(const std::string &text)
+{
+    std::string escaped = "\"";
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        }
+        else
+        {
+            escaped += c;
+        }
+    }
+    return escaped + "\"";
+}
+
+static std::string jsonList(const std::vector<std::string> &items)
+{
+    std::string list = "[";
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        list += (i ? ", " : "") + jsonString(items[i]);
+    }
+    return list + "]";
+}
+
+// searches one position, following every finished iteration to see when the right move was found
+static epdOutcome solvePosition(chessSearch &search, const epdPosition &position, const searchLimits &limits)
+{
+    epdOutcome outcome;
+    chessBoard board;
+    board.loadFEN(position.fen);
+    chessBoard scratch;
+    scratch.loadFEN(position.fen);
+
+    bool settled = false;
+    search.setIterationCallback([&](const searchResult &result)
+                                {
+        bool right = !result.bestMove.isNull() && isRightMove(position, scratch.toSAN(result.bestMove));
+        if (right && !settled)
+        {
+            settled = true;
+            outcome.timeToSolution = result.seconds;
+            outcome.nodesToSolution = result.nodes;
+            outcome.depthToSolution = result.depth;
+        }
+        settled = right; });
+    search.clear();
+    searchResult result = search.think(board, limits);
+    search.setIterationCallback(nullptr);
+
+    outcome.found = result.bestMove.isNull() ? "" : scratch.toSAN(result.bestMove);
+    outcome.solved = !outcome.found.empty() && isRightMove(position, outcome.found);
+    outcome.depth = result.depth;
+    outcome.score = result.score;
+    outcome.nodes = result.nodes;
+    outcome.seconds = result.seconds;
+    if (outcome.solved && !settled)
+    {
+        // solved by the last, interrupted iteration
+        outcome.timeToSolution = result.seconds;
+        outcome.nodesToSolution = result.nodes;
+        outcome.depthToSolution = result.depth;
+    }
+    return outcome;
+}
+
+static void usage()
+{
+    std::cerr << "usage: epdSuite [-movetime ms | -nodes N | -depth D] [-threads N] [-hash MB] [-o file.json] file.epd..."
+              << std::endl;
+}
+
+// runs EPD test suites: every position with a bm and/or am opcode is searched with its own
+// single threaded search from a pool of workers, then solved count, time to solution and
+// nodes per second are written as JSON so that two runs can be diffed
+int main(int argc, char *argv[])
+{
+    searchLimits limits;
+    limits.moveTimeMs = 1000;
+    int threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    size_t hashMegabytes = 16;
+    std::string outputPath;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-movetime" && hasValue)
+        {
+            limits.moveTimeMs = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-nodes" && hasValue)
+        {
+            limits.maxNodes = std::strtoull(argv[++i], nullptr, 10);
+            limits.moveTimeMs = 0;
+        }
+        else if (arg == "-depth" && hasValue)
+        {
+            limits.maxDepth = std::max(1, std::atoi(argv[++i]));
+            limits.moveTimeMs = 0;
+        }
+        else if (arg == "-threads" && hasValue)
+        {
+            threadCount = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-hash" && hasValue)
+        {
+            hashMegabytes = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "-o" && hasValue)
+        {
+            outputPath = argv[++i];
+        }
+        else if (!arg.empty() && arg[0] != '-')
+        {
+            files.push_back(arg);
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if (files.empty())
+    {
+        usage();
+        return 1;
+    }
+
+    std::vector<epdPosition> positions;
+    for (const std::string &file : files)
+    {
+        std::ifstream in(file);
+        if (!in)
+        {
+            std::cerr << "Could not open " << file << std::endl;
+            return 1;
+        }
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(in, line))
+        {
+            lineNumber++;
+            epdPosition position;
+            chessBoard board;
+            if (!parseEpd(line, position) || !board.loadFEN(position.fen))
+            {
+                continue;
+            }
+            if (position.id.empty())
+            {
+                position.id = file + ":" + std::to_string(lineNumber);
+            }
+            positions.push_back(position);
+        }
+    }
+    if (positions.empty())
+    {
+        std::cerr << "No positions with bm or am opcodes found" << std::endl;
+        return 1;
+    }
+
+    std::vector<epdOutcome> outcomes(positions.size());
+    std::atomic<size_t> next{0};
+    std::mutex progressMutex;
+    int finished = 0;
+    auto worker = [&]()
+    {
+        chessSearch search(hashMegabytes, 1);
+        for (size_t index = next.fetch_add(1); index < positions.size(); index = next.fetch_add(1))
+        {
+            outcomes[index] = solvePosition(search, positions[index], limits);
+            std::lock_guard<std::mutex> lock(progressMutex);
+            finished++;
+            std::cerr << "[" << finished << "/" << positions.size() << "] " << positions[index].id << ": "
+                      << (outcomes[index].solved ? "solved " : "failed ") << outcomes[index].found << std::endl;
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < std::min<int>(threadCount, static_cast<int>(positions.size())); i++)
+    {
+        threads.emplace_back(worker);
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    int solved = 0;
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0.0, solutionSeconds = 0.0;
+    for (const epdOutcome &outcome : outcomes)
+    {
+        totalNodes += outcome.nodes;
+        totalSeconds += outcome.seconds;
+        if (outcome.solved)
+        {
+            solved++;
+            solutionSeconds += outcome.timeToSolution;
+        }
+    }
+
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3);
+    json << "{\n  \"files\": " << jsonList(files) << ",\n";
+    json << "  \"limits\": {\"movetime\": " << limits.moveTimeMs << ", \"nodes\": " << limits.maxNodes
+         << ", \"depth\": " << limits.maxDepth << "},\n";
+    json << "  \"threads\": " << threadCount << ",\n  \"hash\": " << hashMegabytes << ",\n";
+    json << "  \"summary\": {\"positions\": " << positions.size() << ", \"solved\": " << solved
+         << ", \"solveRate\": " << static_cast<double>(solved) / positions.size()
+         << ", \"averageTimeToSolution\": " << (solved ? solutionSeconds / solved : 0.0) << ", \"nodes\": " << totalNodes
+         << ", \"seconds\": " << totalSeconds
+         << ", \"nodesPerSecond\": " << (totalSeconds > 0.0 ? static_cast<uint64_t>(totalNodes / totalSeconds) : 0) << "},\n";
+    json << "  \"positions\": [\n";
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        const epdPosition &position = positions[i];
+        const epdOutcome &outcome = outcomes[i];
+        json << "    {\"id\": " << jsonString(position.id) << ", \"fen\": " << jsonString(position.fen)
+             << ", \"bm\": " << jsonList(position.bestMoves) << ", \"am\": " << jsonList(position.avoidMoves)
+             << ", \"found\": " << jsonString(outcome.found) << ", \"solved\": " << (outcome.solved ? "true" : "false")
+             << ", \"timeToSolution\": " << (outcome.solved ? outcome.timeToSolution : 0.0)
+             << ", \"nodesToSolution\": " << (outcome.solved ? outcome.nodesToSolution : 0)
+             << ", \"depthToSolution\": " << (outcome.solved ? outcome.depthToSolution : 0) << ", \"depth\": " << outcome.depth
+             << ", \"score\": " << outcome.score << ", \"nodes\": " << outcome.nodes << ", \"seconds\": " << outcome.seconds
+             << "}" << (i + 1 < positions.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+
+    if (outputPath.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream out(outputPath);
+        if (!(out << json.str()))
+        {
+            std::cerr << "Could not write " << outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::cerr << solved << "/" << positions.size() << " solved" << std::endl;
+    return 0;
+}
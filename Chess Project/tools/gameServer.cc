@@ -0,0 +1,73 @@
+#include "../header_files/GameServer.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+static gameServer *runningServer = nullptr;
+
+static void handleSignal(int)
+{
+    if (runningServer)
+    {
+        runningServer->stop();
+    }
+}
+
+// headless game host for bots: any number of games over a Unix domain socket and/or a
+// loopback TCP port, see GameServer.h for the protocol. stops cleanly on SIGINT/SIGTERM
+// linux only: g++ -std=c++17 -O2 -I header_files tools/gameServer.cc sourceCode/*.cc ...
+// usage: gameServer [-socket path] [-port N] [-max-games N]
+int main(int argc, char *argv[])
+{
+    std::string socketPath;
+    int port = 0;
+    size_t maxGames = 100000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-socket" && i + 1 < argc)
+        {
+            socketPath = argv[++i];
+        }
+        else if (arg == "-port" && i + 1 < argc)
+        {
+            port = std::atoi(argv[++i]);
+        }
+        else if (arg == "-max-games" && i + 1 < argc)
+        {
+            maxGames = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else
+        {
+            std::cerr << "usage: gameServer [-socket path] [-port N] [-max-games N]" << std::endl;
+            return 1;
+        }
+    }
+    if (socketPath.empty() && port == 0)
+    {
+        socketPath = "chess.sock";
+    }
+
+    gameServer server(maxGames);
+    if (!socketPath.empty() && !server.listenUnix(socketPath))
+    {
+        return 1;
+    }
+    if (port > 0 && (port > 65535 || !server.listenTcp(static_cast<uint16_t>(port))))
+    {
+        return 1;
+    }
+
+    runningServer = &server;
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    std::cout << "Serving games on" << (socketPath.empty() ? "" : " " + socketPath)
+              << (port > 0 ? " 127.0.0.1:" + std::to_string(port) : "") << std::endl;
+    server.run();
+    runningServer = nullptr;
+    std::cout << "Stopped with " << server.gameCount() << " games open" << std::endl;
+    return 0;
+}
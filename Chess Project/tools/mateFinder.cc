@@ -0,0 +1,175 @@
+#include "../header_files/MateSolver.h"
+#include "../header_files/chessBoard.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const char *statusName(mateStatus status)
+{
+    switch (status)
+    {
+    case mateStatus::PROVEN:
+        return "mate";
+    case mateStatus::DISPROVEN:
+        return "no mate";
+    default:
+        return "unknown";
+    }
+}
+
+// splits an EPD/FEN puzzle line into the position and an optional "dm <n>" (direct mate) opcode
+static bool parsePuzzle(const std::string &line, std::string &fen, int &expected)
+{
+    expected = 0;
+    std::string text = line.substr(0, line.find('#'));
+    size_t opcode = text.find(" dm ");
+    if (opcode != std::string::npos)
+    {
+        expected = std::atoi(text.c_str() + opcode + 4);
+        text = text.substr(0, opcode);
+    }
+    text = text.substr(0, text.find(';'));
+    std::istringstream fields(text);
+    std::string field;
+    fen.clear();
+    while (fields >> field)
+    {
+        fen += (fen.empty() ? "" : " ") + field;
+    }
+    return !fen.empty();
+}
+
+// proves or refutes forced mates for every puzzle in the given files, one position per line
+// as FEN or EPD, an EPD "dm n" opcode is checked against the solver and bounds the search
+// usage: mateFinder [-m max moves] [-n max nodes] [-s seconds per puzzle] [-t threads] [-h hash MB] file...
+int main(int argc, char *argv[])
+{
+    mateLimits defaults;
+    defaults.maxMoves = 5;
+    int threadCount = 1;
+    size_t hashMegabytes = 64;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-m" && i + 1 < argc)
+        {
+            defaults.maxMoves = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-n" && i + 1 < argc)
+        {
+            defaults.maxNodes = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-s" && i + 1 < argc)
+        {
+            defaults.timeMs = static_cast<int>(std::atof(argv[++i]) * 1000.0);
+        }
+        else if (arg == "-t" && i + 1 < argc)
+        {
+            threadCount = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-h" && i + 1 < argc)
+        {
+            hashMegabytes = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (!arg.empty() && arg[0] != '-')
+        {
+            files.push_back(arg);
+        }
+        else
+        {
+            std::cerr << "usage: mateFinder [-m max moves] [-n max nodes] [-s seconds per puzzle] [-t threads] [-h hash MB] file..." << std::endl;
+            return 1;
+        }
+    }
+    if (files.empty())
+    {
+        std::cerr << "usage: mateFinder [-m max moves] [-n max nodes] [-s seconds per puzzle] [-t threads] [-h hash MB] file..." << std::endl;
+        return 1;
+    }
+
+    mateSolver solver(hashMegabytes, threadCount);
+    int puzzles = 0, proven = 0, refuted = 0, unknown = 0, wrong = 0;
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0.0;
+
+    for (const std::string &file : files)
+    {
+        std::ifstream in(file);
+        if (!in)
+        {
+            std::cerr << "Could not open " << file << std::endl;
+            return 1;
+        }
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::string fen;
+            int expected = 0;
+            if (!parsePuzzle(line, fen, expected))
+            {
+                continue;
+            }
+            chessBoard board;
+            if (!board.loadFEN(fen))
+            {
+                std::cerr << "Invalid position: " << fen << std::endl;
+                continue;
+            }
+
+            mateLimits limits = defaults;
+            if (expected > 0)
+            {
+                limits.maxMoves = expected;
+            }
+            mateResult result = solver.solve(board, limits);
+            puzzles++;
+            totalNodes += result.nodes;
+            totalSeconds += result.seconds;
+
+            std::cout << std::setw(4) << puzzles << "  " << std::left << std::setw(8) << statusName(result.status) << std::right;
+            if (result.status == mateStatus::PROVEN)
+            {
+                proven++;
+                std::cout << " in " << result.mateIn << " ";
+                for (const chessMove &move : result.line)
+                {
+                    std::cout << " " << move.toString();
+                }
+            }
+            else if (result.status == mateStatus::DISPROVEN)
+            {
+                refuted++;
+                std::cout << " in " << limits.maxMoves << " or fewer";
+            }
+            else
+            {
+                unknown++;
+                std::cout << " (gave up at mate in " << result.mateIn << ")";
+            }
+            if (expected > 0 && (result.status != mateStatus::PROVEN || result.mateIn != expected) && result.status != mateStatus::UNKNOWN)
+            {
+                wrong++;
+                std::cout << "  expected mate in " << expected;
+            }
+            std::cout << "  [" << result.nodes << " nodes, " << std::fixed << std::setprecision(3) << result.seconds << " s]\n";
+            std::cout.unsetf(std::ios::fixed);
+        }
+    }
+
+    std::cout << "\n" << puzzles << " puzzles: " << proven << " mates, " << refuted << " refuted, " << unknown << " unknown";
+    if (wrong > 0)
+    {
+        std::cout << ", " << wrong << " disagree with their dm opcode";
+    }
+    std::cout << "\n" << totalNodes << " nodes in " << std::fixed << std::setprecision(2) << totalSeconds << " s ("
+              << (totalSeconds > 0.0 ? static_cast<uint64_t>(totalNodes / totalSeconds) : 0) << " nodes/s)\n";
+    return wrong > 0 ? 1 : 0;
+}
@@ -0,0 +1,205 @@
+#include "../header_files/Nnue.h"
+#include "../header_files/chessBoard.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const char *benchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// plays random legal moves and checks that the incrementally updated accumulators
+// still evaluate exactly like a board refreshed from scratch
+static bool verifyIncremental(const nnueNetwork &network, int plies)
+{
+    chessBoard board;
+    board.attachNetwork(&network);
+    unsigned seed = 12345;
+    std::vector<chessMove> moves;
+    for (int ply = 0; ply < plies; ply++)
+    {
+        board.generateLegalMoves(moves);
+        if (moves.empty() || board.halfmoveClock >= 100)
+        {
+            board.loadFEN(benchPositions[ply % 6]);
+            continue;
+        }
+        seed = seed * 1103515245 + 12345;
+        moveUndo undo;
+        board.makeMove(moves[(seed >> 8) % moves.size()], undo);
+
+        chessBoard fresh;
+        fresh.loadFEN(board.toFEN());
+        fresh.attachNetwork(&network);
+        if (fresh.evaluateNetwork() != board.evaluateNetwork())
+        {
+            std::cerr << "Incremental mismatch after " << ply + 1 << " plies at " << board.toFEN() << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// evals/sec for every kernel the CPU supports, over three workloads:
+// eval        output layer on an up to date accumulator
+// incremental makeMove + evaluate + unmakeMove for every legal move of the suite
+// refresh     rebuild the accumulators from all pieces, then evaluate
+// usage: nnueBench [-n network file] [-e evaluations] [--write-random file]
+int main(int argc, char *argv[])
+{
+    std::string networkPath;
+    std::string randomPath;
+    long evaluations = 2000000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc)
+        {
+            networkPath = argv[++i];
+        }
+        else if (arg == "-e" && i + 1 < argc)
+        {
+            evaluations = std::max(1000L, std::atol(argv[++i]));
+        }
+        else if (arg == "--write-random" && i + 1 < argc)
+        {
+            randomPath = argv[++i];
+        }
+        else
+        {
+            std::cerr << "usage: nnueBench [-n network file] [-e evaluations] [--write-random file]" << std::endl;
+            return 1;
+        }
+    }
+
+    nnueNetwork network;
+    if (!networkPath.empty())
+    {
+        if (!network.load(networkPath))
+        {
+            std::cerr << "Could not load " << networkPath << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        // speed does not depend on the weights, random ones of the right shape will do
+        network.randomize(1);
+        std::cout << "No network given, using random weights\n";
+    }
+    if (!randomPath.empty())
+    {
+        nnueNetwork random;
+        random.randomize(1);
+        if (!random.save(randomPath))
+        {
+            return 1;
+        }
+        std::cout << "Wrote random network to " << randomPath << "\n";
+    }
+
+    std::vector<std::unique_ptr<chessBoard>> boards;
+    std::vector<std::vector<chessMove>> boardMoves;
+    for (const char *fen : benchPositions)
+    {
+        boards.push_back(std::make_unique<chessBoard>());
+        boards.back()->loadFEN(fen);
+        boardMoves.emplace_back();
+        boards.back()->generateLegalMoves(boardMoves.back());
+        boards.back()->attachNetwork(&network);
+    }
+
+    std::cout << std::left << std::setw(10) << "kernel" << std::setw(16) << "eval/s" << std::setw(16) << "incremental/s"
+              << std::setw(16) << "refresh/s" << "checksum\n";
+
+    long long referenceChecksum = 0;
+    bool first = true;
+    bool ok = true;
+    for (nnueKernel kernel : {nnueKernel::SCALAR, nnueKernel::SSE41, nnueKernel::AVX2})
+    {
+        if (!network.selectKernel(kernel))
+        {
+            std::cout << std::setw(10) << nnueNetwork::kernelName(kernel) << "not supported by this CPU\n";
+            continue;
+        }
+
+        long long checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < evaluations; i++)
+        {
+            checksum += boards[i % boards.size()]->evaluateNetwork();
+        }
+        double evalRate = evaluations / secondsSince(start);
+
+        long incrementalCount = 0;
+        start = std::chrono::steady_clock::now();
+        while (incrementalCount < evaluations / 4)
+        {
+            for (size_t b = 0; b < boards.size(); b++)
+            {
+                for (const chessMove &move : boardMoves[b])
+                {
+                    moveUndo undo;
+                    boards[b]->makeMove(move, undo);
+                    checksum += boards[b]->evaluateNetwork();
+                    boards[b]->unmakeMove(move, undo);
+                    incrementalCount++;
+                }
+            }
+        }
+        double incrementalRate = incrementalCount / secondsSince(start);
+
+        long refreshCount = evaluations / 20;
+        start = std::chrono::steady_clock::now();
+        for (long i = 0; i < refreshCount; i++)
+        {
+            chessBoard &board = *boards[i % boards.size()];
+            board.attachNetwork(&network);
+            checksum += board.evaluateNetwork();
+        }
+        double refreshRate = refreshCount / secondsSince(start);
+
+        std::cout << std::fixed << std::setprecision(0) << std::setw(10) << nnueNetwork::kernelName(kernel)
+                  << std::setw(16) << evalRate << std::setw(16) << incrementalRate << std::setw(16) << refreshRate
+                  << checksum << "\n";
+
+        // every kernel is exact integer arithmetic, they must agree to the last bit
+        if (first)
+        {
+            referenceChecksum = checksum;
+            first = false;
+        }
+        else if (checksum != referenceChecksum)
+        {
+            std::cerr << nnueNetwork::kernelName(kernel) << " disagrees with the scalar kernel" << std::endl;
+            ok = false;
+        }
+    }
+
+    if (!verifyIncremental(network, 2000))
+    {
+        ok = false;
+    }
+    else
+    {
+        std::cout << "Incremental updates match full refreshes over 2000 random plies\n";
+    }
+    return ok ? 0 : 1;
+}
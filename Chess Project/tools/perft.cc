@@ -0,0 +1,96 @@
+#include "../header_files/GameRules.h"
+#include "../header_files/PositionCache.h"
+#include "../header_files/chessBoard.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// mixes the remaining depth into the key so one cache can hold counts for every depth
+static uint64_t perftKey(const chessBoard &board, int depth)
+{
+    return board.positionKey() ^ (uint64_t(depth) * 0x9E3779B97F4A7C15ULL);
+}
+
+static uint64_t perft(chessBoard &board, int depth, positionCache *cache)
+{
+    std::vector<chessMove> moves;
+    board.generateLegalMoves(moves);
+    if (depth == 1)
+    {
+        return moves.size();
+    }
+
+    uint64_t key = 0;
+    if (cache)
+    {
+        key = perftKey(board, depth);
+        uint64_t payload;
+        int priority;
+        if (cache->probe(key, payload, priority))
+        {
+            return payload;
+        }
+    }
+
+    uint64_t nodes = 0;
+    moveUndo undo;
+    for (const chessMove &move : moves)
+    {
+        board.makeMove(move, undo);
+        nodes += perft(board, depth - 1, cache);
+        board.unmakeMove(move, undo);
+    }
+
+    if (cache && nodes <= positionCache::payloadMask)
+    {
+        cache->store(key, nodes, depth);
+    }
+    return nodes;
+}
+
+// counts leaf nodes of the legal move tree, the standard check for move generation
+// usage: perft [-d depth] [-m hash megabytes, 0 for none] [fen]
+int main(int argc, char *argv[])
+{
+    int depth = 5;
+    size_t hashMegabytes = 64;
+    std::string fen = startPosition;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-d" && i + 1 < argc)
+        {
+            depth = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-m" && i + 1 < argc)
+        {
+            hashMegabytes = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        }
+        else
+        {
+            fen = arg;
+        }
+    }
+
+    chessBoard board;
+    if (!board.loadFEN(fen))
+    {
+        std::cerr << "Invalid FEN: " << fen << std::endl;
+        return 1;
+    }
+
+    positionCache cache(hashMegabytes ? hashMegabytes : 1);
+    for (int d = 1; d <= depth; d++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = perft(board, d, hashMegabytes ? &cache : nullptr);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "perft " << d << ": " << nodes << " nodes, " << seconds << " s ("
+                  << static_cast<uint64_t>(nodes / std::max(seconds, 1e-9)) << " nodes/s)\n";
+    }
+    return 0;
+}
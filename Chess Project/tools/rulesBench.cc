@@ -0,0 +1,457 @@
+#include "../header_files/chessBoard.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// every allocation in the process goes through here so that a benchmark can count its own
+static std::atomic<uint64_t> allocationCount{0};
+
+void *operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+// opening, middlegames with castling rights on both sides, endgames, a mate and a stalemate
+static const char *benchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r3k2r/pppq1ppp/2npbn2/2b1p3/2B1P3/2NPBN2/PPPQ1PPP/R3K2R b KQkq - 4 8",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "8/8/1p6/3b4/1P1k4/8/3K4/8 w - - 0 1",
+    "r1bqkb1r/pppp1Qpp/2n2n2/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b KQkq - 0 4",
+    "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1",
+};
+
+struct measurement
+{
+    uint64_t ops = 0;
+    double seconds = 0.0;
+    uint64_t allocations = 0;
+};
+
+// times one batch of work and counts the allocations it made, setup stays outside
+template <typename Work>
+static void measure(measurement &total, uint64_t ops, Work &&work)
+{
+    uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    work();
+    total.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    total.allocations += allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+    total.ops += ops;
+}
+
+struct benchmark
+{
+    std::string name;
+    // one pass over all positions, adding what it measured
+    std::function<void(measurement &)> pass;
+};
+
+static volatile int sink = 0;
+
+// calls too quick to time one at a time are timed as whole passes over all the positions,
+// this many inside one bracket, so that the two clock reads don't end up being most of
+// what ns/op shows
+static const int bracketRepeats = 32;
+
+// one call per position, isCheckmate and friends
+template <typename Call>
+static void measureGameState(measurement &total, std::vector<std::unique_ptr<chessBoard>> &boards, Call &&call)
+{
+    measure(total, boards.size() * bracketRepeats, [&]()
+            {
+                int result = 0;
+                for (int repeat = 0; repeat < bracketRepeats; repeat++)
+                {
+                    for (auto &board : boards)
+                    {
+                        result += call(*board);
+                    }
+                }
+                sink = sink + result; });
+}
+
+static std::vector<std::unique_ptr<chessBoard>> loadPositions()
+{
+    std::vector<std::unique_ptr<chessBoard>> boards;
+    for (const char *fen : benchPositions)
+    {
+        boards.push_back(std::make_unique<chessBoard>());
+        boards.back()->loadFEN(fen);
+    }
+    return boards;
+}
+
+static std::vector<benchmark> makeBenchmarks(std::vector<std::unique_ptr<chessBoard>> &boards)
+{
+    std::vector<benchmark> benchmarks;
+
+    // every start and end square for the side to move, legal or not
+    benchmarks.push_back({"isMoveValid", [&boards](measurement &total)
+                          {
+                              for (auto &board : boards)
+                              {
+                                  Color turn = board->getPlayerTurn();
+                                  measure(total, 64 * 64, [&]()
+                                          {
+                                              int valid = 0;
+                                              for (int from = 0; from < 64; from++)
+                                              {
+                                                  for (int to = 0; to < 64; to++)
+                                                  {
+                                                      valid += board->isMoveValid(from / 8, from % 8, to / 8, to % 8, turn);
+                                                  }
+                                              }
+                                              sink = sink + valid; });
+                              }
+                          }});
+
+    // castling moves only, these are the ones that go through isCastlingValid
+    benchmarks.push_back({"isCastlingValid", [&boards](measurement &total)
+                          {
+                              measure(total, 2 * boards.size() * bracketRepeats, [&]()
+                                      {
+                                          int valid = 0;
+                                          for (int repeat = 0; repeat < bracketRepeats; repeat++)
+                                          {
+                                              for (auto &board : boards)
+                                              {
+                                                  Color turn = board->getPlayerTurn();
+                                                  int row = turn == Color::WHITE ? 7 : 0;
+                                                  valid += board->isMoveValid(row, 4, row, 6, turn) + board->isMoveValid(row, 4, row, 2, turn);
+                                              }
+                                          }
+                                          sink = sink + valid; });
+                          }});
+
+    // every legal move on a fresh copy of its position, the copies are made outside the timing
+    benchmarks.push_back({"movePiece", [&boards](measurement &total)
+                          {
+                              std::vector<chessMove> moves;
+                              std::vector<std::unique_ptr<chessBoard>> copies;
+                              for (auto &board : boards)
+                              {
+                                  board->generateLegalMoves(moves);
+                                  std::string fen = board->toFEN();
+                                  while (copies.size() < moves.size())
+                                  {
+                                      copies.push_back(std::make_unique<chessBoard>());
+                                  }
+                                  for (size_t i = 0; i < moves.size(); i++)
+                                  {
+                                      copies[i]->loadFEN(fen);
+                                  }
+                                  measure(total, moves.size(), [&]()
+                                          {
+                                              for (size_t i = 0; i < moves.size(); i++)
+                                              {
+                                                  const chessMove &move = moves[i];
+                                                  pieceType promotion = move.isPromotion() ? move.promotion() : pieceType::QUEEN;
+                                                  sink = sink + copies[i]->movePiece(move.fromRow(), move.fromColumn(), move.toRow(), move.toColumn(), promotion);
+                                              } });
+                              }
+                          }});
+
+    benchmarks.push_back({"isCheckmate", [&boards](measurement &total)
+                          { measureGameState(total, boards, [](chessBoard &board)
+                                             { return board.isCheckmate(board.getPlayerTurn()); }); }});
+
+    benchmarks.push_back({"isStalemate", [&boards](measurement &total)
+                          { measureGameState(total, boards, [](chessBoard &board)
+                                             { return board.isStalemate(board.getPlayerTurn()); }); }});
+
+    benchmarks.push_back({"hasAnyValidMove", [&boards](measurement &total)
+                          { measureGameState(total, boards, [](chessBoard &board)
+                                             { return board.hasAnyValidMove(board.getPlayerTurn()); }); }});
+
+    // every square, attacked by the side not to move
+    benchmarks.push_back({"canEnemyPieceAttack", [&boards](measurement &total)
+                          {
+                              for (auto &board : boards)
+                              {
+                                  Color enemy = board->getPlayerTurn() == Color::WHITE ? Color::BLACK : Color::WHITE;
+                                  measure(total, 64, [&]()
+                                          {
+                                              int attacked = 0;
+                                              for (int square = 0; square < 64; square++)
+                                              {
+                                                  attacked += board->canEnemyPieceAttack(square / 8, square % 8, enemy);
+                                              }
+                                              sink = sink + attacked; });
+                              }
+                          }});
+
+    // SAN of every legal move, what the GUI history panel shows
+    benchmarks.push_back({"toSAN", [&boards](measurement &total)
+                          {
+                              std::vector<chessMove> moves;
+                              for (auto &board : boards)
+                              {
+                                  board->generateLegalMoves(moves);
+                                  measure(total, moves.size(), [&]()
+                                          {
+                                              size_t length = 0;
+                                              for (const chessMove &move : moves)
+                                              {
+                                                  length += board->toSAN(move).size();
+                                              }
+                                              sink = sink + static_cast<int>(length); });
+                              }
+                          }});
+    return benchmarks;
+}
+
+struct baselineEntry
+{
+    double nsPerOp = 0.0;
+    double allocsPerOp = 0.0;
+};
+
+static double numberAfter(const std::string &line, const std::string &key)
+{
+    size_t at = line.find("\"" + key + "\":");
+    return at == std::string::npos ? -1.0 : std::strtod(line.c_str() + at + key.size() + 3, nullptr);
+}
+
+// reads back the JSON this tool writes, one benchmark per line
+static bool loadBaseline(const std::string &path, std::map<std::string, baselineEntry> &baseline)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::cerr << "Could not open baseline " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line))
+    {
+        size_t at = line.find("\"name\": \"");
+        if (at == std::string::npos)
+        {
+            continue;
+        }
+        size_t begin = at + 9;
+        std::string name = line.substr(begin, line.find('"', begin) - begin);
+        baseline[name] = {numberAfter(line, "nsPerOp"), numberAfter(line, "allocsPerOp")};
+    }
+    return true;
+}
+
+static void usage()
+{
+    std::cerr << "usage: rulesBench [-min-time ms] [-runs n] [-filter name] [-o results.json] [-baseline file.json]\n"
+                 "                  [-threshold percent] [-advisory]"
+              << std::endl;
+}
+
+// measures the rules code the GUI calls on every click on a fixed set of positions:
+// ns/op, ops/s and heap allocations per call. the results can be written as JSON and the
+// same file given back as a baseline, any benchmark slower by more than the threshold
+// (or allocating more) is reported and makes the exit code 1, unless -advisory is given.
+// -runs repeats the whole set that many times and reports each benchmark's median run
+//
+// tools/rulesBench-baseline.json is the reference the rules-bench-check build target
+// compares against, the median of 7 runs of one Release build on an idle machine:
+//   rulesBench -min-time 1000 -runs 7 -o tools/rulesBench-baseline.json
+// timings only compare on the machine that wrote them, regenerate it there first
+int main(int argc, char *argv[])
+{
+    double minSeconds = 0.5;
+    double threshold = 10.0;
+    int runs = 1;
+    bool advisory = false;
+    std::string outputPath, baselinePath, filter;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-min-time" && hasValue)
+        {
+            minSeconds = std::max(1, std::atoi(argv[++i])) / 1000.0;
+        }
+        else if (arg == "-runs" && hasValue)
+        {
+            runs = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-advisory")
+        {
+            advisory = true;
+        }
+        else if (arg == "-filter" && hasValue)
+        {
+            filter = argv[++i];
+        }
+        else if (arg == "-o" && hasValue)
+        {
+            outputPath = argv[++i];
+        }
+        else if (arg == "-baseline" && hasValue)
+        {
+            baselinePath = argv[++i];
+        }
+        else if (arg == "-threshold" && hasValue)
+        {
+            threshold = std::atof(argv[++i]);
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    std::map<std::string, baselineEntry> baseline;
+    if (!baselinePath.empty() && !loadBaseline(baselinePath, baseline))
+    {
+        return 1;
+    }
+
+    auto boards = loadPositions();
+    std::vector<benchmark> benchmarks = makeBenchmarks(boards);
+    std::vector<std::pair<std::string, measurement>> results;
+    std::vector<std::vector<measurement>> runResults;
+    for (const benchmark &bench : benchmarks)
+    {
+        if (filter.empty() || bench.name.find(filter) != std::string::npos)
+        {
+            results.emplace_back(bench.name, measurement());
+        }
+    }
+    runResults.resize(results.size());
+
+    // every run goes over all benchmarks, so that a busy stretch on the machine costs each
+    // of them one run and not all runs of one
+    for (int run = 0; run < runs; run++)
+    {
+        size_t next = 0;
+        for (const benchmark &bench : benchmarks)
+        {
+            if (!filter.empty() && bench.name.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+            // one warm up pass, then rounds of whole passes; the fastest round is kept so
+            // that a busy moment does not show up as a regression
+            const int rounds = 5;
+            measurement best;
+            bench.pass(best);
+            best = measurement();
+            for (int round = 0; round < rounds; round++)
+            {
+                measurement total;
+                while (total.seconds < minSeconds / rounds)
+                {
+                    bench.pass(total);
+                }
+                if (round == 0 || total.seconds / total.ops < best.seconds / best.ops)
+                {
+                    best = total;
+                }
+            }
+            runResults[next++].push_back(best);
+        }
+    }
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        std::vector<measurement> &measured = runResults[i];
+        std::sort(measured.begin(), measured.end(), [](const measurement &a, const measurement &b)
+                  { return a.seconds / a.ops < b.seconds / b.ops; });
+        results[i].second = measured[measured.size() / 2];
+    }
+
+    bool regressed = false;
+    std::ostringstream json;
+    json << "{\n  \"benchmarks\": [\n";
+    std::cout << std::left << std::setw(22) << "benchmark" << std::right << std::setw(12) << "ns/op" << std::setw(14) << "ops/s"
+              << std::setw(12) << "allocs/op" << (baseline.empty() ? "" : "    vs baseline") << "\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const std::string &name = results[i].first;
+        const measurement &m = results[i].second;
+        double nsPerOp = m.seconds * 1e9 / m.ops;
+        double opsPerSec = m.ops / m.seconds;
+        double allocsPerOp = static_cast<double>(m.allocations) / m.ops;
+
+        std::cout << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(1) << std::setw(12)
+                  << nsPerOp << std::setprecision(0) << std::setw(14) << opsPerSec << std::setprecision(2) << std::setw(12)
+                  << allocsPerOp;
+        auto found = baseline.find(name);
+        if (found != baseline.end() && found->second.nsPerOp > 0.0)
+        {
+            double change = (nsPerOp / found->second.nsPerOp - 1.0) * 100.0;
+            bool slower = change > threshold;
+            bool moreAllocations = allocsPerOp > found->second.allocsPerOp + 0.005;
+            regressed = regressed || slower || moreAllocations;
+            std::cout << std::showpos << std::setprecision(1) << std::setw(10) << change << "%" << std::noshowpos
+                      << (slower ? "  SLOWER" : "") << (moreAllocations ? "  MORE ALLOCATIONS" : "");
+        }
+        std::cout << "\n";
+        std::cout.unsetf(std::ios::fixed);
+
+        json << "    {\"name\": \"" << name << "\", \"ops\": " << m.ops << ", \"nsPerOp\": " << std::fixed << std::setprecision(2)
+             << nsPerOp << ", \"opsPerSec\": " << std::setprecision(0) << opsPerSec << ", \"allocsPerOp\": " << std::setprecision(3)
+             << allocsPerOp << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+
+    if (!outputPath.empty())
+    {
+        std::ofstream out(outputPath);
+        if (!(out << json.str()))
+        {
+            std::cerr << "Could not write " << outputPath << std::endl;
+            return 1;
+        }
+    }
+    if (regressed)
+    {
+        std::cout << "Regressions against " << baselinePath << " (threshold " << std::defaultfloat << std::setprecision(6) << threshold
+                  << "%)" << (advisory ? ", advisory only" : "") << std::endl;
+    }
+    return regressed && !advisory ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+#include "../header_files/Search.h"
+#include "../header_files/chessBoard.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// fixed suite: opening, sharp middlegames and endgames
+static const char *benchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "6k1/5p2/6p1/8/7p/8/6PP/6K1 b - - 0 1",
+};
+
+// measures how the Lazy SMP search scales: time to reach a fixed depth and nodes per second
+// for each thread count on the same positions, the transposition table is cleared in between
+// usage: searchBench [-d depth] [-m hash megabytes] [-t 1,2,4,8,16]
+int main(int argc, char *argv[])
+{
+    int depth = 8;
+    size_t hashMegabytes = 64;
+    std::vector<int> threadCounts = {1, 2, 4, 8, 16};
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-d" && i + 1 < argc)
+        {
+            depth = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-m" && i + 1 < argc)
+        {
+            hashMegabytes = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "-t" && i + 1 < argc)
+        {
+            threadCounts.clear();
+            std::stringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ','))
+            {
+                threadCounts.push_back(std::max(1, std::atoi(item.c_str())));
+            }
+        }
+        else
+        {
+            std::cerr << "usage: searchBench [-d depth] [-m hash megabytes] [-t 1,2,4,8,16]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Depth " << depth << ", hash " << hashMegabytes << " MB, "
+              << std::thread::hardware_concurrency() << " hardware threads\n";
+    std::cout << std::left << std::setw(9) << "threads" << std::setw(14) << "time-to-depth" << std::setw(12) << "nodes"
+              << std::setw(12) << "knps" << std::setw(10) << "speedup" << "nps scaling\n";
+
+    double baseSeconds = 0.0;
+    double baseRate = 0.0;
+    for (int threadCount : threadCounts)
+    {
+        chessSearch search(hashMegabytes, threadCount);
+        searchLimits limits;
+        limits.maxDepth = depth;
+
+        double seconds = 0.0;
+        uint64_t nodes = 0;
+        for (const char *fen : benchPositions)
+        {
+            chessBoard board;
+            board.loadFEN(fen);
+            search.clear();
+            searchResult result = search.think(board, limits);
+            seconds += result.seconds;
+            nodes += result.nodes;
+        }
+
+        double rate = nodes / std::max(seconds, 1e-9);
+        if (baseSeconds == 0.0)
+        {
+            baseSeconds = seconds;
+            baseRate = rate;
+        }
+        std::cout << std::setw(9) << threadCount << std::setw(14) << std::fixed << std::setprecision(3) << seconds
+                  << std::setw(12) << nodes << std::setw(12) << static_cast<uint64_t>(rate / 1000)
+                  << std::setw(10) << std::setprecision(2) << baseSeconds / seconds << rate / baseRate << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include "../header_files/GameServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static bool sendAll(int socket, const void *data, size_t size)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    while (size > 0)
+    {
+        ssize_t sent = send(socket, bytes, size, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        bytes += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+static bool receiveAll(int socket, void *data, size_t size)
+{
+    uint8_t *bytes = static_cast<uint8_t *>(data);
+    while (size > 0)
+    {
+        ssize_t received = recv(socket, bytes, size, 0);
+        if (received <= 0)
+        {
+            return false;
+        }
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+// one request, one reply; payload receives the reply's payload
+static bool request(int socket, uint8_t type, uint32_t gameId, const void *payload, uint16_t length, messageHeader &reply,
+                    std::vector<uint8_t> &replyPayload)
+{
+    messageHeader header;
+    header.type = type;
+    header.length = length;
+    header.gameId = gameId;
+    std::vector<uint8_t> frame(sizeof(header) + length);
+    std::memcpy(frame.data(), &header, sizeof(header));
+    if (length)
+    {
+        std::memcpy(frame.data() + sizeof(header), payload, length);
+    }
+    if (!sendAll(socket, frame.data(), frame.size()) || !receiveAll(socket, &reply, sizeof(reply)))
+    {
+        return false;
+    }
+    replyPayload.resize(reply.length);
+    return reply.length == 0 || receiveAll(socket, replyPayload.data(), reply.length);
+}
+
+struct clientGame
+{
+    uint32_t id = 0;
+    std::unique_ptr<chessBoard> board;
+};
+
+// load test for gameServer: opens the given number of games at once and plays random legal
+// moves in all of them round robin, one request in flight, and reports the round trip times
+// usage: serverLoad [-socket path] [-games N] [-moves N]
+int main(int argc, char *argv[])
+{
+    std::string socketPath = "chess.sock";
+    size_t gameTotal = 10000;
+    size_t moveTotal = 200000;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-socket" && i + 1 < argc)
+        {
+            socketPath = argv[++i];
+        }
+        else if (arg == "-games" && i + 1 < argc)
+        {
+            gameTotal = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "-moves" && i + 1 < argc)
+        {
+            moveTotal = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            std::cerr << "usage: serverLoad [-socket path] [-games N] [-moves N]" << std::endl;
+            return 1;
+        }
+    }
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    if (server < 0 || connect(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        std::cerr << "Could not connect to " << socketPath << std::endl;
+        return 1;
+    }
+
+    messageHeader reply;
+    std::vector<uint8_t> payload;
+    auto createGame = [&](clientGame &game)
+    {
+        if (!request(server, MESSAGE_CREATE, 0, nullptr, 0, reply, payload) || reply.type != MESSAGE_STATE)
+        {
+            return false;
+        }
+        game.id = reply.gameId;
+        game.board = std::make_unique<chessBoard>();
+        return true;
+    };
+
+    std::vector<clientGame> games(gameTotal);
+    for (clientGame &game : games)
+    {
+        if (!createGame(game))
+        {
+            std::cerr << "Could not create a game" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(moveTotal);
+    std::vector<chessMove> legal;
+    uint64_t random = 0x9E3779B97F4A7C15ULL;
+    size_t finished = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t played = 0; played < moveTotal; played++)
+    {
+        clientGame &game = games[played % games.size()];
+        game.board->generateLegalMoves(legal);
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+        chessMove move = legal[random % legal.size()];
+
+        auto sent = std::chrono::steady_clock::now();
+        if (!request(server, MESSAGE_MOVE, game.id, &move.data, sizeof(move.data), reply, payload) || reply.type != MESSAGE_STATE)
+        {
+            std::cerr << "Move " << move.toString() << " in game " << game.id << " was refused" << std::endl;
+            return 1;
+        }
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent).count());
+        moveUndo undo;
+        game.board->makeMove(move, undo);
+
+        gameState state;
+        std::memcpy(&state, payload.data(), sizeof(state));
+        if (state.outcome != OUTCOME_ONGOING)
+        {
+            finished++;
+            if (!request(server, MESSAGE_CLOSE, game.id, nullptr, 0, reply, payload) || !createGame(game))
+            {
+                std::cerr << "Could not replace a finished game" << std::endl;
+                return 1;
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    close(server);
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p)
+    {
+        return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+    };
+    std::cout << gameTotal << " games open, " << latencies.size() << " moves (" << finished << " games finished) in "
+              << std::fixed << std::setprecision(2) << seconds << " s, " << std::setprecision(0)
+              << latencies.size() / seconds << " moves/s\n"
+              << "round trip us: p50 " << std::setprecision(1) << percentile(0.5) << ", p99 " << percentile(0.99)
+              << ", max " << (latencies.empty() ? 0.0 : latencies.back()) << std::endl;
+    return 0;
+}
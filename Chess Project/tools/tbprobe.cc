@@ -0,0 +1,113 @@
+#include "../header_files/Tablebase.h"
+#include "../header_files/chessBoard.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const char *wdlName(int wdl)
+{
+    switch (wdl)
+    {
+    case WDL_WIN:
+        return "win";
+    case WDL_CURSED_WIN:
+        return "cursed win";
+    case WDL_DRAW:
+        return "draw";
+    case WDL_BLESSED_LOSS:
+        return "blessed loss";
+    default:
+        return "loss";
+    }
+}
+
+// probes Syzygy tables for each FEN given on the command line (or one per line on stdin)
+// usage: tbprobe [-d directory] [-n iterations] [fen ...]
+//        tbprobe -check    checks the decoder's index tables, no files needed
+int main(int argc, char *argv[])
+{
+    std::string directory = "syzygy";
+    int iterations = 0;
+    std::vector<std::string> fens;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-d" && i + 1 < argc)
+        {
+            directory = argv[++i];
+        }
+        else if (arg == "-check")
+        {
+            bool passed = syzygyTablebases::instance().checkIndexing();
+            std::cout << (passed ? "Index check passed" : "Index check failed") << "\n";
+            return passed ? 0 : 1;
+        }
+        else if (arg == "-n" && i + 1 < argc)
+        {
+            iterations = std::max(0, std::atoi(argv[++i]));
+        }
+        else
+        {
+            fens.push_back(arg);
+        }
+    }
+    if (fens.empty())
+    {
+        std::string line;
+        while (std::getline(std::cin, line))
+        {
+            if (!line.empty())
+            {
+                fens.push_back(line);
+            }
+        }
+    }
+
+    syzygyTablebases &tablebases = syzygyTablebases::instance();
+    int found = tablebases.init(directory);
+    std::cout << "Found " << found << " WDL tables in " << directory << ", up to " << tablebases.maxPieces() << " pieces\n";
+    if (found == 0)
+    {
+        return 1;
+    }
+
+    int failures = 0;
+    for (const std::string &fen : fens)
+    {
+        chessBoard board;
+        if (!board.loadFEN(fen))
+        {
+            std::cerr << "Invalid FEN: " << fen << std::endl;
+            failures++;
+            continue;
+        }
+
+        chessMove best;
+        int wdl = 0;
+        int dtz = 0;
+        if (!tablebases.probeRoot(board, best, wdl, dtz))
+        {
+            std::cout << fen << ": not in tablebases\n";
+            failures++;
+            continue;
+        }
+        std::cout << fen << ": " << wdlName(wdl) << ", dtz " << dtz << ", best " << best.toString() << "\n";
+
+        // repeated WDL probes show the cost once the files are mapped
+        if (iterations > 0)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++)
+            {
+                tablebases.probeWDL(board, wdl);
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "  " << static_cast<uint64_t>(iterations / std::max(seconds, 1e-9)) << " WDL probes/s\n";
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,541 @@
+#include "../header_files/GameRules.h"
+#include "../header_files/Nnue.h"
+#include "../header_files/Search.h"
+#include "../header_files/chessBoard.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum gameResult
+{
+    WHITE_WINS,
+    DRAW,
+    BLACK_WINS
+};
+
+enum termination
+{
+    TERMINATION_MATE,
+    TERMINATION_STALEMATE,
+    TERMINATION_FIFTY_MOVES,
+    TERMINATION_REPETITION,
+    TERMINATION_MATERIAL,
+    TERMINATION_MAX_PLIES
+};
+
+static const char *terminationNames[] = {"checkmate", "stalemate", "fifty move rule", "threefold repetition",
+                                         "insufficient material", "adjudicated after the ply limit"};
+
+struct player
+{
+    std::string name;
+    std::unique_ptr<nnueNetwork> network; // nullptr plays with the built in evaluation
+};
+
+struct gameRecord
+{
+    int index = 0;
+    int opening = 0;
+    bool engineAWhite = true;
+    gameResult result = DRAW;
+    termination reason = TERMINATION_MAX_PLIES;
+    std::string startFen;
+    std::vector<chessMove> moves;
+    std::vector<std::string> san;
+};
+
+// wins, draws and losses of engine A, with the Elo and the log-likelihood ratio of a
+// sequential probability ratio test between elo0 (H0) and elo1 (H1) on the game scores
+struct matchStats
+{
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int games() const
+    {
+        return wins + draws + losses;
+    }
+    double score() const
+    {
+        return games() ? (wins + 0.5 * draws) / games() : 0.5;
+    }
+    double variance() const
+    {
+        double s = score();
+        int n = games();
+        if (n == 0)
+        {
+            return 0.0;
+        }
+        return (wins * (1.0 - s) * (1.0 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / n;
+    }
+
+    static double eloFromScore(double s)
+    {
+        s = std::min(std::max(s, 1e-6), 1.0 - 1e-6);
+        return 400.0 * std::log10(s / (1.0 - s));
+    }
+    static double scoreFromElo(double elo)
+    {
+        return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+    }
+
+    double elo() const
+    {
+        return eloFromScore(score());
+    }
+    // half width of the 95% confidence interval
+    double eloMargin() const
+    {
+        if (games() == 0)
+        {
+            return 0.0;
+        }
+        double deviation = std::sqrt(variance() / games());
+        return (eloFromScore(score() + 1.96 * deviation) - eloFromScore(score() - 1.96 * deviation)) / 2.0;
+    }
+    // normal approximation of the trinomial likelihood ratio
+    double llr(double elo0, double elo1) const
+    {
+        double var = variance();
+        if (games() == 0 || var <= 0.0)
+        {
+            return 0.0;
+        }
+        double s0 = scoreFromElo(elo0);
+        double s1 = scoreFromElo(elo1);
+        return games() * (s1 - s0) * (2.0 * score() - s0 - s1) / (2.0 * var);
+    }
+};
+
+static bool loadPlayer(const std::string &spec, player &out)
+{
+    out.name = spec;
+    if (spec == "builtin")
+    {
+        return true;
+    }
+    out.network = std::make_unique<nnueNetwork>();
+    if (!out.network->load(spec))
+    {
+        std::cerr << "Could not load network " << spec << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool loadOpenings(const std::string &path, std::vector<std::string> &openings)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line))
+    {
+        // FEN or EPD, opcodes after the fourth field are ignored by loadFEN's fallbacks
+        line = line.substr(0, line.find(';'));
+        chessBoard board;
+        if (!line.empty() && line[0] != '#' && board.loadFEN(line))
+        {
+            openings.push_back(board.toFEN());
+        }
+    }
+    return !openings.empty();
+}
+
+// without a book every pair of games starts from its own few random moves
+static void randomOpenings(int count, int plies, std::vector<std::string> &openings)
+{
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    while (static_cast<int>(openings.size()) < count)
+    {
+        chessBoard board;
+        board.loadFEN(startPosition);
+        if (playRandomOpening(board, plies, state))
+        {
+            openings.push_back(board.toFEN());
+        }
+    }
+}
+
+static void playGame(gameRecord &game, chessSearch &whiteSearch, chessSearch &blackSearch, const nnueNetwork *whiteNetwork,
+                     const nnueNetwork *blackNetwork, const searchLimits &limits, int maxPlies)
+{
+    chessBoard board;
+    board.loadFEN(game.startFen);
+    gameHistory history;
+    history.reset(board);
+    std::vector<chessMove> legal;
+
+    while (true)
+    {
+        adjudication ending = history.adjudicate(board, legal);
+        bool whiteToMove = board.getPlayerTurn() == Color::WHITE;
+        game.result = DRAW;
+        switch (ending)
+        {
+        case adjudication::CHECKMATE:
+            game.result = whiteToMove ? BLACK_WINS : WHITE_WINS;
+            game.reason = TERMINATION_MATE;
+            return;
+        case adjudication::STALEMATE:
+            game.reason = TERMINATION_STALEMATE;
+            return;
+        case adjudication::FIFTY_MOVES:
+            game.reason = TERMINATION_FIFTY_MOVES;
+            return;
+        case adjudication::REPETITION:
+            game.reason = TERMINATION_REPETITION;
+            return;
+        case adjudication::MATERIAL:
+            game.reason = TERMINATION_MATERIAL;
+            return;
+        case adjudication::ONGOING:
+            break;
+        }
+        if (static_cast<int>(game.moves.size()) >= maxPlies)
+        {
+            game.reason = TERMINATION_MAX_PLIES;
+            return;
+        }
+
+        board.attachNetwork(whiteToMove ? whiteNetwork : blackNetwork);
+        searchResult result = (whiteToMove ? whiteSearch : blackSearch).think(board, limits, history.positionKeys());
+        chessMove move = result.bestMove.isNull() ? legal[0] : result.bestMove;
+
+        game.san.push_back(board.toSAN(move));
+        game.moves.push_back(move);
+        moveUndo undo;
+        board.makeMove(move, undo);
+        history.record(board);
+    }
+}
+
+static void writePgn(std::ostream &out, const gameRecord &game, const std::string &white, const std::string &black)
+{
+    static const char *resultNames[] = {"1-0", "1/2-1/2", "0-1"};
+    out << "[Event \"Self-play match\"]\n";
+    out << "[Round \"" << game.index + 1 << "\"]\n";
+    out << "[White \"" << white << "\"]\n";
+    out << "[Black \"" << black << "\"]\n";
+    out << "[Result \"" << resultNames[game.result] << "\"]\n";
+    out << "[FEN \"" << game.startFen << "\"]\n";
+    out << "[SetUp \"1\"]\n";
+    out << "[PlyCount \"" << game.moves.size() << "\"]\n";
+    out << "[Termination \"" << terminationNames[game.reason] << "\"]\n\n";
+
+    chessBoard board;
+    board.loadFEN(game.startFen);
+    int moveNumber = board.fullmoveNumber;
+    bool whiteToMove = board.getPlayerTurn() == Color::WHITE;
+    std::string line;
+    for (size_t i = 0; i < game.san.size(); i++)
+    {
+        std::string token;
+        if (whiteToMove)
+        {
+            token = std::to_string(moveNumber) + ". ";
+        }
+        else if (i == 0)
+        {
+            token = std::to_string(moveNumber) + "... ";
+        }
+        token += game.san[i];
+        if (line.size() + token.size() > 79)
+        {
+            out << line << "\n";
+            line.clear();
+        }
+        line += (line.empty() ? "" : " ") + token;
+        if (!whiteToMove)
+        {
+            moveNumber++;
+        }
+        whiteToMove = !whiteToMove;
+    }
+    out << line << (line.empty() ? "" : " ") << resultNames[game.result] << "\n\n";
+}
+
+// compact record per game: index, opening, flags, result, termination, start FEN and the 16 bit moves
+static void writeBinary(std::ostream &out, const gameRecord &game)
+{
+    uint32_t index = static_cast<uint32_t>(game.index);
+    uint32_t opening = static_cast<uint32_t>(game.opening);
+    uint8_t header[3] = {static_cast<uint8_t>(game.engineAWhite ? 1 : 0), static_cast<uint8_t>(game.result),
+                         static_cast<uint8_t>(game.reason)};
+    uint16_t fenLength = static_cast<uint16_t>(game.startFen.size());
+    uint16_t plies = static_cast<uint16_t>(game.moves.size());
+    out.write(reinterpret_cast<const char *>(&index), sizeof(index));
+    out.write(reinterpret_cast<const char *>(&opening), sizeof(opening));
+    out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(&fenLength), sizeof(fenLength));
+    out.write(game.startFen.data(), fenLength);
+    out.write(reinterpret_cast<const char *>(&plies), sizeof(plies));
+    for (const chessMove &move : game.moves)
+    {
+        out.write(reinterpret_cast<const char *>(&move.data), sizeof(move.data));
+    }
+    out.flush();
+}
+
+static void usage()
+{
+    std::cerr << "usage: tournament [-a builtin|network] [-b builtin|network] [-games N] [-concurrency N]\n"
+                 "                  [-openings file] [-random-plies N] [-nodes N] [-movetime ms] [-depth D]\n"
+                 "                  [-hash MB] [-max-plies N] [-sprt elo0 elo1] [-alpha a] [-beta b]\n"
+                 "                  [-pgn file] [-log file]"
+              << std::endl;
+}
+
+// plays engine A against engine B, every opening once with each colour, one game per thread
+// and prints the running score, Elo and SPRT state after every game. the two engines differ
+// in their evaluation: the built in one or an NNUE network file for each side
+int main(int argc, char *argv[])
+{
+    std::string specA = "builtin", specB = "builtin";
+    std::string openingsPath, pgnPath, logPath;
+    int games = 100;
+    int concurrency = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    int randomPlies = 6;
+    int maxPlies = 400;
+    size_t hashMegabytes = 16;
+    searchLimits limits;
+    limits.maxNodes = 20000;
+    bool useSprt = false;
+    double elo0 = 0.0, elo1 = 5.0, alpha = 0.05, beta = 0.05;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-a" && hasValue)
+        {
+            specA = argv[++i];
+        }
+        else if (arg == "-b" && hasValue)
+        {
+            specB = argv[++i];
+        }
+        else if (arg == "-games" && hasValue)
+        {
+            games = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-concurrency" && hasValue)
+        {
+            concurrency = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-openings" && hasValue)
+        {
+            openingsPath = argv[++i];
+        }
+        else if (arg == "-random-plies" && hasValue)
+        {
+            randomPlies = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "-nodes" && hasValue)
+        {
+            limits.maxNodes = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-movetime" && hasValue)
+        {
+            limits.moveTimeMs = std::atoi(argv[++i]);
+            limits.maxNodes = 0;
+        }
+        else if (arg == "-depth" && hasValue)
+        {
+            limits.maxDepth = std::max(1, std::atoi(argv[++i]));
+            limits.maxNodes = 0;
+        }
+        else if (arg == "-hash" && hasValue)
+        {
+            hashMegabytes = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "-max-plies" && hasValue)
+        {
+            maxPlies = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-sprt" && i + 2 < argc)
+        {
+            useSprt = true;
+            elo0 = std::atof(argv[++i]);
+            elo1 = std::atof(argv[++i]);
+        }
+        else if (arg == "-alpha" && hasValue)
+        {
+            alpha = std::atof(argv[++i]);
+        }
+        else if (arg == "-beta" && hasValue)
+        {
+            beta = std::atof(argv[++i]);
+        }
+        else if (arg == "-pgn" && hasValue)
+        {
+            pgnPath = argv[++i];
+        }
+        else if (arg == "-log" && hasValue)
+        {
+            logPath = argv[++i];
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    player engineA, engineB;
+    if (!loadPlayer(specA, engineA) || !loadPlayer(specB, engineB))
+    {
+        return 1;
+    }
+    std::vector<std::string> openings;
+    if (!openingsPath.empty())
+    {
+        if (!loadOpenings(openingsPath, openings))
+        {
+            std::cerr << "No usable openings in " << openingsPath << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        randomOpenings((games + 1) / 2, randomPlies, openings);
+    }
+
+    std::ofstream pgn, log;
+    if (!pgnPath.empty())
+    {
+        pgn.open(pgnPath);
+        if (!pgn)
+        {
+            std::cerr << "Could not write " << pgnPath << std::endl;
+            return 1;
+        }
+    }
+    if (!logPath.empty())
+    {
+        log.open(logPath, std::ios::binary);
+        if (!log)
+        {
+            std::cerr << "Could not write " << logPath << std::endl;
+            return 1;
+        }
+        log.write("CGL1", 4);
+    }
+
+    double lowerBound = std::log(beta / (1.0 - alpha));
+    double upperBound = std::log((1.0 - beta) / alpha);
+    std::cout << engineA.name << " vs " << engineB.name << ": " << games << " games, " << concurrency << " threads, "
+              << openings.size() << " openings\n";
+
+    matchStats stats;
+    std::mutex statsMutex;
+    std::atomic<int> nextGame{0};
+    std::atomic<bool> finished{false};
+    std::string verdict;
+
+    auto worker = [&]()
+    {
+        chessSearch searchA(hashMegabytes, 1);
+        chessSearch searchB(hashMegabytes, 1);
+        while (!finished.load(std::memory_order_relaxed))
+        {
+            int index = nextGame.fetch_add(1);
+            if (index >= games)
+            {
+                break;
+            }
+            // game pairs: the same opening with colours swapped
+            gameRecord game;
+            game.index = index;
+            game.opening = (index / 2) % static_cast<int>(openings.size());
+            game.engineAWhite = index % 2 == 0;
+            game.startFen = openings[game.opening];
+            searchA.clear();
+            searchB.clear();
+            if (game.engineAWhite)
+            {
+                playGame(game, searchA, searchB, engineA.network.get(), engineB.network.get(), limits, maxPlies);
+            }
+            else
+            {
+                playGame(game, searchB, searchA, engineB.network.get(), engineA.network.get(), limits, maxPlies);
+            }
+
+            std::lock_guard<std::mutex> lock(statsMutex);
+            if (finished.load(std::memory_order_relaxed))
+            {
+                break;
+            }
+            bool aWon = game.result == (game.engineAWhite ? WHITE_WINS : BLACK_WINS);
+            bool aLost = game.result == (game.engineAWhite ? BLACK_WINS : WHITE_WINS);
+            stats.wins += aWon ? 1 : 0;
+            stats.losses += aLost ? 1 : 0;
+            stats.draws += game.result == DRAW ? 1 : 0;
+
+            const std::string &white = game.engineAWhite ? engineA.name : engineB.name;
+            const std::string &black = game.engineAWhite ? engineB.name : engineA.name;
+            if (pgn.is_open())
+            {
+                writePgn(pgn, game, white, black);
+                pgn.flush();
+            }
+            if (log.is_open())
+            {
+                writeBinary(log, game);
+            }
+
+            std::cout << "Game " << std::setw(5) << game.index + 1 << ": " << (aWon ? "A wins" : aLost ? "B wins" : "draw  ")
+                      << " (" << terminationNames[game.reason] << ", " << game.moves.size() << " plies)  "
+                      << "+" << stats.wins << " =" << stats.draws << " -" << stats.losses << "  Elo " << std::fixed
+                      << std::setprecision(1) << stats.elo() << " +- " << stats.eloMargin();
+            if (useSprt)
+            {
+                double llr = stats.llr(elo0, elo1);
+                std::cout << "  LLR " << std::setprecision(2) << llr << " [" << lowerBound << ", " << upperBound << "]";
+                if (llr >= upperBound || llr <= lowerBound)
+                {
+                    verdict = llr >= upperBound ? "H1 accepted: A is stronger by at least " + std::to_string(elo1) + " Elo"
+                                                : "H0 accepted: A is not stronger by " + std::to_string(elo1) + " Elo";
+                    finished.store(true, std::memory_order_relaxed);
+                }
+            }
+            std::cout << std::endl;
+            std::cout.unsetf(std::ios::fixed);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < concurrency; i++)
+    {
+        threads.emplace_back(worker);
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    std::cout << "\nScore of " << engineA.name << " vs " << engineB.name << ": " << stats.wins << " - " << stats.losses
+              << " - " << stats.draws << " [" << std::fixed << std::setprecision(3) << stats.score() << "] " << stats.games()
+              << " games\nElo difference: " << std::setprecision(1) << stats.elo() << " +- " << stats.eloMargin() << "\n";
+    if (useSprt)
+    {
+        std::cout << "SPRT (" << elo0 << ", " << elo1 << "): " << (verdict.empty() ? "no decision yet" : verdict) << "\n";
+    }
+    return 0;
+}
@@ -15,6 +15,7 @@ private:
     int winningPatternIndex = -1;
     bool isDraw = false;
     std::string resultMessage;
+    bool needsRedraw = true;
 
 public:
     Game() {
@@ -23,25 +24,36 @@ public:
         if (!font.loadFromFile("arial.ttf")) {
             std::cout << "Failed to load font!\n";
         }
+        window.setFramerateLimit(60);
     }
 
+    // nothing moves on its own, so the board is only drawn again after a move
     void run() {
         while (window.isOpen()) {
+            if (needsRedraw) {
+                draw();
+                needsRedraw = false;
+            }
             handleEvents();
-            draw();
         }
     }
 
 private:
+    // sleeps until the next event, then takes whatever else is queued
     void handleEvents() {
         sf::Event event;
-        while (window.pollEvent(event)) {
+        if (!window.waitEvent(event))
+            return;
+        do {
             if (event.type == sf::Event::Closed)
                 window.close();
 
             if (!gameWon && event.type == sf::Event::MouseButtonPressed)
                 handleClick(event.mouseButton.x, event.mouseButton.y);
-        }
+
+            if (event.type == sf::Event::Resized || event.type == sf::Event::GainedFocus)
+                needsRedraw = true;
+        } while (window.pollEvent(event));
     }
 
     void handleClick(int x, int y) {
@@ -50,6 +62,7 @@ private:
         int index = row * 3 + col;
 
         if (board[index] == ' ') {
+            needsRedraw = true;
             board[index] = isPlayerXTurn ? 'X' : 'O';
             isPlayerXTurn = !isPlayerXTurn;
 
@@ -29,12 +29,29 @@ int main() {
     title.setFillColor(sf::Color::Black);
     title.setPosition(180.f, 30.f);
 
+    // the menu never changes, it is drawn once and again only when the window asks for it.
+    // in between the loop sleeps in waitEvent
+    bool needsRedraw = true;
     while (window.isOpen()) {
+        if (needsRedraw) {
+            window.clear(sf::Color(240, 240, 240));
+            window.draw(title);
+            window.draw(chessButton);
+            window.draw(tttButton);
+            window.display();
+            needsRedraw = false;
+        }
+
         sf::Event event;
-        while (window.pollEvent(event)) {
+        if (!window.waitEvent(event))
+            continue;
+        do {
             if (event.type == sf::Event::Closed)
                 window.close();
 
+            if (event.type == sf::Event::Resized || event.type == sf::Event::GainedFocus)
+                needsRedraw = true;
+
             if (event.type == sf::Event::MouseButtonPressed &&
                 event.mouseButton.button == sf::Mouse::Left)
             {
@@ -44,13 +61,7 @@ int main() {
                 else if (tttButton.getGlobalBounds().contains(mousePos))
                     launchGame("Tictactoe Project", "Tictactoe.exe");
             }
-        }
-
-        window.clear(sf::Color(240, 240, 240));
-        window.draw(title);
-        window.draw(chessButton);
-        window.draw(tttButton);
-        window.display();
+        } while (window.pollEvent(event));
     }
 
     return 0;